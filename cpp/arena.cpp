@@ -0,0 +1,72 @@
+#include "arena.h"
+
+Arena::~Arena() {
+    runDestructors();
+    releaseBlocks(0);
+}
+
+Arena::Arena(Arena &&other) noexcept
+    : blocks(std::move(other.blocks)), cursor(other.cursor), limit(other.limit),
+      blockSize(other.blockSize), used(other.used), destructors(other.destructors) {
+    other.blocks.clear();
+    other.cursor = other.limit = nullptr;
+    other.used = 0;
+    other.destructors = nullptr;
+}
+
+Arena &Arena::operator=(Arena &&other) noexcept {
+    if (this != &other) {
+        runDestructors();
+        releaseBlocks(0);
+        blocks = std::move(other.blocks);
+        cursor = other.cursor;
+        limit = other.limit;
+        blockSize = other.blockSize;
+        used = other.used;
+        destructors = other.destructors;
+        other.blocks.clear();
+        other.cursor = other.limit = nullptr;
+        other.used = 0;
+        other.destructors = nullptr;
+    }
+    return *this;
+}
+
+void *Arena::allocateSlow(size_t size, size_t align) {
+    // Oversized requests get a block of their own so that a single large
+    // allocation does not waste the remainder of a regular block.
+    size_t needed = size + align;
+    size_t capacity = needed > blockSize ? needed : blockSize;
+    char *block = static_cast<char *>(::operator new(capacity));
+    blocks.push_back(block);
+    cursor = block;
+    limit = block + capacity;
+    return allocate(size, align);
+}
+
+void Arena::runDestructors() {
+    for (Destructor *d = destructors; d; d = d->next) {
+        d->destroy(d->object);
+    }
+    destructors = nullptr;
+}
+
+void Arena::releaseBlocks(size_t keep) {
+    while (blocks.size() > keep) {
+        ::operator delete(blocks.back());
+        blocks.pop_back();
+    }
+}
+
+void Arena::reset() {
+    runDestructors();
+    // Only the first block is guaranteed to be regular sized; keep it.
+    releaseBlocks(blocks.empty() ? 0 : 1);
+    if (!blocks.empty()) {
+        cursor = blocks.front();
+        limit = cursor + blockSize;
+    } else {
+        cursor = limit = nullptr;
+    }
+    used = 0;
+}
@@ -0,0 +1,76 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include<cstddef>
+#include<cstdint>
+#include<new>
+#include<type_traits>
+#include<utility>
+#include<vector>
+
+// Bump allocator that hands out memory from a list of large blocks.
+// Everything allocated from an arena is released at once when the arena
+// is reset or destroyed; individual objects are never freed.
+class Arena {
+    // Destructors of non-trivial objects are recorded in the arena itself,
+    // so registering them does not touch the heap either.
+    struct Destructor {
+        void (*destroy)(void *);
+        void *object;
+        Destructor *next;
+    };
+
+    std::vector<char *> blocks;
+    char *cursor = nullptr;
+    char *limit = nullptr;
+    size_t blockSize;
+    size_t used = 0;
+    Destructor *destructors = nullptr;
+
+    void *allocateSlow(size_t size, size_t align);
+    void runDestructors();
+    void releaseBlocks(size_t keep);
+
+public:
+    static constexpr size_t kDefaultBlockSize = 4096;
+
+    explicit Arena(size_t blockSize = kDefaultBlockSize) : blockSize(blockSize) {}
+    ~Arena();
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    Arena(Arena &&other) noexcept;
+    Arena &operator=(Arena &&other) noexcept;
+
+    void *allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        uintptr_t p = reinterpret_cast<uintptr_t>(cursor);
+        uintptr_t aligned = (p + align - 1) & ~(uintptr_t)(align - 1);
+        if (cursor && aligned + size <= reinterpret_cast<uintptr_t>(limit)) {
+            cursor = reinterpret_cast<char *>(aligned + size);
+            used += size;
+            return reinterpret_cast<void *>(aligned);
+        }
+        return allocateSlow(size, align);
+    }
+
+    template<typename T, typename... Args>
+    T *create(Args&&... args) {
+        T *obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value) {
+            auto *d = static_cast<Destructor *>(allocate(sizeof(Destructor), alignof(Destructor)));
+            d->destroy = [](void *p) { static_cast<T *>(p)->~T(); };
+            d->object = obj;
+            d->next = destructors;
+            destructors = d;
+        }
+        return obj;
+    }
+
+    // Destroys every object and rewinds to the first block, keeping it
+    // around so a reused arena does not go back to the heap.
+    void reset();
+
+    size_t bytesUsed() const { return used; }
+    size_t blockCount() const { return blocks.size(); }
+};
+
+#endif  // ARENA_H_
@@ -1,15 +1,102 @@
 #include "ast.h"
+#include "functions.h"
+#include "small_stack.h"
 
 void ASTPrinter::visitNumberNode(const NumberNode *expr) {
-    os << expr->getValue();
+    expr->print(os);
 }
 
 void ASTPrinter::visitBinaryNode(const BinaryNode *expr) {
-    os << "(" << expr->getOperator() << " ";
-    expr->left->accept(this);
-    os << " ";
-    expr->right->accept(this);
-    os << ")";
+    printTree(expr);
+}
+
+void ASTPrinter::visitUnaryFunctionNode(const UnaryFunctionNode *expr) {
+    printTree(expr);
+}
+
+void ASTPrinter::printTree(const IExpression *expr) {
+    // Iterative so that very deep trees print in bounded native stack;
+    // each entry is either a subtree to print or a character to emit.
+    struct Item {
+        const IExpression *node;
+        char text;
+    };
+    SmallStack<Item, 32> stack;
+    stack.push({expr, 0});
+    while (!stack.empty()) {
+        Item item = stack.top();
+        stack.pop();
+        if (!item.node) {
+            os << item.text;
+        } else if (const BinaryNode *binary = item.node->asBinary()) {
+            os << "(" << binary->getOperator() << " ";
+            stack.push({nullptr, ')'});
+            stack.push({binary->right, 0});
+            stack.push({nullptr, ' '});
+            stack.push({binary->left, 0});
+        } else if (const UnaryFunctionNode *unary = item.node->asUnary()) {
+            os << "(" << unary->getName() << " ";
+            stack.push({nullptr, ')'});
+            stack.push({unary->arg, 0});
+        } else {
+            item.node->accept(this);
+        }
+    }
+}
+
+void ASTPrinter::visitVariableNode(const VariableNode *expr) {
+    os << expr->getName();
+}
+
+void ASTPrinter::printFlat(const FlatTree &tree, uint32_t index) {
+    // Same scheme as visitBinaryNode, over node indices.
+    struct Item {
+        uint32_t index;
+        char text;
+    };
+    SmallStack<Item, 32> stack;
+    stack.push({index, 0});
+    while (!stack.empty()) {
+        Item item = stack.top();
+        stack.pop();
+        if (item.text) {
+            os << item.text;
+            continue;
+        }
+        const FlatNode &node = tree.data()[item.index];
+        char op;
+        switch (node.op) {
+        case FlatOp::NUMBER:
+            os << node.immediate;
+            continue;
+        case FlatOp::VARIABLE:
+            os << tree.variableTable()->name(static_cast<size_t>(node.immediate));
+            continue;
+        case FlatOp::ADD: op = '+'; break;
+        case FlatOp::SUB: op = '-'; break;
+        case FlatOp::MUL: op = '*'; break;
+        case FlatOp::DIV: op = '/'; break;
+        case FlatOp::SQRT:
+        case FlatOp::ABS:
+        case FlatOp::SIN:
+        case FlatOp::COS:
+            os << "(" << functionInfo(toOperator(node.op)).name << " ";
+            stack.push({0, ')'});
+            stack.push({node.left, 0});
+            continue;
+        default: op = '?'; break;
+        }
+        os << "(" << op << " ";
+        stack.push({0, ')'});
+        stack.push({node.right, 0});
+        stack.push({0, ' '});
+        stack.push({node.left, 0});
+    }
+}
+
+void ASTPrinter::print(const FlatTree &tree) {
+    if (!tree.empty()) printFlat(tree, tree.root());
+    os << std::endl;
 }
 
 void ASTPrinter::print(const IExpression *expr) {
@@ -5,6 +5,7 @@
 
 #include "visitor.h"
 #include "expression.h"
+#include "flat_tree.h"
 
 class ASTPrinter : public IVisitor {
     std::ostream &os;
@@ -12,7 +13,14 @@ public:
     ASTPrinter(std::ostream &os) : os(os) {}
     void visitNumberNode(const NumberNode *expr);
     void visitBinaryNode(const BinaryNode *expr);
+    void visitVariableNode(const VariableNode *expr);
+    void visitUnaryFunctionNode(const UnaryFunctionNode *expr);
     void print(const IExpression *expr);
+    // Same output for the flat representation, without virtual dispatch.
+    void print(const FlatTree &tree);
+private:
+    void printTree(const IExpression *expr);
+    void printFlat(const FlatTree &tree, uint32_t index);
 };
 
 #endif // AST_H_
@@ -0,0 +1,307 @@
+#include <algorithm>
+
+#include "batch.h"
+#include "functions.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Rows per chunk: small enough for every stack slot to stay in L1/L2.
+constexpr size_t kChunk = 512;
+
+// Scalar kernels, also used for the tails of the vector loops.
+
+void addScalar(const int64_t *a, const int64_t *b, int64_t *out, size_t i, size_t n) {
+    for (; i < n; ++i) out[i] = wrappingAdd(a[i], b[i]);
+}
+
+void subScalar(const int64_t *a, const int64_t *b, int64_t *out, size_t i, size_t n) {
+    for (; i < n; ++i) out[i] = wrappingSub(a[i], b[i]);
+}
+
+void mulScalar(const int64_t *a, const int64_t *b, int64_t *out, size_t i, size_t n) {
+    for (; i < n; ++i) out[i] = wrappingMul(a[i], b[i]);
+}
+
+size_t findZeroScalar(const int64_t *v, size_t i, size_t n) {
+    for (; i < n; ++i) {
+        if (v[i] == 0) return i;
+    }
+    return n;
+}
+
+#ifdef BATCH_X86
+
+// SSE2 is part of the x86-64 baseline, so these need no dispatch.
+
+void addSSE2(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_add_epi64(x, y));
+    }
+    addScalar(a, b, out, i, n);
+}
+
+void subSSE2(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_sub_epi64(x, y));
+    }
+    subScalar(a, b, out, i, n);
+}
+
+// Low 64 bits of a 64x64 product from 32x32->64 multiplies:
+// a*b = alo*blo + ((ahi*blo + alo*bhi) << 32)  (mod 2^64)
+void mulSSE2(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        __m128i lo = _mm_mul_epu32(x, y);
+        __m128i cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(x, 32), y),
+                                      _mm_mul_epu32(x, _mm_srli_epi64(y, 32)));
+        __m128i r = _mm_add_epi64(lo, _mm_slli_epi64(cross, 32));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), r);
+    }
+    mulScalar(a, b, out, i, n);
+}
+
+size_t findZeroSSE2(const int64_t *v, size_t n) {
+    size_t i = 0;
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 2 <= n; i += 2) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + i));
+        // A 64-bit lane is zero when both of its 32-bit halves are.
+        __m128i eq = _mm_cmpeq_epi32(x, zero);
+        eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+        int mask = _mm_movemask_pd(_mm_castsi128_pd(eq));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return findZeroScalar(v, i, n);
+}
+
+__attribute__((target("avx2")))
+void addAVX2(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_add_epi64(x, y));
+    }
+    addScalar(a, b, out, i, n);
+}
+
+__attribute__((target("avx2")))
+void subAVX2(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_sub_epi64(x, y));
+    }
+    subScalar(a, b, out, i, n);
+}
+
+__attribute__((target("avx2")))
+void mulAVX2(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        __m256i lo = _mm256_mul_epu32(x, y);
+        __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), y),
+                                         _mm256_mul_epu32(x, _mm256_srli_epi64(y, 32)));
+        __m256i r = _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), r);
+    }
+    mulScalar(a, b, out, i, n);
+}
+
+__attribute__((target("avx2")))
+size_t findZeroAVX2(const int64_t *v, size_t n) {
+    size_t i = 0;
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v + i));
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, zero)));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return findZeroScalar(v, i, n);
+}
+
+const bool hasAVX2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+}();
+
+#endif  // BATCH_X86
+
+void add(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+#ifdef BATCH_X86
+    if (hasAVX2) return addAVX2(a, b, out, n);
+    return addSSE2(a, b, out, n);
+#else
+    addScalar(a, b, out, 0, n);
+#endif
+}
+
+void sub(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+#ifdef BATCH_X86
+    if (hasAVX2) return subAVX2(a, b, out, n);
+    return subSSE2(a, b, out, n);
+#else
+    subScalar(a, b, out, 0, n);
+#endif
+}
+
+void mul(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+#ifdef BATCH_X86
+    if (hasAVX2) return mulAVX2(a, b, out, n);
+    return mulSSE2(a, b, out, n);
+#else
+    mulScalar(a, b, out, 0, n);
+#endif
+}
+
+size_t findZero(const int64_t *v, size_t n) {
+#ifdef BATCH_X86
+    if (hasAVX2) return findZeroAVX2(v, n);
+    return findZeroSSE2(v, n);
+#else
+    return findZeroScalar(v, 0, n);
+#endif
+}
+
+// Neither SSE nor AVX2 has integer division, so once the divisors are
+// known to be non-zero this is a plain loop. It stops at INT64_MIN / -1,
+// which would trap.
+size_t divide(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+    size_t limit = findZero(b, n);
+    for (size_t i = 0; i < limit; ++i) {
+        if (b[i] == -1 && a[i] == INT64_MIN) return i;
+        out[i] = a[i] / b[i];
+    }
+    return limit;
+}
+
+Operator toOperator(OpCode op) {
+    switch (op) {
+    case OpCode::ADD: return Operator::ADD;
+    case OpCode::SUB: return Operator::SUB;
+    case OpCode::MUL: return Operator::MUL;
+    case OpCode::DIV: return Operator::DIV;
+    default:
+        throw std::runtime_error("Unknown operator");
+    }
+}
+
+}  // namespace
+
+size_t batchApply(Operator op, const int64_t *lhs, const int64_t *rhs, int64_t *out, size_t n) {
+    switch (op) {
+    case Operator::ADD: add(lhs, rhs, out, n); return n;
+    case Operator::SUB: sub(lhs, rhs, out, n); return n;
+    case Operator::MUL: mul(lhs, rhs, out, n); return n;
+    case Operator::DIV: return divide(lhs, rhs, out, n);
+    default:
+        throw std::runtime_error("Unknown operator");
+    }
+}
+
+void checkBatchColumns(const Program &program, const std::vector<ColumnView> &columns,
+                       size_t rows) {
+    if (program.variableCount() > columns.size()) {
+        throw std::invalid_argument("Missing input column");
+    }
+    for (const ColumnView &column : columns) {
+        if (column.size < rows) throw std::invalid_argument("Input column too short");
+    }
+}
+
+void evaluateBatch(const Program &program, const std::vector<ColumnView> &columns,
+                   size_t rows, int64_t *out) {
+    if (program.empty()) {
+        throw std::runtime_error("Malformed program");
+    }
+    checkBatchColumns(program, columns, rows);
+
+    const auto &code = program.instructions();
+
+    // Constants are broadcast into a chunk-sized buffer once up front;
+    // every instruction then runs the same vector-vector kernel.
+    std::vector<int64_t> constants;
+    std::vector<size_t> constantOffset(code.size());
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        if (code[pc].op == OpCode::PUSH) {
+            constantOffset[pc] = constants.size();
+            constants.insert(constants.end(), kChunk, code[pc].operand);
+        }
+    }
+
+    // One scratch column per stack slot; a slot that holds a constant or an
+    // input column points straight at it instead of copying.
+    std::vector<int64_t> scratch(program.stackDepth() * kChunk);
+    std::vector<const int64_t *> stack(program.stackDepth());
+
+    for (size_t start = 0; start < rows; start += kChunk) {
+        size_t n = std::min(kChunk, rows - start);
+        size_t active = n;
+        // Instruction that cut active short last, i.e. the one that failed
+        // on the lowest row, and for a division whether it overflowed.
+        const Instruction *failed = nullptr;
+        bool overflow = false;
+        size_t sp = 0;
+        for (size_t pc = 0; pc < code.size(); ++pc) {
+            const Instruction &ins = code[pc];
+            switch (ins.op) {
+            case OpCode::PUSH:
+                stack[sp++] = constants.data() + constantOffset[pc];
+                break;
+            case OpCode::LOAD:
+                stack[sp++] = columns[ins.operand].data + start;
+                break;
+            case OpCode::CALL: {
+                int64_t *dst = scratch.data() + (sp - 1) * kChunk;
+                const FunctionInfo &function = functionInfo(static_cast<Operator>(ins.operand));
+                size_t valid = function.batch(stack[sp - 1], dst, active);
+                if (valid < active) {
+                    active = valid;
+                    failed = &ins;
+                }
+                stack[sp - 1] = dst;
+                break;
+            }
+            default: {
+                --sp;
+                int64_t *dst = scratch.data() + (sp - 1) * kChunk;
+                // Rows past the first failure are dead; stop computing them.
+                size_t valid = batchApply(toOperator(ins.op), stack[sp - 1], stack[sp], dst, active);
+                if (valid < active) {
+                    active = valid;
+                    failed = &ins;
+                    overflow = stack[sp][valid] != 0;
+                }
+                stack[sp - 1] = dst;
+                break;
+            }
+            }
+        }
+        if (active < n) {
+            if (failed->op == OpCode::CALL) {
+                const FunctionInfo &function = functionInfo(static_cast<Operator>(failed->operand));
+                throw DomainError(std::string("Invalid argument to ") + function.name, start + active);
+            }
+            if (overflow) throw DivideOverflowError(start + active);
+            throw DivideByZeroError(start + active);
+        }
+        std::copy(stack[0], stack[0] + n, out + start);
+    }
+}
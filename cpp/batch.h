@@ -0,0 +1,68 @@
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include<cstdint>
+#include<stdexcept>
+#include<string>
+#include<vector>
+
+#include "bytecode.h"
+
+// Read-only view of one input column.
+struct ColumnView {
+    const int64_t *data;
+    size_t size;
+};
+
+// Evaluation failure of one row; reason() is the message the scalar
+// evaluators would throw for it.
+class RowError : public std::runtime_error {
+    size_t failingRow;
+    std::string why;
+public:
+    RowError(const std::string &reason, size_t row)
+        : std::runtime_error(reason + " at row " + std::to_string(row)),
+          failingRow(row), why(reason) {}
+    size_t row() const { return failingRow; }
+    const std::string &reason() const { return why; }
+};
+
+class DivideByZeroError : public RowError {
+public:
+    explicit DivideByZeroError(size_t row) : RowError("Divide by zero", row) {}
+};
+
+// INT64_MIN / -1, whose quotient does not fit in int64.
+class DivideOverflowError : public RowError {
+public:
+    explicit DivideOverflowError(size_t row) : RowError("Division overflow", row) {}
+};
+
+// A function argument outside its domain, e.g. sqrt of a negative number.
+class DomainError : public RowError {
+public:
+    DomainError(const std::string &reason, size_t row) : RowError(reason, row) {}
+};
+
+// Applies a binary operator element-wise: out[i] = lhs[i] op rhs[i].
+// Uses AVX2 or SSE2 when the CPU has them and a scalar loop otherwise;
+// out may alias lhs or rhs. Returns n on success. For DIV, returns the
+// index of the first zero divisor or INT64_MIN / -1 instead, having
+// computed only the rows before it.
+size_t batchApply(Operator op, const int64_t *lhs, const int64_t *rhs, int64_t *out, size_t n);
+
+// Throws std::invalid_argument unless there is a column for every variable
+// slot of the program and each column holds at least `rows` values.
+void checkBatchColumns(const Program &program, const std::vector<ColumnView> &columns,
+                       size_t rows);
+
+// Evaluates a program once per row, reading variable slot i from
+// columns[i], and writes one result per row to out. Instead of walking
+// rows one at a time, each instruction runs as a vectorized loop over a
+// chunk of rows; function calls use the batch kernels from functions.h.
+// Throws DivideByZeroError, DivideOverflowError or DomainError for the
+// lowest failing row; out is unspecified in that case.
+void evaluateBatch(const Program &program, const std::vector<ColumnView> &columns,
+                   size_t rows, int64_t *out);
+
+#endif  // BATCH_H_
@@ -0,0 +1,165 @@
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "batch_mode.h"
+#include "parser.h"
+
+namespace {
+
+constexpr size_t kBufferSize = 1 << 20;
+
+// Output buffer flushed with write(2) once full.
+class OutputBuffer {
+    int fd;
+    std::string buffer;
+public:
+    explicit OutputBuffer(int fd) : fd(fd) { buffer.reserve(kBufferSize); }
+    ~OutputBuffer() { flush(); }
+    void append(std::string_view s) {
+        if (buffer.size() + s.size() > kBufferSize) flush();
+        buffer.append(s.data(), s.size());
+    }
+    void append(int64_t value) {
+        char digits[24];
+        auto res = std::to_chars(digits, digits + sizeof(digits), value);
+        append(std::string_view(digits, res.ptr - digits));
+    }
+    void flush() {
+        size_t done = 0;
+        while (done < buffer.size()) {
+            ssize_t n = ::write(fd, buffer.data() + done, buffer.size() - done);
+            if (n <= 0) break;
+            done += n;
+        }
+        buffer.clear();
+    }
+};
+
+// Evaluates one line at a time; the arena is reset per line, so steady
+// state evaluation does not allocate.
+class LineEvaluator {
+    Parser parser;
+    Arena arena;
+    OutputBuffer &out;
+    BatchSummary &summary;
+    size_t lineNumber = 0;
+
+    void error(const Error &error) {
+        out.append("error: line ");
+        out.append(static_cast<int64_t>(lineNumber));
+        if (error.offset != Error::kNoOffset) {
+            out.append(": column ");
+            out.append(static_cast<int64_t>(error.offset) + 1);
+        }
+        out.append(": ");
+        out.append(error.message());
+        out.append("\n");
+    }
+public:
+    LineEvaluator(OutputBuffer &out, BatchSummary &summary) : out(out), summary(summary) {}
+
+    void line(std::string_view text) {
+        ++lineNumber;
+        if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+        if (text.find_first_not_of(" \t") == std::string_view::npos) return;
+        ++summary.lines;
+
+        Result<IExpression *> expr = parser.tryParse(text, arena);
+        if (!expr) {
+            ++summary.parseErrors;
+            error(expr.error());
+        } else if (Result<int64_t> value = tryEvaluate(*expr)) {
+            ++summary.evaluated;
+            out.append(*value);
+            out.append("\n");
+        } else {
+            ++summary.evalErrors;
+            error(value.error());
+        }
+        arena.reset();
+    }
+
+    // Feeds every complete line in data; returns how many bytes were used.
+    size_t lines(const char *data, size_t size) {
+        size_t start = 0;
+        while (start < size) {
+            const void *nl = std::memchr(data + start, '\n', size - start);
+            if (!nl) break;
+            size_t end = static_cast<const char *>(nl) - data;
+            line(std::string_view(data + start, end - start));
+            start = end + 1;
+        }
+        return start;
+    }
+};
+
+bool runMapped(int fd, size_t size, LineEvaluator &eval, BatchSummary &summary) {
+    if (size == 0) return true;
+    void *map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return false;
+    ::madvise(map, size, MADV_SEQUENTIAL);
+    const char *data = static_cast<const char *>(map);
+    size_t used = eval.lines(data, size);
+    if (used < size) eval.line(std::string_view(data + used, size - used));
+    ::munmap(map, size);
+    summary.bytes += size;
+    return true;
+}
+
+// False on a read error other than EINTR, with errno set; the lines read
+// before it have been evaluated.
+bool runStream(int fd, LineEvaluator &eval, BatchSummary &summary) {
+    std::string buffer(kBufferSize, '\0');
+    size_t pending = 0;  // bytes of an incomplete line at the buffer start
+    while (true) {
+        if (pending == buffer.size()) buffer.resize(buffer.size() * 2);
+        ssize_t n = ::read(fd, &buffer[pending], buffer.size() - pending);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        if (n == 0) break;
+        summary.bytes += n;
+        size_t size = pending + n;
+        size_t used = eval.lines(buffer.data(), size);
+        pending = size - used;
+        std::memmove(&buffer[0], buffer.data() + used, pending);
+    }
+    if (pending > 0) eval.line(std::string_view(buffer.data(), pending));
+    return true;
+}
+
+}  // namespace
+
+bool runBatch(const char *path, int outFd, BatchSummary &summary) {
+    bool fromStdin = !path || std::strcmp(path, "-") == 0;
+    int fd = fromStdin ? STDIN_FILENO : ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = true;
+    int readError = 0;
+    {
+        OutputBuffer out(outFd);
+        LineEvaluator eval(out, summary);
+        struct stat st;
+        bool mapped = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+                      runMapped(fd, static_cast<size_t>(st.st_size), eval, summary);
+        if (!mapped && !runStream(fd, eval, summary)) {
+            ok = false;
+            readError = errno;
+        }
+    }
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!fromStdin) ::close(fd);
+    if (!ok) errno = readError;
+    return ok;
+}
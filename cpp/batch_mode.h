@@ -0,0 +1,26 @@
+#ifndef BATCH_MODE_H_
+#define BATCH_MODE_H_
+
+#include<cstddef>
+
+// Counters reported at the end of a batch run.
+struct BatchSummary {
+    size_t lines = 0;         // non-empty input lines
+    size_t evaluated = 0;
+    size_t parseErrors = 0;
+    size_t evalErrors = 0;
+    size_t bytes = 0;         // input bytes consumed
+    double seconds = 0;
+};
+
+// Non-interactive evaluation of newline-delimited expressions. Each
+// non-empty line produces one output line: the value, or
+// "error: line N[: column C]: <reason>", with the column for parse
+// errors. Regular files are mmap'd, anything else is read in large
+// blocks; output is buffered and written with write(2). `path` of
+// nullptr or "-" reads stdin. Returns false, with errno set, if the input
+// could not be opened or a read failed part way; the lines before the
+// failure have been answered.
+bool runBatch(const char *path, int outFd, BatchSummary &summary);
+
+#endif  // BATCH_MODE_H_
@@ -0,0 +1,13 @@
+#ifndef ALLOC_COUNTER_H_
+#define ALLOC_COUNTER_H_
+
+#include <cstddef>
+
+// Counts calls to the global operator new made by this process, so
+// benchmarks can report heap allocations per operation.
+namespace alloc_counter {
+size_t allocations();
+size_t bytes();
+}
+
+#endif  // ALLOC_COUNTER_H_
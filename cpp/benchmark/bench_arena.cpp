@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+#include <string>
+
+#include "alloc_counter.h"
+#include "parser.h"
+
+namespace {
+
+const char *kExpression = "(3 + 4) * (2 - 1) / 5 + 12 * (7 - 3) + (1 + 2) * (3 + 4) - 9 / 3";
+
+// Heap trees do not own their children, so callers have to walk them.
+void deleteTree(IExpression *expr) {
+    if (auto *bin = dynamic_cast<BinaryNode *>(expr)) {
+        deleteTree(bin->left);
+        deleteTree(bin->right);
+    }
+    delete expr;
+}
+
+void reportAllocations(benchmark::State &state, size_t before) {
+    state.counters["allocs/parse"] = benchmark::Counter(
+        double(alloc_counter::allocations() - before) / double(state.iterations()));
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ParseHeap(benchmark::State &state) {
+    Parser parser;
+    size_t before = alloc_counter::allocations();
+    for (auto _ : state) {
+        IExpression *expr = parser.parse(kExpression);
+        benchmark::DoNotOptimize(expr);
+        deleteTree(expr);
+    }
+    reportAllocations(state, before);
+}
+BENCHMARK(BM_ParseHeap);
+
+void BM_ParseArenaHandle(benchmark::State &state) {
+    Parser parser;
+    size_t before = alloc_counter::allocations();
+    for (auto _ : state) {
+        ParsedExpression parsed = parser.parseInArena(kExpression);
+        benchmark::DoNotOptimize(parsed.get());
+    }
+    reportAllocations(state, before);
+}
+BENCHMARK(BM_ParseArenaHandle);
+
+void BM_ParseArenaReused(benchmark::State &state) {
+    Parser parser;
+    Arena arena;
+    size_t before = alloc_counter::allocations();
+    for (auto _ : state) {
+        IExpression *expr = parser.parse(kExpression, arena);
+        benchmark::DoNotOptimize(expr);
+        arena.reset();
+    }
+    reportAllocations(state, before);
+}
+BENCHMARK(BM_ParseArenaReused);
+
+}  // namespace
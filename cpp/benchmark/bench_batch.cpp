@@ -0,0 +1,65 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "batch.h"
+
+namespace {
+
+const char *kFormula = "x * 3 + y / 2";
+
+struct Inputs {
+    CompiledExpression expr{kFormula};
+    std::vector<int64_t> x, y, out;
+    std::vector<ColumnView> columns;
+    explicit Inputs(size_t rows) : x(rows), y(rows), out(rows), columns(2) {
+        for (size_t i = 0; i < rows; ++i) {
+            x[i] = int64_t(i);
+            y[i] = int64_t(i % 1000) + 1;
+        }
+        columns[expr.slot("x")] = ColumnView{x.data(), rows};
+        columns[expr.slot("y")] = ColumnView{y.data(), rows};
+    }
+};
+
+void BM_RowByRow(benchmark::State &state) {
+    Inputs in(state.range(0));
+    size_t xs = in.expr.slot("x"), ys = in.expr.slot("y");
+    int64_t values[2];
+    for (auto _ : state) {
+        for (size_t i = 0; i < in.x.size(); ++i) {
+            values[xs] = in.x[i];
+            values[ys] = in.y[i];
+            in.out[i] = in.expr.evaluate(values);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RowByRow)->Arg(1 << 16)->Arg(1 << 20);
+
+void BM_Columnar(benchmark::State &state) {
+    Inputs in(state.range(0));
+    for (auto _ : state) {
+        evaluateBatch(in.expr.code(), in.columns, in.x.size(), in.out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Columnar)->Arg(1 << 16)->Arg(1 << 20);
+
+// Same shape without the division, which has no vector instruction.
+void BM_ColumnarNoDiv(benchmark::State &state) {
+    CompiledExpression expr("x * 3 + y * 2");
+    std::vector<int64_t> x(state.range(0), 3), y(state.range(0), 4), out(state.range(0));
+    std::vector<ColumnView> columns(2);
+    columns[expr.slot("x")] = ColumnView{x.data(), x.size()};
+    columns[expr.slot("y")] = ColumnView{y.data(), y.size()};
+    for (auto _ : state) {
+        evaluateBatch(expr.code(), columns, x.size(), out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ColumnarNoDiv)->Arg(1 << 16)->Arg(1 << 20);
+
+}  // namespace
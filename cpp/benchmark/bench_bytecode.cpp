@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include <string>
+
+#include "bytecode.h"
+#include "jit.h"
+#include "parser.h"
+
+namespace {
+
+// Left-leaning chain: 1+2-3*4+5-... with n operators.
+std::string wideExpression(int n) {
+    static const char ops[] = {'+', '-', '*', '+'};
+    std::string s = "1";
+    for (int i = 0; i < n; ++i) {
+        s += ops[i % 4];
+        s += std::to_string(i % 9 + 1);
+    }
+    return s;
+}
+
+// Right-nested expression: 1+(2*(3-(...))) with n levels.
+std::string deepExpression(int n) {
+    static const char ops[] = {'+', '*', '-'};
+    std::string s;
+    for (int i = 0; i < n; ++i) {
+        s += std::to_string(i % 3 + 1);
+        s += ops[i % 3];
+        s += '(';
+    }
+    s += "1";
+    s += std::string(n, ')');
+    return s;
+}
+
+void runTree(benchmark::State &state, const std::string &input) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parsed->getValue());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void runJit(benchmark::State &state, const std::string &input) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    JitFunction jit(parsed.get());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(jit());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["native"] = jit.isNative();
+}
+
+void runBytecode(benchmark::State &state, const std::string &input) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    BytecodeCompiler compiler;
+    Program program = compiler.compile(parsed.get());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(program.execute());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_TreeWide(benchmark::State &state) { runTree(state, wideExpression(state.range(0))); }
+void BM_BytecodeWide(benchmark::State &state) { runBytecode(state, wideExpression(state.range(0))); }
+void BM_TreeDeep(benchmark::State &state) { runTree(state, deepExpression(state.range(0))); }
+void BM_BytecodeDeep(benchmark::State &state) { runBytecode(state, deepExpression(state.range(0))); }
+void BM_JitWide(benchmark::State &state) { runJit(state, wideExpression(state.range(0))); }
+void BM_JitDeep(benchmark::State &state) { runJit(state, deepExpression(state.range(0))); }
+
+BENCHMARK(BM_TreeWide)->Arg(16)->Arg(256);
+BENCHMARK(BM_BytecodeWide)->Arg(16)->Arg(256);
+BENCHMARK(BM_TreeDeep)->Arg(16)->Arg(256);
+BENCHMARK(BM_BytecodeDeep)->Arg(16)->Arg(256);
+BENCHMARK(BM_JitWide)->Arg(16)->Arg(256);
+BENCHMARK(BM_JitDeep)->Arg(16)->Arg(256);
+
+}  // namespace
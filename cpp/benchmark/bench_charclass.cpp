@@ -0,0 +1,94 @@
+#include <benchmark/benchmark.h>
+#include <cctype>
+#include <string>
+
+#include "charclass.h"
+#include "parser.h"
+
+// Character classification on megabyte inputs shaped like generated
+// expressions: wide indentation, long identifiers and long literals.
+// Arg 0 is padded (runs of whitespace), 1 long names, 2 long numbers.
+
+namespace {
+
+enum Shape { PADDED, LONG_NAMES, LONG_NUMBERS };
+
+const char *shapeName(int shape) {
+    static const char *names[] = {"padded", "long_names", "long_numbers"};
+    return names[shape];
+}
+
+std::string input(int shape) {
+    std::string s = "1";
+    for (int i = 0; s.size() < (1 << 20); ++i) {
+        switch (shape) {
+        case PADDED:
+            s += "\n" + std::string(40 + i % 24, ' ') + "+ (" + std::to_string(i % 1000) + " * 2)";
+            break;
+        case LONG_NAMES:
+            s += " + sensorReadingChannel" + std::to_string(i) + "Calibrated" + std::string(24, 'x');
+            break;
+        case LONG_NUMBERS:
+            s += " - 0000000000000000000000000000000000000" + std::to_string(i % 100000);
+            break;
+        }
+    }
+    return s;
+}
+
+void BM_SkipSpacesLocale(benchmark::State &state) {
+    std::string s(1 << 20, ' ');
+    for (auto _ : state) {
+        size_t i = 0;
+        while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i]))) ++i;
+        benchmark::DoNotOptimize(i);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(s.size()));
+}
+BENCHMARK(BM_SkipSpacesLocale);
+
+void BM_SkipSpacesTable(benchmark::State &state) {
+    std::string s(1 << 20, ' ');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(charclass::skipScalar(s.data(), 0, s.size(), charclass::SPACE));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(s.size()));
+}
+BENCHMARK(BM_SkipSpacesTable);
+
+void BM_SkipSpacesSimd(benchmark::State &state) {
+    std::string s(1 << 20, ' ');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(charclass::skip(s.data(), 0, s.size(), charclass::SPACE));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(s.size()));
+}
+BENCHMARK(BM_SkipSpacesSimd);
+
+void BM_TokenizeLarge(benchmark::State &state) {
+    std::string text = input(int(state.range(0)));
+    for (auto _ : state) {
+        ViewTokenizer tokenizer(text);
+        for (TokenView t = tokenizer.next(); t.type != Token::Type::END; t = tokenizer.next()) {
+            benchmark::DoNotOptimize(t);
+        }
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(text.size()));
+    state.SetLabel(shapeName(int(state.range(0))));
+}
+BENCHMARK(BM_TokenizeLarge)->Arg(PADDED)->Arg(LONG_NAMES)->Arg(LONG_NUMBERS);
+
+void BM_TokenizeLargeCopying(benchmark::State &state) {
+    std::string text = input(int(state.range(0)));
+    for (auto _ : state) {
+        Tokenizer tokenizer(text);
+        for (Token t = tokenizer.next(); t.type != Token::Type::END; t = tokenizer.next()) {
+            benchmark::DoNotOptimize(t);
+        }
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(text.size()));
+    state.SetLabel(shapeName(int(state.range(0))));
+}
+BENCHMARK(BM_TokenizeLargeCopying)->Arg(PADDED)->Arg(LONG_NAMES)->Arg(LONG_NUMBERS);
+
+}  // namespace
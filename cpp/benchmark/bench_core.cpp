@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+#include <sstream>
+#include <string>
+
+#include "alloc_counter.h"
+#include "ast.h"
+#include "corpus.h"
+#include "parser.h"
+
+// Baseline suite for the original public API over the shared corpus. Each
+// benchmark reports ns/op (the time columns), bytes/op and allocs/op from
+// the global allocation counter. Run with
+//   make bench-json
+// to get a JSON report that can be diffed between releases.
+
+namespace {
+
+// Records heap traffic per iteration since the given snapshot.
+class AllocationReport {
+    size_t allocations = alloc_counter::allocations();
+    size_t bytes = alloc_counter::bytes();
+public:
+    void finish(benchmark::State &state, const std::string &input) {
+        double iterations = double(state.iterations());
+        state.counters["allocs/op"] = double(alloc_counter::allocations() - allocations) / iterations;
+        state.counters["bytes/op"] = double(alloc_counter::bytes() - bytes) / iterations;
+        state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(input.size()));
+        state.SetLabel(corpus::name(int(state.range(0))));
+    }
+};
+
+void allShapes(benchmark::internal::Benchmark *b) {
+    for (int shape = 0; shape < corpus::SHAPE_COUNT; ++shape) b->Arg(shape);
+}
+
+void BM_TokenizerNext(benchmark::State &state) {
+    std::string input = corpus::generate(int(state.range(0)));
+    AllocationReport report;
+    for (auto _ : state) {
+        Tokenizer tokenizer(input);
+        for (Token t = tokenizer.next(); t.type != Token::Type::END; t = tokenizer.next()) {
+            benchmark::DoNotOptimize(t);
+        }
+    }
+    report.finish(state, input);
+}
+BENCHMARK(BM_TokenizerNext)->Apply(allShapes);
+
+void BM_ParserParse(benchmark::State &state) {
+    std::string input = corpus::generate(int(state.range(0)));
+    Parser parser;
+    Arena arena;
+    AllocationReport report;
+    for (auto _ : state) {
+        arena.reset();
+        benchmark::DoNotOptimize(parser.parse(input, arena));
+    }
+    report.finish(state, input);
+}
+BENCHMARK(BM_ParserParse)->Apply(allShapes);
+
+// Heap-allocating parse, as used by the eval command line; the tree is
+// leaked deliberately since nodes have no owning destructor.
+void BM_ParserParseHeap(benchmark::State &state) {
+    std::string input = corpus::generate(int(state.range(0)));
+    Parser parser;
+    AllocationReport report;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parser.parse(input));
+    }
+    report.finish(state, input);
+}
+BENCHMARK(BM_ParserParseHeap)->Apply(allShapes)->Iterations(200);
+
+void BM_GetValue(benchmark::State &state) {
+    std::string input = corpus::generate(int(state.range(0)));
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    AllocationReport report;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parsed->getValue());
+    }
+    report.finish(state, input);
+}
+BENCHMARK(BM_GetValue)->Apply(allShapes);
+
+void BM_ASTPrinterPrint(benchmark::State &state) {
+    std::string input = corpus::generate(int(state.range(0)));
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    std::ostringstream oss;
+    ASTPrinter printer(oss);
+    AllocationReport report;
+    for (auto _ : state) {
+        oss.str("");
+        printer.print(parsed.get());
+    }
+    report.finish(state, input);
+}
+BENCHMARK(BM_ASTPrinterPrint)->Apply(allShapes);
+
+}  // namespace
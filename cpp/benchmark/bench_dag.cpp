@@ -0,0 +1,48 @@
+#include <benchmark/benchmark.h>
+#include <string>
+
+#include "dag.h"
+#include "parser.h"
+
+namespace {
+
+// Each level repeats the previous one four times, like generated code does:
+// e_k = (e_{k-1} + e_{k-1}) * (e_{k-1} - c) / (e_{k-1} + 1) with e_0 = a+b.
+std::string redundant(int levels) {
+    std::string e = "(a+b)";
+    for (int k = 0; k < levels; ++k) {
+        e = "((" + e + "+" + e + ")*(" + e + "-" + std::to_string(k + 2) + ")/(" + e + "*" + e + "+1))";
+    }
+    return e;
+}
+
+void BM_RedundantTree(benchmark::State &state) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena(redundant(state.range(0)));
+    table.set("a", 1);
+    table.set("b", 2);
+    for (auto _ : state) benchmark::DoNotOptimize(parsed->getValue());
+    state.counters["arena_bytes"] = double(parsed.memory().bytesUsed());
+}
+BENCHMARK(BM_RedundantTree)->Arg(2)->Arg(4);
+
+void BM_RedundantDag(benchmark::State &state) {
+    VariableTable table;
+    Arena arena;
+    HashConsingFactory factory(arena);
+    Parser parser;
+    parser.setVariables(&table);
+    parser.setFactory(&factory);
+    IExpression *expr = parser.parse(redundant(state.range(0)));
+    table.set("a", 1);
+    table.set("b", 2);
+    DagEvaluator dag(expr);
+    for (auto _ : state) benchmark::DoNotOptimize(dag.evaluate(table.data()));
+    state.counters["arena_bytes"] = double(arena.bytesUsed());
+    state.counters["unique_nodes"] = double(factory.unique());
+}
+BENCHMARK(BM_RedundantDag)->Arg(2)->Arg(4);
+
+}  // namespace
@@ -0,0 +1,78 @@
+#include <benchmark/benchmark.h>
+#include <sstream>
+#include <string>
+
+#include "ast.h"
+#include "parser.h"
+
+namespace {
+
+// ((((...1...)))) : one leaf under state.range(0) groups.
+std::string nested(int depth) {
+    std::string s(depth, '(');
+    s += "1";
+    s.append(depth, ')');
+    return s;
+}
+
+// 1-(1-(1-(...))) : a right spine as deep as the input.
+std::string rightSpine(int depth) {
+    std::string s;
+    for (int i = 0; i < depth; ++i) s += "1-(";
+    s += "1";
+    s.append(depth, ')');
+    return s;
+}
+
+// 1+2*3-4+... : a flat chain that parses to a deep left spine.
+std::string chain(int length) {
+    static const char ops[] = {'+', '*', '-', '+'};
+    std::string s = "1";
+    for (int i = 0; i < length; ++i) {
+        s += ops[i % 4];
+        s += std::to_string(i % 9 + 1);
+    }
+    return s;
+}
+
+template<std::string (*Make)(int)>
+void BM_DeepParse(benchmark::State &state) {
+    std::string input = Make(state.range(0));
+    Parser parser;
+    Arena arena;
+    for (auto _ : state) {
+        arena.reset();
+        benchmark::DoNotOptimize(parser.parse(input, arena));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(input.size()));
+}
+BENCHMARK_TEMPLATE(BM_DeepParse, nested)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_DeepParse, rightSpine)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_DeepParse, chain)->Arg(1000)->Arg(100000);
+
+template<std::string (*Make)(int)>
+void BM_DeepEvaluate(benchmark::State &state) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(Make(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parsed->getValue());
+    }
+}
+BENCHMARK_TEMPLATE(BM_DeepEvaluate, rightSpine)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_DeepEvaluate, chain)->Arg(1000)->Arg(100000);
+
+template<std::string (*Make)(int)>
+void BM_DeepPrint(benchmark::State &state) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(Make(state.range(0)));
+    std::ostringstream oss;
+    ASTPrinter printer(oss);
+    for (auto _ : state) {
+        oss.str("");
+        printer.print(parsed.get());
+    }
+}
+BENCHMARK_TEMPLATE(BM_DeepPrint, rightSpine)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_DeepPrint, chain)->Arg(1000)->Arg(100000);
+
+}  // namespace
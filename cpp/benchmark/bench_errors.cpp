@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "parser.h"
+
+// Batch evaluation of a corpus in which Arg percent of the rows are bad:
+// half fail to parse and half divide by zero. The exception variant is the
+// old error path, with the per-error message the parser used to print to
+// stderr formatted into a stream instead; the Result variant is
+// tryParse/tryEvaluate.
+
+namespace {
+
+std::vector<std::string> rows(int errorPercent) {
+    std::vector<std::string> out;
+    for (int i = 0; i < 1000; ++i) {
+        std::string n = std::to_string(i % 97 + 1);
+        if (i % 100 < errorPercent) {
+            out.push_back(i % 2 ? "(" + n + "+3)*/2" : "(" + n + "+3)*2/(" + n + "-" + n + ")");
+        } else {
+            out.push_back("(" + n + "+3)*2/(" + n + "+1)");
+        }
+    }
+    return out;
+}
+
+void report(benchmark::State &state, size_t rowCount, size_t failures) {
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(rowCount));
+    state.counters["failed"] = double(failures);
+}
+
+void BM_ErrorsExceptions(benchmark::State &state) {
+    std::vector<std::string> input = rows(int(state.range(0)));
+    Parser parser;
+    Arena arena;
+    std::ostringstream sink;
+    size_t failures = 0;
+    for (auto _ : state) {
+        failures = 0;
+        sink.str("");
+        for (const std::string &row : input) {
+            IExpression *expr = parser.parse(row, arena);
+            if (!expr) {
+                sink << "Unexpected token '" << row << "' while parsing primary expression.\n";
+                ++failures;
+            } else {
+                try {
+                    benchmark::DoNotOptimize(expr->getValue());
+                } catch (const std::runtime_error &e) {
+                    benchmark::DoNotOptimize(e.what());
+                    ++failures;
+                }
+            }
+            arena.reset();
+        }
+    }
+    report(state, input.size(), failures);
+}
+BENCHMARK(BM_ErrorsExceptions)->Arg(0)->Arg(1)->Arg(10)->Arg(50);
+
+void BM_ErrorsResult(benchmark::State &state) {
+    std::vector<std::string> input = rows(int(state.range(0)));
+    Parser parser;
+    Arena arena;
+    size_t failures = 0;
+    for (auto _ : state) {
+        failures = 0;
+        for (const std::string &row : input) {
+            Result<IExpression *> expr = parser.tryParse(row, arena);
+            Result<int64_t> value = expr ? tryEvaluate(*expr) : Result<int64_t>(expr.error());
+            benchmark::DoNotOptimize(value);
+            failures += !value;
+            arena.reset();
+        }
+    }
+    report(state, input.size(), failures);
+}
+BENCHMARK(BM_ErrorsResult)->Arg(0)->Arg(1)->Arg(10)->Arg(50);
+
+}  // namespace
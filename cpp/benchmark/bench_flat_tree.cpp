@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flat_tree.h"
+#include "parser.h"
+#include "perf_counter.h"
+
+namespace {
+
+std::string wideExpression(int n) {
+    static const char ops[] = {'+', '-', '*', '+'};
+    std::string s = "x";
+    for (int i = 0; i < n; ++i) {
+        s += ops[i % 4];
+        s += (i % 5 == 0) ? std::string("y") : std::to_string(i % 9 + 1);
+    }
+    return s;
+}
+
+// Heap-parsed tree with unrelated allocations interleaved, approximating
+// a long-running process where nodes end up scattered across the heap.
+struct ScatteredTree {
+    VariableTable table;
+    std::vector<std::unique_ptr<char[]>> noise;
+    IExpression *root = nullptr;
+    explicit ScatteredTree(const std::string &text) {
+        Parser parser;
+        parser.setVariables(&table);
+        for (size_t i = 0; i < 4096; ++i) noise.emplace_back(new char[64 + (i * 37) % 512]);
+        for (size_t i = 0; i < noise.size(); i += 2) noise[i].reset();
+        root = parser.parse(text);
+        table.set("x", 3);
+        table.set("y", 2);
+    }
+};
+
+template<typename Eval>
+void measure(benchmark::State &state, Eval eval) {
+    CacheMissCounter misses;
+    uint64_t total = 0;
+    for (auto _ : state) {
+        misses.start();
+        benchmark::DoNotOptimize(eval());
+        total += misses.stop();
+    }
+    if (misses.available()) {
+        state.counters["cache_misses/eval"] = double(total) / double(state.iterations());
+    }
+}
+
+void BM_PointerTree(benchmark::State &state) {
+    ScatteredTree tree(wideExpression(state.range(0)));
+    measure(state, [&] { return tree.root->getValue(); });
+    state.counters["bytes/node"] = double(sizeof(BinaryNode));
+}
+BENCHMARK(BM_PointerTree)->Arg(64)->Arg(100000);
+
+void BM_FlatTree(benchmark::State &state) {
+    ScatteredTree tree(wideExpression(state.range(0)));
+    FlatTree flat(tree.root);
+    measure(state, [&] { return flat.evaluate(); });
+    state.counters["bytes/node"] = double(sizeof(FlatNode));
+}
+BENCHMARK(BM_FlatTree)->Arg(64)->Arg(100000);
+
+}  // namespace
@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+#include "functions.h"
+#include "parser.h"
+
+namespace {
+
+const char *kNames[] = {"sqrt", "abs", "sin", "cos", "tan", "x", "sqrtx", "cosh"};
+
+// Name resolution as the parser does it, against the if-chain of string
+// comparisons it replaces.
+void BM_FunctionLookupHash(benchmark::State &state) {
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lookupFunction(kNames[i++ & 7]));
+    }
+}
+BENCHMARK(BM_FunctionLookupHash);
+
+void BM_FunctionLookupCompare(benchmark::State &state) {
+    static const char *known[] = {"sqrt", "abs", "sin", "cos"};
+    size_t i = 0;
+    for (auto _ : state) {
+        const char *name = kNames[i++ & 7];
+        int found = -1;
+        for (int k = 0; k < 4; ++k) {
+            if (std::strcmp(name, known[k]) == 0) {
+                found = k;
+                break;
+            }
+        }
+        benchmark::DoNotOptimize(found);
+    }
+}
+BENCHMARK(BM_FunctionLookupCompare);
+
+std::vector<int64_t> arguments(size_t n) {
+    std::vector<int64_t> v(n);
+    for (size_t i = 0; i < n; ++i) v[i] = int64_t(i * 2654435761u % 1000000);
+    return v;
+}
+
+// One call per value through the scalar pointer versus the batch kernel.
+void BM_FunctionScalar(benchmark::State &state) {
+    const FunctionInfo &function = functionInfo(static_cast<Operator>(state.range(0)));
+    std::vector<int64_t> in = arguments(4096), out(in.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < in.size(); ++i) out[i] = function.scalar(in[i]);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(in.size()));
+    state.SetLabel(function.name);
+}
+
+void BM_FunctionBatch(benchmark::State &state) {
+    const FunctionInfo &function = functionInfo(static_cast<Operator>(state.range(0)));
+    std::vector<int64_t> in = arguments(4096), out(in.size());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(function.batch(in.data(), out.data(), in.size()));
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(in.size()));
+    state.SetLabel(function.name);
+}
+
+void allFunctions(benchmark::internal::Benchmark *b) {
+    for (Operator op : {Operator::SQRT, Operator::ABS, Operator::SIN, Operator::COS}) {
+        b->Arg(static_cast<int>(op));
+    }
+}
+BENCHMARK(BM_FunctionScalar)->Apply(allFunctions);
+BENCHMARK(BM_FunctionBatch)->Apply(allFunctions);
+
+// A function-heavy formula end to end: tree walk versus columnar batch.
+const char *kFormula = "sqrt(x*x + y*y) + abs(x - y) * cos(0)";
+
+void BM_FunctionTree(benchmark::State &state) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena(kFormula);
+    std::vector<int64_t> xs = arguments(4096);
+    for (auto _ : state) {
+        for (size_t i = 0; i < xs.size(); ++i) {
+            table.set(size_t(0), xs[i]);
+            table.set(size_t(1), xs[xs.size() - 1 - i]);
+            benchmark::DoNotOptimize(parsed->getValue());
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(xs.size()));
+}
+BENCHMARK(BM_FunctionTree);
+
+void BM_FunctionColumnar(benchmark::State &state) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena(kFormula);
+    BytecodeCompiler compiler;
+    Program program = compiler.compile(parsed.get());
+    std::vector<int64_t> xs = arguments(4096), ys(xs.rbegin(), xs.rend()), out(xs.size());
+    std::vector<ColumnView> columns = {{xs.data(), xs.size()}, {ys.data(), ys.size()}};
+    for (auto _ : state) {
+        evaluateBatch(program, columns, xs.size(), out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(xs.size()));
+}
+BENCHMARK(BM_FunctionColumnar);
+
+}  // namespace
@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+#include <string>
+
+#include "flat_tree.h"
+#include "incremental.h"
+#include "parser.h"
+
+// One variable changes per tick in a large expression: incremental update
+// of the dirty path versus re-evaluating the whole tree. Arg is the number
+// of variables; the tree is a balanced sum of x_i * c terms.
+
+namespace {
+
+std::string term(int i) {
+    return "x" + std::to_string(i) + "*" + std::to_string(i % 7 + 1);
+}
+
+std::string balancedSum(int first, int count) {
+    if (count == 1) return term(first);
+    int half = count / 2;
+    return "(" + balancedSum(first, half) + "+" + balancedSum(first + half, count - half) + ")";
+}
+
+struct Pricing {
+    VariableTable table;
+    Parser parser;
+    ParsedExpression parsed;
+    explicit Pricing(int variables) {
+        parser.setVariables(&table);
+        parsed = parser.parseInArena(balancedSum(0, variables));
+        for (size_t s = 0; s < table.size(); ++s) table.set(s, int64_t(s));
+    }
+};
+
+// Visits the slots in a scattered order, one per tick.
+size_t nextSlot(size_t tick, size_t slots) {
+    return (tick * 7919) % slots;
+}
+
+void BM_IncrementalUpdate(benchmark::State &state) {
+    Pricing pricing(int(state.range(0)));
+    IncrementalEvaluator eval(pricing.parsed.get());
+    eval.value();
+    size_t slots = pricing.table.size();
+    size_t tick = 0;
+    size_t recomputed = 0;
+    for (auto _ : state) {
+        eval.set(nextSlot(tick, slots), int64_t(tick));
+        benchmark::DoNotOptimize(eval.value());
+        recomputed += eval.lastRecomputed();
+        ++tick;
+    }
+    state.counters["nodes"] = double(eval.size());
+    state.counters["recomputed/op"] = double(recomputed) / double(state.iterations());
+}
+BENCHMARK(BM_IncrementalUpdate)->Arg(1 << 10)->Arg(1 << 14);
+
+void BM_FullReevaluationTree(benchmark::State &state) {
+    Pricing pricing(int(state.range(0)));
+    size_t slots = pricing.table.size();
+    size_t tick = 0;
+    for (auto _ : state) {
+        pricing.table.set(nextSlot(tick, slots), int64_t(tick));
+        benchmark::DoNotOptimize(pricing.parsed->getValue());
+        ++tick;
+    }
+}
+BENCHMARK(BM_FullReevaluationTree)->Arg(1 << 10)->Arg(1 << 14);
+
+void BM_FullReevaluationFlat(benchmark::State &state) {
+    Pricing pricing(int(state.range(0)));
+    FlatTree flat(pricing.parsed.get());
+    size_t slots = pricing.table.size();
+    size_t tick = 0;
+    for (auto _ : state) {
+        pricing.table.set(nextSlot(tick, slots), int64_t(tick));
+        benchmark::DoNotOptimize(flat.evaluate());
+        ++tick;
+    }
+}
+BENCHMARK(BM_FullReevaluationFlat)->Arg(1 << 10)->Arg(1 << 14);
+
+}  // namespace
@@ -0,0 +1,96 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "flat_tree.h"
+#include "library.h"
+#include "parser.h"
+
+// Cold start of a 100k formula set: reading and parsing the text form into
+// FlatTrees versus mapping the precompiled library, with and without
+// verification. Each iteration ends with one evaluation of every formula
+// so the timings include first touch of the nodes.
+
+namespace {
+
+constexpr int kFormulas = 100000;
+
+std::string formula(int i) {
+    std::string a = "x" + std::to_string(i % 50);
+    std::string b = "x" + std::to_string(i % 37 + 50);
+    return "(" + a + " * " + std::to_string(i % 97 + 1) + " + " + b + ") / (abs(" + a +
+           " - " + b + ") + 1) - " + std::to_string(i % 13);
+}
+
+// Writes both files once per process; removed at exit.
+struct Files {
+    std::string text = "bench_library.txt";
+    std::string binary = "bench_library.exprlib";
+    Files() {
+        std::ofstream out(text);
+        LibraryBuilder builder;
+        for (int i = 0; i < kFormulas; ++i) {
+            std::string f = formula(i);
+            out << f << "\n";
+            builder.add(f);
+        }
+        builder.save(binary);
+    }
+    ~Files() {
+        std::remove(text.c_str());
+        std::remove(binary.c_str());
+    }
+};
+
+const Files &files() {
+    static Files instance;
+    return instance;
+}
+
+void BM_ColdStartText(benchmark::State &state) {
+    const Files &f = files();
+    for (auto _ : state) {
+        std::ifstream in(f.text);
+        VariableTable table;
+        Parser parser;
+        parser.setVariables(&table);
+        std::vector<FlatTree> trees;
+        trees.reserve(kFormulas);
+        std::string line;
+        while (std::getline(in, line)) {
+            ParsedExpression parsed = parser.parseInArena(line);
+            trees.emplace_back(parsed.get());
+        }
+        std::vector<int64_t> vars(table.size(), 3);
+        int64_t sum = 0;
+        for (const FlatTree &tree : trees) sum += tree.evaluate(vars.data());
+        benchmark::DoNotOptimize(sum);
+    }
+    state.counters["formulas/s"] =
+        benchmark::Counter(double(kFormulas) * double(state.iterations()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ColdStartText)->Unit(benchmark::kMillisecond);
+
+void BM_ColdStartLibrary(benchmark::State &state) {
+    const Files &f = files();
+    bool verify = state.range(0) != 0;
+    for (auto _ : state) {
+        ExpressionLibrary library;
+        if (library.open(f.binary, verify) != ExpressionLibrary::Status::OK) {
+            state.SkipWithError("cannot open library");
+            break;
+        }
+        std::vector<int64_t> vars(library.variableCount(), 3);
+        int64_t sum = 0;
+        for (size_t i = 0; i < library.size(); ++i) sum += library.evaluate(i, vars.data());
+        benchmark::DoNotOptimize(sum);
+    }
+    state.counters["formulas/s"] =
+        benchmark::Counter(double(kFormulas) * double(state.iterations()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ColdStartLibrary)->ArgName("verify")->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "parser.h"
+
+// Number lexing on its own: the old path copied each literal into a
+// std::string and decoded it with std::stoll, which throws on overflow;
+// lexNumber decodes in place. The Arg selects the literal shape.
+
+namespace {
+
+enum Shape { INTEGERS, DECIMALS, EXPONENTS };
+
+const char *shapeName(int shape) {
+    static const char *names[] = {"integers", "decimals", "exponents"};
+    return names[shape];
+}
+
+std::vector<std::string> literals(int shape) {
+    std::vector<std::string> out;
+    for (int i = 0; i < 1024; ++i) {
+        std::string digits = std::to_string(1000000 + i * 7919);
+        switch (shape) {
+        case INTEGERS: out.push_back(digits); break;
+        case DECIMALS: out.push_back(digits.substr(0, 4) + "." + digits.substr(4)); break;
+        case EXPONENTS: out.push_back(digits.substr(0, 1) + "." + digits.substr(1) + "e6"); break;
+        }
+    }
+    return out;
+}
+
+void report(benchmark::State &state, const std::vector<std::string> &input, size_t before) {
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(input.size()));
+    state.counters["allocs/op"] = double(alloc_counter::allocations() - before) /
+                                  double(state.iterations());
+    state.SetLabel(shapeName(int(state.range(0))));
+}
+
+void BM_NumberStoll(benchmark::State &state) {
+    std::vector<std::string> input = literals(int(state.range(0)));
+    size_t before = alloc_counter::allocations();
+    for (auto _ : state) {
+        for (const std::string &literal : input) {
+            // Same shape as the old Tokenizer/Parser pair: copy, then decode.
+            // stoll stops at the '.', so decimals are only partly decoded.
+            std::string text(literal.data(), literal.size());
+            try {
+                benchmark::DoNotOptimize(std::stoll(text));
+            } catch (const std::out_of_range &) {
+            }
+        }
+    }
+    report(state, input, before);
+}
+BENCHMARK(BM_NumberStoll)->Arg(INTEGERS)->Arg(DECIMALS)->Arg(EXPONENTS);
+
+void BM_NumberLex(benchmark::State &state) {
+    std::vector<std::string> input = literals(int(state.range(0)));
+    size_t before = alloc_counter::allocations();
+    for (auto _ : state) {
+        for (const std::string &literal : input) {
+            benchmark::DoNotOptimize(lexNumber(literal));
+        }
+    }
+    report(state, input, before);
+}
+BENCHMARK(BM_NumberLex)->Arg(INTEGERS)->Arg(DECIMALS)->Arg(EXPONENTS);
+
+// Whole-tokenizer throughput on an input that is mostly literals.
+void BM_TokenizeNumbers(benchmark::State &state) {
+    std::vector<std::string> parts = literals(int(state.range(0)));
+    std::string input = parts[0];
+    for (size_t i = 1; i < parts.size(); ++i) input += " + " + parts[i];
+    size_t before = alloc_counter::allocations();
+    for (auto _ : state) {
+        ViewTokenizer tokenizer(input);
+        for (TokenView t = tokenizer.next(); t.type != Token::Type::END; t = tokenizer.next()) {
+            benchmark::DoNotOptimize(t);
+        }
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(input.size()));
+    state.counters["allocs/op"] = double(alloc_counter::allocations() - before) /
+                                  double(state.iterations());
+    state.SetLabel(shapeName(int(state.range(0))));
+}
+BENCHMARK(BM_TokenizeNumbers)->Arg(INTEGERS)->Arg(DECIMALS)->Arg(EXPONENTS);
+
+}  // namespace
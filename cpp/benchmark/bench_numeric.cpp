@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+#include "numeric.h"
+#include "parser.h"
+
+namespace {
+
+// Same formula and bindings for every mode; values stay small enough that
+// the checked mode never throws.
+const char *kFormula = "(x*3 + y/2 - (x-y)*7) * abs(x - 5) + sqrt(y*y + 1)";
+
+struct Compiled {
+    VariableTable table;
+    ParsedExpression tree;
+    Program program;
+    Compiled() {
+        Parser parser;
+        parser.setVariables(&table);
+        tree = parser.parseInArena(kFormula);
+        program = BytecodeCompiler().compile(tree.get());
+    }
+};
+
+template<typename Mode>
+std::vector<typename Mode::Value> bindings(const Compiled &c) {
+    std::vector<typename Mode::Value> values(c.table.size());
+    values[c.table.find("x")] = Mode::fromInt(123);
+    values[c.table.find("y")] = Mode::fromInt(-45);
+    return values;
+}
+
+void BM_ModeWrappingTree(benchmark::State &state) {
+    Compiled c;
+    c.table.set("x", 123);
+    c.table.set("y", -45);
+    for (auto _ : state) benchmark::DoNotOptimize(c.tree->getValue());
+}
+BENCHMARK(BM_ModeWrappingTree);
+
+void BM_ModeWrappingProgram(benchmark::State &state) {
+    Compiled c;
+    c.table.set("x", 123);
+    c.table.set("y", -45);
+    for (auto _ : state) benchmark::DoNotOptimize(c.program.execute(c.table.data()));
+}
+BENCHMARK(BM_ModeWrappingProgram);
+
+template<typename Mode>
+void BM_ModeTree(benchmark::State &state) {
+    Compiled c;
+    auto values = bindings<Mode>(c);
+    for (auto _ : state) benchmark::DoNotOptimize(evaluateAs<Mode>(c.tree.get(), values.data()));
+}
+BENCHMARK_TEMPLATE(BM_ModeTree, CheckedInt64);
+BENCHMARK_TEMPLATE(BM_ModeTree, Float64);
+BENCHMARK_TEMPLATE(BM_ModeTree, BigInteger);
+
+template<typename Mode>
+void BM_ModeProgram(benchmark::State &state) {
+    Compiled c;
+    auto values = bindings<Mode>(c);
+    for (auto _ : state) benchmark::DoNotOptimize(executeAs<Mode>(c.program, values.data()));
+}
+BENCHMARK_TEMPLATE(BM_ModeProgram, CheckedInt64);
+BENCHMARK_TEMPLATE(BM_ModeProgram, Float64);
+BENCHMARK_TEMPLATE(BM_ModeProgram, BigInteger);
+
+// Growth past 64 bits: a product chain that only the big mode can finish.
+void BM_ModeBigProduct(benchmark::State &state) {
+    std::string text = "3";
+    for (int64_t i = 0; i < state.range(0); ++i) text += "*2147483647";
+    Parser parser;
+    ParsedExpression tree = parser.parseInArena(text);
+    for (auto _ : state) benchmark::DoNotOptimize(evaluateAs<BigInteger>(tree.get()));
+    state.counters["digits"] = double(evaluateAs<BigInteger>(tree.get()).toString().size());
+}
+BENCHMARK(BM_ModeBigProduct)->Arg(8)->Arg(64)->Arg(512);
+
+}  // namespace
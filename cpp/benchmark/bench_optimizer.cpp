@@ -0,0 +1,46 @@
+#include <benchmark/benchmark.h>
+#include <string>
+
+#include "optimizer.h"
+#include "parser.h"
+
+namespace {
+
+// Formula with constant subexpressions and identities around a few variables.
+std::string formula(int terms) {
+    std::string s = "x";
+    for (int i = 0; i < terms; ++i) {
+        s += " + (" + std::to_string(i) + " * 3 - 2) * (y * 1 + 0) - (x - 0) / (4 - 3)";
+    }
+    return s;
+}
+
+void BM_EvalUnfolded(benchmark::State &state) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena(formula(state.range(0)));
+    table.set("x", 5);
+    table.set("y", 7);
+    for (auto _ : state) benchmark::DoNotOptimize(parsed->getValue());
+    state.counters["nodes"] = double(countNodes(parsed.get()));
+}
+BENCHMARK(BM_EvalUnfolded)->Arg(8)->Arg(64);
+
+void BM_EvalFolded(benchmark::State &state) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena(formula(state.range(0)));
+    Arena arena;
+    ConstantFolder folder(arena);
+    IExpression *folded = folder.fold(parsed.get());
+    table.set("x", 5);
+    table.set("y", 7);
+    for (auto _ : state) benchmark::DoNotOptimize(folded->getValue());
+    state.counters["nodes"] = double(folder.nodesAfter());
+    state.counters["eliminated"] = double(folder.eliminated());
+}
+BENCHMARK(BM_EvalFolded)->Arg(8)->Arg(64);
+
+}  // namespace
@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "parallel.h"
+
+namespace {
+
+// 1, 2, 4, ... up to and including the number of hardware threads.
+void threadCounts(benchmark::internal::Benchmark *b) {
+    size_t hw = std::thread::hardware_concurrency();
+    if (hw == 0) hw = 1;
+    size_t n = 1;
+    for (; n < hw; n *= 2) b->Arg(n);
+    b->Arg(hw);
+}
+
+void BM_ParallelBatch(benchmark::State &state) {
+    ThreadPool pool(state.range(0));
+    CompiledExpression expr("x * 3 + y / 2 - (x - y) * 7");
+    const size_t rows = 1 << 22;
+    std::vector<int64_t> x(rows), y(rows), out(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        x[i] = int64_t(i);
+        y[i] = int64_t(i % 1000) + 1;
+    }
+    std::vector<ColumnView> columns(2);
+    columns[expr.slot("x")] = ColumnView{x.data(), rows};
+    columns[expr.slot("y")] = ColumnView{y.data(), rows};
+    for (auto _ : state) {
+        parallelEvaluateBatch(pool, expr.code(), columns, rows, out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_ParallelBatch)->Apply(threadCounts)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+void BM_ParallelExpressions(benchmark::State &state) {
+    ThreadPool pool(state.range(0));
+    std::vector<std::string> inputs;
+    for (int i = 0; i < 20000; ++i) {
+        inputs.push_back("(" + std::to_string(i) + " + 4) * (2 - 1) / 5 + " + std::to_string(i % 7));
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parallelEvaluate(pool, inputs));
+    }
+    state.SetItemsProcessed(state.iterations() * inputs.size());
+}
+BENCHMARK(BM_ParallelExpressions)->Apply(threadCounts)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+}  // namespace
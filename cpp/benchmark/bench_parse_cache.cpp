@@ -0,0 +1,50 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+#include "parse_cache.h"
+
+namespace {
+
+// A few thousand distinct formulas, requested round-robin.
+std::vector<std::string> formulas(size_t n) {
+    std::vector<std::string> out;
+    for (size_t i = 0; i < n; ++i) {
+        out.push_back("(" + std::to_string(i) + " + 4) * (x - 1) / 5 + " + std::to_string(i % 7) +
+                      " * (y + 2) - 3");
+    }
+    return out;
+}
+
+void BM_ParseEveryTime(benchmark::State &state) {
+    auto inputs = formulas(state.range(0));
+    int64_t values[2] = {3, 4};
+    size_t i = 0;
+    for (auto _ : state) {
+        VariableTable variables;
+        Parser parser;
+        parser.setVariables(&variables);
+        ParsedExpression parsed = parser.parseInArena(inputs[i++ % inputs.size()]);
+        BytecodeCompiler compiler;
+        benchmark::DoNotOptimize(compiler.compile(parsed.get()).execute(values));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseEveryTime)->Arg(4096);
+
+void BM_ParseCached(benchmark::State &state) {
+    auto inputs = formulas(state.range(0));
+    ParseCache cache(8192);
+    int64_t values[2] = {3, 4};
+    size_t i = 0;
+    for (auto _ : state) {
+        auto entry = cache.get(inputs[i++ % inputs.size()]);
+        benchmark::DoNotOptimize(entry->program.execute(values));
+    }
+    auto stats = cache.stats();
+    state.counters["hit_rate"] = double(stats.hits) / double(stats.hits + stats.misses);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseCached)->Arg(4096);
+
+}  // namespace
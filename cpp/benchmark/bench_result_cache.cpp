@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+#include "parser.h"
+#include "result_cache.h"
+
+// Repeated evaluation of one formula over a small set of binding tuples:
+// walking the tree every time versus answering from the result cache,
+// under LRU and CLOCK, and with threads contending for one shard or many.
+
+namespace {
+
+// A pricing formula of a few dozen nodes over four variables.
+const char *kFormula =
+    "(price * qty - discount) * (100 + tax) / 100 + abs(price - list) * 2"
+    " - (qty * (price + 3) - discount / (tax + 1)) / 7 + sqrt(qty * qty + 1)";
+
+struct Formula {
+    VariableTable table;
+    Parser parser;
+    ParsedExpression parsed;
+    uint64_t id = newExpressionIds();
+    Formula() {
+        parser.setVariables(&table);
+        parsed = parser.parseInArena(kFormula);
+    }
+};
+
+// Arg distinct binding tuples, cycled through.
+std::vector<std::vector<int64_t>> tuples(size_t count, size_t slots) {
+    std::vector<std::vector<int64_t>> out(count, std::vector<int64_t>(slots));
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t s = 0; s < slots; ++s) out[i][s] = int64_t(i * 7 + s * 13 % 50 + 1);
+    }
+    return out;
+}
+
+void BM_TreeEveryTime(benchmark::State &state) {
+    Formula f;
+    auto inputs = tuples(size_t(state.range(0)), f.table.size());
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::vector<int64_t> &values = inputs[i++ % inputs.size()];
+        for (size_t s = 0; s < values.size(); ++s) f.table.set(s, values[s]);
+        benchmark::DoNotOptimize(tryEvaluate(f.parsed.get()));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TreeEveryTime)->Arg(1024);
+
+void BM_ResultCacheHit(benchmark::State &state) {
+    Formula f;
+    auto inputs = tuples(size_t(state.range(0)), f.table.size());
+    ResultCache::Options options;
+    options.eviction = state.range(1) ? ResultCache::Eviction::CLOCK : ResultCache::Eviction::LRU;
+    ResultCache cache(options);
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::vector<int64_t> &values = inputs[i++ % inputs.size()];
+        benchmark::DoNotOptimize(cache.evaluate(f.id, values.data(), values.size(), [&] {
+            for (size_t s = 0; s < values.size(); ++s) f.table.set(s, values[s]);
+            return tryEvaluate(f.parsed.get());
+        }));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hit_rate"] = cache.stats().hitRate();
+}
+BENCHMARK(BM_ResultCacheHit)->ArgNames({"tuples", "clock"})->Args({1024, 0})->Args({1024, 1});
+
+// Hits only, from several threads; Arg is the shard count.
+void BM_ResultCacheContended(benchmark::State &state) {
+    static ResultCache *cache = nullptr;
+    static std::vector<std::vector<int64_t>> inputs;
+    static uint64_t id;
+    if (state.thread_index() == 0) {
+        ResultCache::Options options;
+        options.shards = size_t(state.range(0));
+        cache = new ResultCache(options);
+        inputs = tuples(1024, 4);
+        id = newExpressionIds();
+        for (const auto &values : inputs) cache->insert(id, values.data(), values.size(), values[0]);
+    }
+    size_t i = size_t(state.thread_index()) * 97;
+    for (auto _ : state) {
+        const std::vector<int64_t> &values = inputs[i++ % inputs.size()];
+        Result<int64_t> result(int64_t(0));
+        benchmark::DoNotOptimize(cache->lookup(id, values.data(), values.size(), result));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        delete cache;
+        cache = nullptr;
+    }
+}
+BENCHMARK(BM_ResultCacheContended)->Arg(1)->Arg(16)->Threads(4)->UseRealTime();
+
+}  // namespace
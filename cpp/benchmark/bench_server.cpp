@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "eval_server.h"
+#include "load_generator.h"
+
+// The evaluation server end to end over a Unix socket, and the batching
+// behind it: the same requests evaluated as one round versus one round
+// per request.
+
+namespace {
+
+std::vector<std::string> pricingRequests(size_t count) {
+    std::vector<std::string> requests;
+    for (size_t i = 0; i < count; ++i) {
+        requests.push_back("price * qty - discount / 2; price=" + std::to_string(i) +
+                           "; qty=" + std::to_string(i % 9 + 1) + "; discount=" + std::to_string(i % 40));
+    }
+    return requests;
+}
+
+// Arg is the batch size: requests evaluated per evaluate() call.
+void BM_BatchEvaluator(benchmark::State &state) {
+    std::vector<std::string> requests = pricingRequests(1024);
+    size_t batch = size_t(state.range(0));
+    BatchEvaluator evaluator;
+    size_t next = 0;
+    for (auto _ : state) {
+        for (size_t i = 0; i < requests.size(); ++i) {
+            evaluator.add(requests[next]);
+            next = next + 1 == requests.size() ? 0 : next + 1;
+            if (evaluator.size() == batch) {
+                evaluator.evaluate();
+                benchmark::DoNotOptimize(evaluator.results().data());
+            }
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(requests.size()));
+}
+BENCHMARK(BM_BatchEvaluator)->Arg(1)->Arg(16)->Arg(256);
+
+// Args are connections and requests in flight per connection. Reports the
+// client-side latency percentiles.
+void BM_ServerLoad(benchmark::State &state) {
+    std::string path = "/tmp/bench_server_" + std::to_string(::getpid()) + ".sock";
+    EvalServer server(path);
+    if (!server.listen()) {
+        state.SkipWithError("cannot listen");
+        return;
+    }
+    std::thread loop([&] { server.run(); });
+
+    LoadOptions options;
+    options.socketPath = path;
+    options.requests = pricingRequests(256);
+    options.connections = size_t(state.range(0));
+    options.depth = size_t(state.range(1));
+    options.total = 20000;
+    LoadReport report;
+    double p50 = 0, p99 = 0;
+    for (auto _ : state) {
+        if (!runLoad(options, report)) {
+            state.SkipWithError("load failed");
+            break;
+        }
+        p50 += report.p50Ns / 1000.0;
+        p99 += report.p99Ns / 1000.0;
+    }
+    server.stop();
+    loop.join();
+
+    double runs = double(state.iterations());
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(options.total));
+    state.counters["p50_us"] = runs ? p50 / runs : 0;
+    state.counters["p99_us"] = runs ? p99 / runs : 0;
+    state.counters["per_round"] = double(server.stats().requests) / double(server.stats().rounds);
+}
+BENCHMARK(BM_ServerLoad)
+    ->Args({1, 1})->Args({1, 32})->Args({8, 32})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}  // namespace
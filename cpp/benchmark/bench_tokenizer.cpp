@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+#include <string>
+
+#include "alloc_counter.h"
+#include "parser.h"
+
+namespace {
+
+std::string corpus(size_t bytes) {
+    std::string s = "1";
+    int i = 0;
+    while (s.size() < bytes) {
+        s += " + (";
+        s += std::to_string(i * 7919 % 100000);
+        s += " * x";
+        s += std::to_string(i % 10);
+        s += " - 42) / 3";
+        ++i;
+    }
+    return s;
+}
+
+void report(benchmark::State &state, const std::string &input, size_t tokens, size_t before) {
+    state.SetBytesProcessed(state.iterations() * input.size());
+    state.counters["tokens"] = double(tokens);
+    state.counters["allocs/op"] = benchmark::Counter(
+        double(alloc_counter::allocations() - before) / double(state.iterations()));
+}
+
+void BM_TokenizerCopying(benchmark::State &state) {
+    std::string input = corpus(state.range(0));
+    size_t tokens = 0;
+    size_t before = alloc_counter::allocations();
+    for (auto _ : state) {
+        Tokenizer tokenizer(input);
+        tokens = 0;
+        for (Token t = tokenizer.next(); t.type != Token::Type::END; t = tokenizer.next()) {
+            benchmark::DoNotOptimize(t);
+            ++tokens;
+        }
+    }
+    report(state, input, tokens, before);
+}
+BENCHMARK(BM_TokenizerCopying)->Arg(1 << 10)->Arg(1 << 20);
+
+void BM_TokenizerView(benchmark::State &state) {
+    std::string input = corpus(state.range(0));
+    size_t tokens = 0;
+    size_t before = alloc_counter::allocations();
+    for (auto _ : state) {
+        ViewTokenizer tokenizer(input);
+        tokens = 0;
+        for (TokenView t = tokenizer.next(); t.type != Token::Type::END; t = tokenizer.next()) {
+            benchmark::DoNotOptimize(t);
+            ++tokens;
+        }
+    }
+    report(state, input, tokens, before);
+}
+BENCHMARK(BM_TokenizerView)->Arg(1 << 10)->Arg(1 << 20);
+
+}  // namespace
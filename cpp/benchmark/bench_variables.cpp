@@ -0,0 +1,69 @@
+#include <benchmark/benchmark.h>
+
+#include "alloc_counter.h"
+#include "bytecode.h"
+#include "parser.h"
+
+namespace {
+
+const char *kFormula = "x * 3 + y / 2 - (x - y) * 7";
+
+void reportAllocations(benchmark::State &state, size_t before) {
+    state.counters["allocs/eval"] = benchmark::Counter(
+        double(alloc_counter::allocations() - before) / double(state.iterations()));
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Baseline: substitute the values into the text and parse every time.
+void BM_ReparsePerRow(benchmark::State &state) {
+    Parser parser;
+    Arena arena;
+    int64_t row = 0;
+    size_t before = alloc_counter::allocations();
+    for (auto _ : state) {
+        std::string x = std::to_string(row), y = std::to_string(row + 1);
+        std::string text = x + " * 3 + " + y + " / 2 - (" + x + " - " + y + ") * 7";
+        IExpression *expr = parser.parse(text, arena);
+        benchmark::DoNotOptimize(expr->getValue());
+        arena.reset();
+        ++row;
+    }
+    reportAllocations(state, before);
+}
+BENCHMARK(BM_ReparsePerRow);
+
+void BM_TreeRebind(benchmark::State &state) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena(kFormula);
+    size_t x = table.find("x"), y = table.find("y");
+    int64_t row = 0;
+    size_t before = alloc_counter::allocations();
+    for (auto _ : state) {
+        table.set(x, row);
+        table.set(y, row + 1);
+        benchmark::DoNotOptimize(parsed->getValue());
+        ++row;
+    }
+    reportAllocations(state, before);
+}
+BENCHMARK(BM_TreeRebind);
+
+void BM_CompiledRebind(benchmark::State &state) {
+    CompiledExpression expr(kFormula);
+    size_t x = expr.slot("x"), y = expr.slot("y");
+    int64_t values[2];
+    int64_t row = 0;
+    size_t before = alloc_counter::allocations();
+    for (auto _ : state) {
+        values[x] = row;
+        values[y] = row + 1;
+        benchmark::DoNotOptimize(expr.evaluate(values));
+        ++row;
+    }
+    reportAllocations(state, before);
+}
+BENCHMARK(BM_CompiledRebind);
+
+}  // namespace
@@ -0,0 +1,69 @@
+#ifndef CORPUS_H_
+#define CORPUS_H_
+
+#include <cstddef>
+#include <string>
+
+// Deterministic expression corpus shared by the core benchmarks. Every
+// shape is generated from a fixed formula, so results stay comparable
+// between runs and releases.
+namespace corpus {
+
+enum Shape {
+    SHORT,         // a handful of tokens, the common interactive case
+    LONG,          // ~4 KiB of mixed operators and parentheses
+    DEEP,          // 2000 nested groups around a single sum
+    WIDE,          // 2000 terms joined by operators at one level
+    NUMBER_HEAVY,  // long multi-digit literals with few operators
+    SHAPE_COUNT
+};
+
+inline const char *name(int shape) {
+    static const char *names[] = {"short", "long", "deep", "wide", "number_heavy"};
+    return names[shape];
+}
+
+inline std::string generate(int shape) {
+    std::string s;
+    switch (shape) {
+    case SHORT:
+        s = "(3 + 4) * (2 - 1) / 5";
+        break;
+    case LONG:
+        s = "1";
+        for (int i = 0; s.size() < 4096; ++i) {
+            s += " + (";
+            s += std::to_string(i * 7919 % 1000 + 1);
+            s += " * ";
+            s += std::to_string(i % 13 + 1);
+            s += " - 42) / 3";
+        }
+        break;
+    case DEEP:
+        for (int i = 0; i < 2000; ++i) s += "(1+";
+        s += "1";
+        s.append(2000, ')');
+        break;
+    case WIDE: {
+        static const char ops[] = {'+', '-', '*', '+'};
+        s = "1";
+        for (int i = 0; i < 2000; ++i) {
+            s += ops[i % 4];
+            s += std::to_string(i % 9 + 1);
+        }
+        break;
+    }
+    case NUMBER_HEAVY:
+        s = "1000000000";
+        for (int i = 0; i < 256; ++i) {
+            s += (i % 2) ? " - " : " + ";
+            s += std::to_string(1000000000 + i * 1234567);
+        }
+        break;
+    }
+    return s;
+}
+
+}  // namespace corpus
+
+#endif  // CORPUS_H_
@@ -0,0 +1,259 @@
+#include <cmath>
+#include <stdexcept>
+
+#include "bigint.h"
+
+BigInt::BigInt(int64_t value) {
+    negative = value < 0;
+    // Negate as unsigned so INT64_MIN is representable.
+    uint64_t magnitude = negative ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    while (magnitude) {
+        limbs.push_back(static_cast<uint32_t>(magnitude));
+        magnitude >>= 32;
+    }
+}
+
+BigInt BigInt::parse(std::string_view text) {
+    bool minus = !text.empty() && text[0] == '-';
+    if (minus) text.remove_prefix(1);
+    if (text.empty()) throw std::invalid_argument("Invalid integer");
+    BigInt result;
+    // Nine decimal digits at a time fit one limb multiply-add.
+    for (size_t i = 0; i < text.size();) {
+        size_t n = std::min<size_t>(9, text.size() - i);
+        uint32_t chunk = 0, scale = 1;
+        for (size_t k = 0; k < n; ++k, ++i) {
+            char c = text[i];
+            if (c < '0' || c > '9') throw std::invalid_argument("Invalid integer");
+            chunk = chunk * 10 + static_cast<uint32_t>(c - '0');
+            scale *= 10;
+        }
+        uint64_t carry = chunk;
+        for (uint32_t &limb : result.limbs) {
+            uint64_t v = uint64_t(limb) * scale + carry;
+            limb = static_cast<uint32_t>(v);
+            carry = v >> 32;
+        }
+        if (carry) result.limbs.push_back(static_cast<uint32_t>(carry));
+    }
+    result.trim();
+    result.negative = minus && !result.isZero();
+    return result;
+}
+
+void BigInt::trim() {
+    while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+    if (limbs.empty()) negative = false;
+}
+
+bool BigInt::toInt64(int64_t &out) const {
+    if (limbs.size() > 2) return false;
+    uint64_t magnitude = 0;
+    for (size_t i = limbs.size(); i-- > 0;) magnitude = (magnitude << 32) | limbs[i];
+    if (negative) {
+        if (magnitude > uint64_t(INT64_MAX) + 1) return false;
+        out = static_cast<int64_t>(0 - magnitude);
+    } else {
+        if (magnitude > uint64_t(INT64_MAX)) return false;
+        out = static_cast<int64_t>(magnitude);
+    }
+    return true;
+}
+
+double BigInt::toDouble() const {
+    double v = 0;
+    for (size_t i = limbs.size(); i-- > 0;) v = v * 4294967296.0 + limbs[i];
+    return negative ? -v : v;
+}
+
+uint32_t BigInt::divSmall(uint32_t divisor) {
+    uint64_t rem = 0;
+    for (size_t i = limbs.size(); i-- > 0;) {
+        uint64_t cur = (rem << 32) | limbs[i];
+        limbs[i] = static_cast<uint32_t>(cur / divisor);
+        rem = cur % divisor;
+    }
+    trim();
+    return static_cast<uint32_t>(rem);
+}
+
+std::string BigInt::toString() const {
+    if (isZero()) return "0";
+    BigInt tmp = *this;
+    std::string digits;
+    while (!tmp.isZero()) {
+        uint32_t chunk = tmp.divSmall(1000000000);
+        for (int k = 0; k < 9; ++k) {
+            digits.push_back(static_cast<char>('0' + chunk % 10));
+            chunk /= 10;
+            if (tmp.isZero() && chunk == 0) break;
+        }
+    }
+    if (negative) digits.push_back('-');
+    return std::string(digits.rbegin(), digits.rend());
+}
+
+int BigInt::compareMagnitude(const BigInt &a, const BigInt &b) {
+    if (a.limbs.size() != b.limbs.size()) return a.limbs.size() < b.limbs.size() ? -1 : 1;
+    for (size_t i = a.limbs.size(); i-- > 0;) {
+        if (a.limbs[i] != b.limbs[i]) return a.limbs[i] < b.limbs[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+bool operator<(const BigInt &a, const BigInt &b) {
+    if (a.negative != b.negative) return a.negative;
+    int c = BigInt::compareMagnitude(a, b);
+    return a.negative ? c > 0 : c < 0;
+}
+
+void BigInt::addMagnitude(BigInt &out, const BigInt &a, const BigInt &b) {
+    const BigInt &longer = a.limbs.size() >= b.limbs.size() ? a : b;
+    const BigInt &shorter = a.limbs.size() >= b.limbs.size() ? b : a;
+    std::vector<uint32_t> sum(longer.limbs.size() + 1);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < longer.limbs.size(); ++i) {
+        uint64_t v = uint64_t(longer.limbs[i]) + carry +
+                     (i < shorter.limbs.size() ? shorter.limbs[i] : 0);
+        sum[i] = static_cast<uint32_t>(v);
+        carry = v >> 32;
+    }
+    sum.back() = static_cast<uint32_t>(carry);
+    out.limbs.swap(sum);
+}
+
+void BigInt::subMagnitude(BigInt &out, const BigInt &a, const BigInt &b) {
+    std::vector<uint32_t> diff(a.limbs.size());
+    int64_t borrow = 0;
+    for (size_t i = 0; i < a.limbs.size(); ++i) {
+        int64_t v = int64_t(a.limbs[i]) - borrow - (i < b.limbs.size() ? int64_t(b.limbs[i]) : 0);
+        borrow = v < 0;
+        diff[i] = static_cast<uint32_t>(v + (borrow << 32));
+    }
+    out.limbs.swap(diff);
+}
+
+BigInt BigInt::operator-() const {
+    BigInt r = *this;
+    if (!r.isZero()) r.negative = !r.negative;
+    return r;
+}
+
+BigInt &BigInt::operator+=(const BigInt &o) {
+    if (negative == o.negative) {
+        addMagnitude(*this, *this, o);
+    } else if (compareMagnitude(*this, o) >= 0) {
+        subMagnitude(*this, *this, o);
+    } else {
+        subMagnitude(*this, o, *this);
+        negative = o.negative;
+    }
+    trim();
+    return *this;
+}
+
+BigInt &BigInt::operator-=(const BigInt &o) {
+    return *this += -o;
+}
+
+BigInt &BigInt::operator*=(const BigInt &o) {
+    if (isZero() || o.isZero()) {
+        limbs.clear();
+        negative = false;
+        return *this;
+    }
+    std::vector<uint32_t> product(limbs.size() + o.limbs.size());
+    for (size_t i = 0; i < limbs.size(); ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < o.limbs.size(); ++j) {
+            uint64_t v = uint64_t(limbs[i]) * o.limbs[j] + product[i + j] + carry;
+            product[i + j] = static_cast<uint32_t>(v);
+            carry = v >> 32;
+        }
+        product[i + o.limbs.size()] = static_cast<uint32_t>(carry);
+    }
+    limbs.swap(product);
+    negative = negative != o.negative;
+    trim();
+    return *this;
+}
+
+size_t BigInt::bitLength() const {
+    if (limbs.empty()) return 0;
+    return (limbs.size() - 1) * 32 + (32 - __builtin_clz(limbs.back()));
+}
+
+void BigInt::divMod(const BigInt &a, const BigInt &b, BigInt *quotient, BigInt *remainder) {
+    if (b.isZero()) throw std::runtime_error("Divide by zero");
+    BigInt q, r;
+    if (b.limbs.size() == 1) {
+        q = a;
+        q.negative = false;
+        r = BigInt(static_cast<int64_t>(q.divSmall(b.limbs[0])));
+    } else if (compareMagnitude(a, b) >= 0) {
+        // Binary long division on magnitudes, one bit of a at a time.
+        BigInt divisor = b.abs();
+        q.limbs.assign(a.limbs.size(), 0);
+        for (size_t bit = a.bitLength(); bit-- > 0;) {
+            // r = r * 2 + next bit
+            uint32_t carry = (a.limbs[bit / 32] >> (bit % 32)) & 1;
+            for (uint32_t &limb : r.limbs) {
+                uint32_t top = limb >> 31;
+                limb = (limb << 1) | carry;
+                carry = top;
+            }
+            if (carry) r.limbs.push_back(carry);
+            if (compareMagnitude(r, divisor) >= 0) {
+                subMagnitude(r, r, divisor);
+                r.trim();
+                q.limbs[bit / 32] |= uint32_t(1) << (bit % 32);
+            }
+        }
+        q.trim();
+    } else {
+        r = a.abs();
+    }
+    // Truncation: the quotient takes the sign of a*b, the remainder of a.
+    q.negative = !q.isZero() && (a.negative != b.negative);
+    r.negative = !r.isZero() && a.negative;
+    if (quotient) *quotient = std::move(q);
+    if (remainder) *remainder = std::move(r);
+}
+
+BigInt &BigInt::operator/=(const BigInt &o) {
+    divMod(*this, o, this, nullptr);
+    return *this;
+}
+
+BigInt &BigInt::operator%=(const BigInt &o) {
+    divMod(*this, o, nullptr, this);
+    return *this;
+}
+
+BigInt BigInt::abs() const {
+    BigInt r = *this;
+    r.negative = false;
+    return r;
+}
+
+BigInt BigInt::sqrt() const {
+    if (negative) throw std::runtime_error("Invalid argument to sqrt");
+    if (isZero()) return BigInt();
+    // Newton's iteration from a power of two above the root decreases
+    // monotonically to the floor of the root.
+    BigInt x;
+    size_t bits = (bitLength() + 1) / 2 + 1;
+    x.limbs.assign(bits / 32 + 1, 0);
+    x.limbs[bits / 32] = uint32_t(1) << (bits % 32);
+    x.trim();
+    while (true) {
+        BigInt next = (x + *this / x);
+        next.divSmall(2);
+        if (!(next < x)) return x;
+        x = std::move(next);
+    }
+}
+
+std::ostream &operator<<(std::ostream &os, const BigInt &value) {
+    return os << value.toString();
+}
@@ -0,0 +1,66 @@
+#ifndef BIGINT_H_
+#define BIGINT_H_
+
+#include<cstdint>
+#include<iostream>
+#include<string>
+#include<string_view>
+#include<vector>
+
+// Arbitrary-precision signed integer: sign and magnitude, the magnitude in
+// little-endian 32-bit limbs with no leading zero limbs (zero has none).
+// Division truncates toward zero like the built-in integers.
+class BigInt {
+    std::vector<uint32_t> limbs;
+    bool negative = false;
+
+    void trim();
+    static int compareMagnitude(const BigInt &a, const BigInt &b);
+    static void addMagnitude(BigInt &out, const BigInt &a, const BigInt &b);
+    // Requires |a| >= |b|.
+    static void subMagnitude(BigInt &out, const BigInt &a, const BigInt &b);
+    static void divMod(const BigInt &a, const BigInt &b, BigInt *quotient, BigInt *remainder);
+    uint32_t divSmall(uint32_t divisor);
+    size_t bitLength() const;
+public:
+    BigInt() = default;
+    BigInt(int64_t value);
+    // Decimal digits with an optional leading '-'; throws
+    // std::invalid_argument otherwise.
+    static BigInt parse(std::string_view text);
+
+    bool isZero() const { return limbs.empty(); }
+    bool isNegative() const { return negative; }
+    // True when the value fits, and then stores it in out.
+    bool toInt64(int64_t &out) const;
+    double toDouble() const;
+    std::string toString() const;
+
+    BigInt operator-() const;
+    BigInt &operator+=(const BigInt &o);
+    BigInt &operator-=(const BigInt &o);
+    BigInt &operator*=(const BigInt &o);
+    // Throws std::runtime_error on division by zero.
+    BigInt &operator/=(const BigInt &o);
+    BigInt &operator%=(const BigInt &o);
+
+    friend BigInt operator+(BigInt a, const BigInt &b) { return a += b; }
+    friend BigInt operator-(BigInt a, const BigInt &b) { return a -= b; }
+    friend BigInt operator*(BigInt a, const BigInt &b) { return a *= b; }
+    friend BigInt operator/(BigInt a, const BigInt &b) { return a /= b; }
+    friend BigInt operator%(BigInt a, const BigInt &b) { return a %= b; }
+
+    friend bool operator==(const BigInt &a, const BigInt &b) {
+        return a.negative == b.negative && a.limbs == b.limbs;
+    }
+    friend bool operator!=(const BigInt &a, const BigInt &b) { return !(a == b); }
+    friend bool operator<(const BigInt &a, const BigInt &b);
+
+    BigInt abs() const;
+    // Floor of the square root; throws std::runtime_error when negative.
+    BigInt sqrt() const;
+};
+
+std::ostream &operator<<(std::ostream &os, const BigInt &value);
+
+#endif  // BIGINT_H_
@@ -0,0 +1,146 @@
+#include <stdexcept>
+
+#include "bytecode.h"
+#include "parser.h"
+#include "stats.h"
+#include "functions.h"
+#include "tree_eval.h"
+
+namespace {
+// Stack slots available without touching the heap.
+constexpr size_t kInlineStack = 64;
+
+OpCode toOpCode(Operator op) {
+    switch (op) {
+    case Operator::ADD: return OpCode::ADD;
+    case Operator::SUB: return OpCode::SUB;
+    case Operator::MUL: return OpCode::MUL;
+    case Operator::DIV: return OpCode::DIV;
+    default:
+        throw std::runtime_error("Unknown operator");
+    }
+}
+}
+
+void BytecodeCompiler::emit(OpCode op, int64_t operand) {
+    program.code.push_back(Instruction{op, operand});
+    if (op == OpCode::PUSH || op == OpCode::LOAD) {
+        if (++depth > program.maxDepth) program.maxDepth = depth;
+    } else if (op != OpCode::CALL) {
+        --depth;
+    }
+}
+
+void BytecodeCompiler::visitNumberNode(const NumberNode *expr) {
+    emit(OpCode::PUSH, expr->getValue());
+}
+
+void BytecodeCompiler::visitVariableNode(const VariableNode *expr) {
+    size_t slot = expr->getSlot();
+    if (slot + 1 > program.slots) program.slots = slot + 1;
+    emit(OpCode::LOAD, static_cast<int64_t>(slot));
+}
+
+// Operands have already been emitted: compile() visits in post-order.
+void BytecodeCompiler::visitBinaryNode(const BinaryNode *expr) {
+    emit(toOpCode(expr->op));
+}
+
+void BytecodeCompiler::visitUnaryFunctionNode(const UnaryFunctionNode *expr) {
+    emit(OpCode::CALL, static_cast<int64_t>(expr->op));
+}
+
+Program BytecodeCompiler::compile(const IExpression *expr) {
+    program = Program();
+    depth = 0;
+    acceptPostOrder(expr, this);
+    return std::move(program);
+}
+
+CompiledExpression::CompiledExpression(const std::string &input) {
+    Parser parser;
+    parser.setVariables(&vars);
+    ParsedExpression parsed = parser.parseInArena(input);
+    if (parsed) {
+        BytecodeCompiler compiler;
+        program = compiler.compile(parsed.get());
+        valid = true;
+    }
+}
+
+template<bool Throw>
+int64_t Program::run(const int64_t *variables, ErrorCode &error) const {
+    int64_t inlineStack[kInlineStack];
+    std::vector<int64_t> heapStack;
+    int64_t *stack = inlineStack;
+    if (maxDepth > kInlineStack) {
+        heapStack.resize(maxDepth);
+        stack = heapStack.data();
+    }
+
+    int64_t *sp = stack;  // points one past the top of the stack
+    for (const Instruction &ins : code) {
+        switch (ins.op) {
+        case OpCode::PUSH:
+            *sp++ = ins.operand;
+            break;
+        case OpCode::LOAD:
+            *sp++ = variables[ins.operand];
+            break;
+        case OpCode::ADD:
+            --sp;
+            sp[-1] = wrappingAdd(sp[-1], sp[0]);
+            break;
+        case OpCode::SUB:
+            --sp;
+            sp[-1] = wrappingSub(sp[-1], sp[0]);
+            break;
+        case OpCode::MUL:
+            --sp;
+            sp[-1] = wrappingMul(sp[-1], sp[0]);
+            break;
+        case OpCode::DIV:
+            --sp;
+            if (sp[0] == 0) {
+                if (Throw) throw std::runtime_error("Divide by zero");
+                error = ErrorCode::DIVIDE_BY_ZERO;
+                return 0;
+            }
+            if (sp[0] == -1 && sp[-1] == INT64_MIN) {
+                if (Throw) throw std::overflow_error("Division overflow");
+                error = ErrorCode::DIVIDE_OVERFLOW;
+                return 0;
+            }
+            sp[-1] = sp[-1] / sp[0];
+            break;
+        case OpCode::CALL:
+            if (Throw) {
+                sp[-1] = applyFunction(static_cast<Operator>(ins.operand), sp[-1]);
+            } else if (functionInfo(static_cast<Operator>(ins.operand)).batch(sp - 1, sp - 1, 1) != 1) {
+                error = ErrorCode::DOMAIN_ERROR;
+                return 0;
+            }
+            break;
+        }
+    }
+    if (sp != stack + 1) {
+        if (Throw) throw std::runtime_error("Malformed program");
+        error = ErrorCode::MALFORMED_PROGRAM;
+        return 0;
+    }
+    return stack[0];
+}
+
+int64_t Program::execute(const int64_t *variables) const {
+    EXPR_STATS_TIMER(timer, stats::Metric::EVALUATE_NS);
+    ErrorCode unused;
+    return run<true>(variables, unused);
+}
+
+Result<int64_t> Program::tryExecute(const int64_t *variables) const {
+    EXPR_STATS_TIMER(timer, stats::Metric::EVALUATE_NS);
+    ErrorCode error = ErrorCode::NONE;
+    int64_t value = run<false>(variables, error);
+    if (error != ErrorCode::NONE) return Error{error};
+    return value;
+}
@@ -0,0 +1,82 @@
+#ifndef BYTECODE_H_
+#define BYTECODE_H_
+
+#include<cstdint>
+#include<vector>
+
+#include "visitor.h"
+#include "expression.h"
+
+enum class OpCode : uint8_t {
+    PUSH,   // push the inline constant
+    LOAD,   // push the variable in the slot given by the operand
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    CALL    // apply the built-in function (an Operator) in the operand to the top
+};
+
+struct Instruction {
+    OpCode op;
+    int64_t operand;  // constant for PUSH, slot for LOAD, function for CALL
+};
+
+// Expression lowered to postfix order: operands are pushed on a value
+// stack, every operator pops two values and pushes its result, and a
+// function call replaces the top value.
+class Program {
+    std::vector<Instruction> code;
+    size_t maxDepth = 0;
+    size_t slots = 0;
+    friend class BytecodeCompiler;
+    // Interpreter loop shared by execute() (Throw) and tryExecute().
+    template<bool Throw>
+    int64_t run(const int64_t *variables, ErrorCode &error) const;
+public:
+    // Runs the program with variable slot i bound to variables[i]; throws
+    // std::runtime_error on divide by zero, INT64_MIN / -1 or a function
+    // domain error, exactly like BinaryNode::getValue(). Does not allocate
+    // unless the program needs an unusually deep value stack.
+    int64_t execute(const int64_t *variables = nullptr) const;
+    // Same, reporting DIVIDE_BY_ZERO, DIVIDE_OVERFLOW, DOMAIN_ERROR or
+    // MALFORMED_PROGRAM instead of throwing.
+    Result<int64_t> tryExecute(const int64_t *variables = nullptr) const;
+    const std::vector<Instruction> &instructions() const { return code; }
+    size_t stackDepth() const { return maxDepth; }
+    // Number of variable slots the program reads (highest slot + 1).
+    size_t variableCount() const { return slots; }
+    bool empty() const { return code.empty(); }
+};
+
+// Lowers an IExpression tree into a Program.
+class BytecodeCompiler : public IVisitor {
+    Program program;
+    size_t depth = 0;
+    void emit(OpCode op, int64_t operand = 0);
+public:
+    void visitNumberNode(const NumberNode *expr) override;
+    void visitBinaryNode(const BinaryNode *expr) override;
+    void visitVariableNode(const VariableNode *expr) override;
+    void visitUnaryFunctionNode(const UnaryFunctionNode *expr) override;
+    Program compile(const IExpression *expr);
+};
+
+// Parses once and evaluates many times: owns the variable table the
+// expression was parsed against and the program compiled from it.
+class CompiledExpression {
+    VariableTable vars;
+    Program program;
+    bool valid = false;
+public:
+    explicit CompiledExpression(const std::string &input);
+    bool ok() const { return valid; }
+    const VariableTable &variables() const { return vars; }
+    const Program &code() const { return program; }
+    // Slot of a variable, or VariableTable::npos if the expression does not use it.
+    size_t slot(const std::string &name) const { return vars.find(name); }
+    // values[i] is the value bound to slot i.
+    int64_t evaluate(const int64_t *values) const { return program.execute(values); }
+};
+
+#endif  // BYTECODE_H_
@@ -0,0 +1,119 @@
+#include <array>
+
+#include "charclass.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CHARCLASS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace charclass {
+
+namespace {
+
+using Nibbles = std::array<uint8_t, 16>;
+
+// Classes per low nibble.
+constexpr Nibbles kLow = {
+    DIGIT | UPPER_HIGH | BLANK,                   // 0
+    DIGIT | UPPER_LOW | UPPER_HIGH,               // 1
+    DIGIT | UPPER_LOW | UPPER_HIGH,
+    DIGIT | UPPER_LOW | UPPER_HIGH,
+    DIGIT | UPPER_LOW | UPPER_HIGH,
+    DIGIT | UPPER_LOW | UPPER_HIGH,
+    DIGIT | UPPER_LOW | UPPER_HIGH,
+    DIGIT | UPPER_LOW | UPPER_HIGH,
+    DIGIT | UPPER_LOW | UPPER_HIGH,               // 8
+    DIGIT | UPPER_LOW | UPPER_HIGH | CONTROL_SPACE,
+    UPPER_LOW | UPPER_HIGH | CONTROL_SPACE,       // a
+    UPPER_LOW | CONTROL_SPACE,
+    UPPER_LOW | CONTROL_SPACE,
+    UPPER_LOW | CONTROL_SPACE,                    // d
+    UPPER_LOW,
+    UPPER_LOW,                                    // f
+};
+
+// Classes per high nibble.
+constexpr Nibbles kHigh = {
+    CONTROL_SPACE, 0, BLANK, DIGIT,
+    UPPER_LOW, UPPER_HIGH, UPPER_LOW, UPPER_HIGH,
+    0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+constexpr std::array<uint8_t, 256> makeTable() {
+    std::array<uint8_t, 256> table{};
+    for (int c = 0; c < 256; ++c) table[c] = kLow[c & 15] & kHigh[c >> 4];
+    return table;
+}
+
+#ifdef CHARCLASS_X86
+
+__attribute__((target("ssse3")))
+size_t skipSSSE3(const char *data, size_t i, size_t size, uint8_t mask) {
+    const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kLow.data()));
+    const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kHigh.data()));
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i want = _mm_set1_epi8(static_cast<char>(mask));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= size; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i lo = _mm_shuffle_epi8(low, _mm_and_si128(bytes, nibble));
+        __m128i hi = _mm_shuffle_epi8(high, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+        __m128i cls = _mm_and_si128(_mm_and_si128(lo, hi), want);
+        int outside = _mm_movemask_epi8(_mm_cmpeq_epi8(cls, zero));
+        if (outside) return i + __builtin_ctz(outside);
+    }
+    return skipScalar(data, i, size, mask);
+}
+
+__attribute__((target("avx2")))
+size_t skipAVX2(const char *data, size_t i, size_t size, uint8_t mask) {
+    const __m256i low = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(kLow.data())));
+    const __m256i high = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(kHigh.data())));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i want = _mm256_set1_epi8(static_cast<char>(mask));
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 32 <= size; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        __m256i lo = _mm256_shuffle_epi8(low, _mm256_and_si256(bytes, nibble));
+        __m256i hi = _mm256_shuffle_epi8(high, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble));
+        __m256i cls = _mm256_and_si256(_mm256_and_si256(lo, hi), want);
+        unsigned outside = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(cls, zero)));
+        if (outside) return i + __builtin_ctz(outside);
+    }
+    return skipSSSE3(data, i, size, mask);
+}
+
+const bool hasAVX2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+}();
+
+const bool hasSSSE3 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3") != 0;
+}();
+
+#endif  // CHARCLASS_X86
+
+}  // namespace
+
+const std::array<uint8_t, 256> kTable = makeTable();
+
+size_t skipScalar(const char *data, size_t from, size_t size, uint8_t mask) {
+    size_t i = from;
+    while (i < size && (classify(data[i]) & mask)) ++i;
+    return i;
+}
+
+size_t skipRun(const char *data, size_t from, size_t size, uint8_t mask) {
+#ifdef CHARCLASS_X86
+    if (hasAVX2) return skipAVX2(data, from, size, mask);
+    if (hasSSSE3) return skipSSSE3(data, from, size, mask);
+#endif
+    return skipScalar(data, from, size, mask);
+}
+
+}  // namespace charclass
@@ -0,0 +1,55 @@
+#ifndef CHARCLASS_H_
+#define CHARCLASS_H_
+
+#include<array>
+#include<cstddef>
+#include<cstdint>
+
+// Locale-independent ASCII character classes for the tokenizers. A byte's
+// class is lo[c & 15] & hi[c >> 4] over two 16-entry tables, which is a
+// single table lookup per byte in scalar code and two pshufb per 16 or 32
+// bytes in vector code. Every class bit covers a rectangle of the
+// high/low nibble grid, which is why letters and spaces take two bits each.
+namespace charclass {
+
+enum : uint8_t {
+    DIGIT = 1 << 0,         // 0-9
+    UPPER_LOW = 1 << 1,     // A-O, a-o
+    UPPER_HIGH = 1 << 2,    // P-Z, p-z
+    CONTROL_SPACE = 1 << 3, // \t \n \v \f \r
+    BLANK = 1 << 4,         // ' '
+
+    ALPHA = UPPER_LOW | UPPER_HIGH,
+    ALNUM = DIGIT | ALPHA,
+    SPACE = CONTROL_SPACE | BLANK,
+};
+
+// Class bits of every byte; bytes >= 0x80 have none.
+extern const std::array<uint8_t, 256> kTable;
+
+inline uint8_t classify(char c) { return kTable[static_cast<unsigned char>(c)]; }
+inline bool isSpace(char c) { return classify(c) & SPACE; }
+inline bool isDigit(char c) { return classify(c) & DIGIT; }
+inline bool isAlpha(char c) { return classify(c) & ALPHA; }
+inline bool isAlnum(char c) { return classify(c) & ALNUM; }
+
+// skip() for runs known to cover data[from - 2, from); uses AVX2 or SSSE3
+// when the CPU has them.
+size_t skipRun(const char *data, size_t from, size_t size, uint8_t mask);
+
+// Index of the first byte in data[from, size) whose class has none of the
+// bits in mask, or size. Most runs in expressions are short: a single space
+// between tokens, a one or two character name. Those are settled inline,
+// and only longer runs go to the vector loop.
+inline size_t skip(const char *data, size_t from, size_t size, uint8_t mask) {
+    if (from >= size || !(classify(data[from]) & mask)) return from;
+    if (from + 1 >= size || !(classify(data[from + 1]) & mask)) return from + 1;
+    return skipRun(data, from + 2, size, mask);
+}
+
+// Same as skip(), one byte at a time.
+size_t skipScalar(const char *data, size_t from, size_t size, uint8_t mask);
+
+}  // namespace charclass
+
+#endif  // CHARCLASS_H_
@@ -0,0 +1,125 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "dag.h"
+#include "functions.h"
+#include "tree_eval.h"
+
+size_t HashConsingFactory::KeyHash::operator()(const Key &k) const {
+    size_t h = std::hash<int64_t>()(k.value);
+    auto mix = [&h](size_t v) { h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2); };
+    mix(static_cast<size_t>(k.kind));
+    mix(static_cast<size_t>(k.real));
+    mix(static_cast<size_t>(k.op));
+    mix(reinterpret_cast<size_t>(k.left));
+    mix(reinterpret_cast<size_t>(k.right));
+    return h;
+}
+
+template<typename Make>
+IExpression *HashConsingFactory::intern(const Key &key, Make make) {
+    ++requests;
+    auto it = nodes.find(key);
+    if (it != nodes.end()) return it->second;
+    IExpression *node = make();
+    nodes.emplace(key, node);
+    return node;
+}
+
+IExpression *HashConsingFactory::createNumber(int64_t value) {
+    return intern(Key{IExpression::Kind::NUMBER, 0, value, nullptr, nullptr},
+                  [&] { return ExpressionFactory::createNumber(arena, value); });
+}
+
+IExpression *HashConsingFactory::createReal(double value) {
+    int64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    return intern(Key{IExpression::Kind::NUMBER, 0, bits, nullptr, nullptr, true},
+                  [&] { return ExpressionFactory::createReal(arena, value); });
+}
+
+IExpression *HashConsingFactory::createVariable(const VariableTable *table, size_t slot) {
+    return intern(Key{IExpression::Kind::VARIABLE, 0, static_cast<int64_t>(slot), table, nullptr},
+                  [&] { return ExpressionFactory::createVariable(arena, table, slot); });
+}
+
+IExpression *HashConsingFactory::createBinary(Operator op, IExpression *left, IExpression *right) {
+    return intern(Key{IExpression::Kind::BINARY, static_cast<int>(op), 0, left, right},
+                  [&] { return ExpressionFactory::createBinary(arena, op, left, right); });
+}
+
+IExpression *HashConsingFactory::createUnary(Operator op, IExpression *arg) {
+    return intern(Key{IExpression::Kind::UNARY, static_cast<int>(op), 0, arg, nullptr},
+                  [&] { return ExpressionFactory::createUnary(arena, op, arg); });
+}
+
+DagEvaluator::DagEvaluator(const IExpression *root) {
+    // A shared node is entered once; later references find it in seen.
+    walkPostOrder(root, [this](const IExpression *expr) { return !seen.count(expr); },
+                  [this](const IExpression *expr) { expr->accept(this); });
+    values.resize(order.size());
+}
+
+uint32_t DagEvaluator::indexOf(const IExpression *expr) const {
+    return seen.find(expr)->second;
+}
+
+void DagEvaluator::push(const IExpression *expr, const Node &node) {
+    seen.emplace(expr, static_cast<uint32_t>(order.size()));
+    order.push_back(node);
+}
+
+void DagEvaluator::visitNumberNode(const NumberNode *expr) {
+    push(expr, Node{IExpression::Kind::NUMBER, Operator::ADD, expr->getValue(), 0, 0});
+}
+
+void DagEvaluator::visitVariableNode(const VariableNode *expr) {
+    hasVariables = true;
+    push(expr, Node{IExpression::Kind::VARIABLE, Operator::ADD, static_cast<int64_t>(expr->getSlot()), 0, 0});
+}
+
+void DagEvaluator::visitBinaryNode(const BinaryNode *expr) {
+    push(expr, Node{IExpression::Kind::BINARY, expr->op, 0, indexOf(expr->left), indexOf(expr->right)});
+}
+
+void DagEvaluator::visitUnaryFunctionNode(const UnaryFunctionNode *expr) {
+    push(expr, Node{IExpression::Kind::UNARY, expr->op, 0, indexOf(expr->arg), 0});
+}
+
+int64_t DagEvaluator::evaluate(const int64_t *variables) {
+    if (order.empty()) throw std::runtime_error("Empty expression");
+    if (hasVariables && !variables) throw std::invalid_argument("Missing variable bindings");
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Node &n = order[i];
+        switch (n.kind) {
+        case IExpression::Kind::NUMBER:
+            values[i] = n.value;
+            break;
+        case IExpression::Kind::VARIABLE:
+            values[i] = variables[n.value];
+            break;
+        case IExpression::Kind::UNARY:
+            values[i] = applyFunction(n.op, values[n.left]);
+            break;
+        case IExpression::Kind::BINARY: {
+            int64_t l = values[n.left], r = values[n.right];
+            switch (n.op) {
+            case Operator::ADD: values[i] = wrappingAdd(l, r); break;
+            case Operator::SUB: values[i] = wrappingSub(l, r); break;
+            case Operator::MUL: values[i] = wrappingMul(l, r); break;
+            case Operator::DIV:
+                if (r == 0) throw std::runtime_error("Divide by zero");
+                if (l == INT64_MIN && r == -1) throw std::overflow_error("Division overflow");
+                values[i] = l / r;
+                break;
+            default:
+                throw std::runtime_error("Unknown operator");
+            }
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown node");
+        }
+    }
+    return values.back();
+}
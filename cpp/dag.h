@@ -0,0 +1,90 @@
+#ifndef DAG_H_
+#define DAG_H_
+
+#include<cstdint>
+#include<unordered_map>
+#include<vector>
+
+#include "visitor.h"
+#include "expression.h"
+
+// Factory that hash-conses nodes: asking twice for a structurally
+// identical node returns the same pointer, so repeated subexpressions are
+// stored once and trees become DAGs. Children are interned before their
+// parents, which makes structural identity of a parent the same as
+// pointer identity of its children. Nodes live in the given arena.
+class HashConsingFactory {
+    struct Key {
+        IExpression::Kind kind;
+        int op;
+        int64_t value;
+        const void *left;
+        const void *right;
+        bool real = false;  // value holds the bits of a double
+        bool operator==(const Key &o) const {
+            return kind == o.kind && op == o.op && value == o.value &&
+                   left == o.left && right == o.right && real == o.real;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key &k) const;
+    };
+
+    Arena &arena;
+    std::unordered_map<Key, IExpression *, KeyHash> nodes;
+    size_t requests = 0;
+
+    template<typename Make>
+    IExpression *intern(const Key &key, Make make);
+public:
+    explicit HashConsingFactory(Arena &arena) : arena(arena) {}
+    IExpression *createNumber(int64_t value);
+    IExpression *createReal(double value);
+    // Not shared: big literals are rare and would need their own key.
+    IExpression *createBigNumber(std::string_view digits) {
+        return ExpressionFactory::createBigNumber(arena, digits);
+    }
+    IExpression *createVariable(const VariableTable *table, size_t slot);
+    IExpression *createBinary(Operator op, IExpression *left, IExpression *right);
+    IExpression *createUnary(Operator op, IExpression *arg);
+
+    // Nodes asked for versus nodes actually allocated.
+    size_t requested() const { return requests; }
+    size_t unique() const { return nodes.size(); }
+};
+
+// Evaluates a DAG computing every shared node once: the nodes are laid out
+// in topological order and each one reads its operands from the values of
+// earlier nodes. Not safe to call evaluate() concurrently on one instance.
+class DagEvaluator : public IVisitor {
+    struct Node {
+        IExpression::Kind kind;
+        Operator op;
+        int64_t value;  // constant or variable slot
+        uint32_t left;  // operand, or the argument of a function
+        uint32_t right;
+    };
+    std::vector<Node> order;
+    std::vector<int64_t> values;
+    std::unordered_map<const IExpression *, uint32_t> seen;
+    bool hasVariables = false;
+
+    uint32_t indexOf(const IExpression *expr) const;
+    void push(const IExpression *expr, const Node &node);
+public:
+    explicit DagEvaluator(const IExpression *root);
+    // Called in post-order by the constructor, once per distinct node.
+    void visitNumberNode(const NumberNode *expr) override;
+    void visitBinaryNode(const BinaryNode *expr) override;
+    void visitVariableNode(const VariableNode *expr) override;
+    void visitUnaryFunctionNode(const UnaryFunctionNode *expr) override;
+
+    // Variable slot i reads variables[i]; throws std::invalid_argument if
+    // the DAG has variables and none are given, std::runtime_error on
+    // divide by zero, INT64_MIN / -1 or a function domain error.
+    int64_t evaluate(const int64_t *variables = nullptr);
+    // Distinct nodes evaluated per call.
+    size_t size() const { return order.size(); }
+};
+
+#endif  // DAG_H_
@@ -0,0 +1,504 @@
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "eval_server.h"
+#include "batch.h"
+#include "charclass.h"
+#include "parser.h"
+
+namespace {
+
+constexpr size_t kNoGroup = static_cast<size_t>(-1);
+constexpr size_t kReadChunk = 1 << 16;
+// A connection whose unsent responses pass this stops being read until
+// the client catches up.
+constexpr size_t kMaxBacklog = 1 << 20;
+// Longest request line; a connection sending more without a newline is
+// dropped.
+constexpr size_t kMaxLine = 1 << 20;
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && charclass::isSpace(s.front())) s.remove_prefix(1);
+    while (!s.empty() && charclass::isSpace(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+template<typename T>
+bool parseInteger(std::string_view s, T &value) {
+    auto res = std::from_chars(s.data(), s.data() + s.size(), value);
+    return !s.empty() && res.ec == std::errc() && res.ptr == s.data() + s.size();
+}
+
+void appendInteger(std::string &out, int64_t value) {
+    char digits[24];
+    auto res = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, res.ptr - digits);
+}
+
+}  // namespace
+
+BatchEvaluator::BatchEvaluator(size_t cacheCapacity, const ExpressionLibrary *library, ResultCache *results)
+    : cache(cacheCapacity), library(library), memo(results) {}
+
+void BatchEvaluator::add(std::string_view line) {
+    Request request{line, static_cast<uint32_t>(bindings.size()), 0, {}};
+    size_t semi = line.find(';');
+    request.target = line.substr(0, semi);
+    while (semi != std::string_view::npos) {
+        size_t start = semi + 1;
+        semi = line.find(';', start);
+        std::string_view item = line.substr(start, semi == std::string_view::npos ? semi : semi - start);
+        if (trim(item).empty()) continue;
+        size_t eq = item.find('=');
+        Binding binding{};
+        if (eq != std::string_view::npos) {
+            binding.name = trim(item.substr(0, eq));
+        }
+        if (eq == std::string_view::npos || binding.name.empty() ||
+            !parseInteger(trim(item.substr(eq + 1)), binding.value)) {
+            request.error = {ErrorCode::MALFORMED_REQUEST, static_cast<uint32_t>(start),
+                             static_cast<uint32_t>(item.size())};
+            break;
+        }
+        bindings.push_back(binding);
+    }
+    request.bindingCount = static_cast<uint32_t>(bindings.size() - request.firstBinding);
+    requests.push_back(request);
+}
+
+size_t BatchEvaluator::groupFor(const Request &request, Error &error) {
+    std::string_view target = trim(request.target);
+    if (!target.empty() && target.front() == '#') {
+        size_t formula;
+        if (!parseInteger(trim(target.substr(1)), formula)) {
+            error = {ErrorCode::MALFORMED_REQUEST, static_cast<uint32_t>(target.data() - request.target.data()),
+                     static_cast<uint32_t>(target.size())};
+            return kNoGroup;
+        }
+        if (!library || formula >= library->size()) {
+            error = {ErrorCode::UNKNOWN_FORMULA};
+            return kNoGroup;
+        }
+        auto found = formulaGroups.find(formula);
+        if (found != formulaGroups.end()) return found->second;
+        groupList.push_back({nullptr, formula, {}});
+        formulaGroups.emplace(formula, groupList.size() - 1);
+        return groupList.size() - 1;
+    }
+
+    auto found = textGroups.find(request.target);
+    if (found != textGroups.end()) return found->second;
+    std::shared_ptr<const CachedExpression> expression = cache.get(request.target);
+    if (!expression) {
+        // Failures are not cached; parse again for the error position.
+        VariableTable variables;
+        Parser parser;
+        parser.setVariables(&variables);
+        Arena arena;
+        error = parser.tryParse(request.target, arena).error();
+        return kNoGroup;
+    }
+    // Texts differing only in spacing share the cached parse, so they
+    // land in one group.
+    auto [shared, added] = expressionGroups.emplace(expression.get(), groupList.size());
+    if (added) groupList.push_back({std::move(expression), 0, {}});
+    textGroups.emplace(request.target, shared->second);
+    return shared->second;
+}
+
+void BatchEvaluator::evaluate() {
+    answers.assign(requests.size(), Result<int64_t>(int64_t(0)));
+    for (size_t i = 0; i < requests.size(); ++i) {
+        Error error = requests[i].error;
+        size_t group = error.code == ErrorCode::NONE ? groupFor(requests[i], error) : kNoGroup;
+        if (group == kNoGroup) {
+            answers[i] = error;
+        } else {
+            groupList[group].rows.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    for (const Group &group : groupList) {
+        if (group.expression) {
+            evaluateExpression(group);
+        } else {
+            evaluateFormula(group);
+        }
+    }
+    groupCount = groupList.size();
+    requests.clear();
+    bindings.clear();
+    groupList.clear();
+    textGroups.clear();
+    expressionGroups.clear();
+    formulaGroups.clear();
+    librarySlots.clear();
+}
+
+void BatchEvaluator::evaluateExpression(const Group &group) {
+    const CachedExpression &expression = *group.expression;
+    const Program &program = expression.program;
+    size_t rows = group.rows.size();
+    size_t slots = program.variableCount();
+
+    // Row-major: slot s of row r is rowData[r * slots + s].
+    rowData.assign(rows * slots, 0);
+    for (size_t r = 0; r < rows; ++r) {
+        const Request &request = requests[group.rows[r]];
+        for (uint32_t b = 0; b < request.bindingCount; ++b) {
+            const Binding &binding = bindings[request.firstBinding + b];
+            size_t slot = expression.variables.find(binding.name);
+            if (slot < slots) rowData[r * slots + slot] = binding.value;
+        }
+    }
+    misses.clear();
+    for (size_t r = 0; r < rows; ++r) {
+        const int64_t *values = rowData.data() + r * slots;
+        if (!memo || !memo->lookup(expression.id, values, slots, answers[group.rows[r]])) {
+            misses.push_back(static_cast<uint32_t>(r));
+        }
+    }
+    evaluateRows(program, group, slots);
+    if (memo) {
+        for (uint32_t r : misses) {
+            memo->insert(expression.id, rowData.data() + r * slots, slots, answers[group.rows[r]]);
+        }
+    }
+}
+
+void BatchEvaluator::evaluateRows(const Program &program, const Group &group, size_t slots) {
+    size_t rows = misses.size();
+    if (rows == 0) return;
+    if (rows == 1) {
+        answers[group.rows[misses[0]]] = program.tryExecute(rowData.data() + misses[0] * slots);
+        return;
+    }
+
+    // Column-major for evaluateBatch: slot s of the m-th miss is
+    // columnData[s * rows + m].
+    columnData.resize(slots * rows);
+    for (size_t m = 0; m < rows; ++m) {
+        for (size_t s = 0; s < slots; ++s) columnData[s * rows + m] = rowData[misses[m] * slots + s];
+    }
+    std::vector<ColumnView> columns;
+    columns.reserve(slots);
+    for (size_t s = 0; s < slots; ++s) columns.push_back({columnData.data() + s * rows, rows});
+    out.resize(rows);
+    try {
+        evaluateBatch(program, columns, rows, out.data());
+        for (size_t m = 0; m < rows; ++m) answers[group.rows[misses[m]]] = out[m];
+        return;
+    } catch (const RowError &) {
+        // Some row fails; give every row its own result.
+    }
+    for (uint32_t r : misses) answers[group.rows[r]] = program.tryExecute(rowData.data() + r * slots);
+}
+
+void BatchEvaluator::evaluateFormula(const Group &group) {
+    size_t slots = library->variableCount();
+    uint64_t id = library->formulaId(group.formula);
+    rowData.assign(slots, 0);
+    for (uint32_t row : group.rows) {
+        const Request &request = requests[row];
+        for (uint32_t b = 0; b < request.bindingCount; ++b) {
+            const Binding &binding = bindings[request.firstBinding + b];
+            auto found = librarySlots.find(binding.name);
+            if (found == librarySlots.end()) {
+                found = librarySlots.emplace(binding.name, library->findVariable(binding.name)).first;
+            }
+            if (found->second != VariableTable::npos) rowData[found->second] = binding.value;
+        }
+        if (!memo || !memo->lookup(id, rowData.data(), slots, answers[row])) {
+            answers[row] = library->tryEvaluate(group.formula, rowData.data());
+            if (memo) memo->insert(id, rowData.data(), slots, answers[row]);
+        }
+        for (uint32_t b = 0; b < request.bindingCount; ++b) {
+            size_t slot = librarySlots[bindings[request.firstBinding + b].name];
+            if (slot != VariableTable::npos) rowData[slot] = 0;
+        }
+    }
+}
+
+void formatResponse(const Result<int64_t> &result, std::string &out) {
+    if (result) {
+        appendInteger(out, *result);
+    } else {
+        const Error &error = result.error();
+        out += "error: ";
+        if (error.offset != Error::kNoOffset) {
+            out += "column ";
+            appendInteger(out, static_cast<int64_t>(error.offset) + 1);
+            out += ": ";
+        }
+        out += error.message();
+    }
+    out += '\n';
+}
+
+void ServerStats::print(std::ostream &os) const {
+    double perRound = rounds ? double(requests) / double(rounds) : 0;
+    os << "requests: " << requests << ", connections: " << connections
+       << ", rounds: " << rounds << ", requests/round: " << perRound
+       << ", throughput: " << throughput() << " req/s"
+       << ", p50: " << latencyNs.percentile(0.5) / 1000.0 << " us"
+       << ", p99: " << latencyNs.percentile(0.99) / 1000.0 << " us";
+}
+
+struct EvalServer::Connection {
+    int fd;
+    std::string in;
+    size_t consumed = 0;     // bytes of `in` already answered this round
+    std::string out;
+    size_t sent = 0;         // bytes of `out` already written
+    uint32_t events = EPOLLIN;
+    bool inRound = false;
+    bool closing = false;    // peer finished or failed; close once flushed
+
+    explicit Connection(int fd) : fd(fd) {}
+    bool drained() const { return sent == out.size(); }
+};
+
+EvalServer::EvalServer(std::string socketPath, const ExpressionLibrary *library, ResultCache *results)
+    : path(std::move(socketPath)), results(results), evaluator(4096, library, results) {}
+
+EvalServer::~EvalServer() {
+    for (auto &entry : connections) ::close(entry.first);
+    if (wakeFd >= 0) ::close(wakeFd);
+    if (epollFd >= 0) ::close(epollFd);
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        ::unlink(path.c_str());
+    }
+}
+
+bool EvalServer::listen() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) return false;
+    ::unlink(path.c_str());
+    if (::bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        ::listen(listenFd, SOMAXCONN) < 0) {
+        int saved = errno;
+        ::close(listenFd);
+        listenFd = -1;
+        errno = saved;
+        return false;
+    }
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) return false;
+    for (int fd : {listenFd, wakeFd}) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) return false;
+    }
+    startNs = nowNs();
+    return true;
+}
+
+void EvalServer::stop() {
+    uint64_t one = 1;
+    if (wakeFd >= 0 && ::write(wakeFd, &one, sizeof(one)) < 0) {
+        // Already signalled and not yet drained; nothing more to do.
+    }
+}
+
+bool EvalServer::run() {
+    constexpr int kMaxEvents = 64;
+    epoll_event events[kMaxEvents];
+    bool stopping = false;
+    while (!stopping) {
+        int n = ::epoll_wait(epollFd, events, kMaxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        uint64_t roundNs = nowNs();
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd) {
+                uint64_t count;
+                if (::read(wakeFd, &count, sizeof(count)) < 0) {
+                    // Nothing pending; the flag below is what matters.
+                }
+                stopping = true;
+            } else if (fd == listenFd) {
+                accept();
+            } else {
+                auto found = connections.find(fd);
+                if (found == connections.end()) continue;
+                Connection &conn = *found->second;
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) readFrom(conn);
+                if (events[i].events & EPOLLOUT) {
+                    flush(conn);
+                    if (conn.closing && conn.drained() && !conn.inRound) close(fd);
+                }
+            }
+        }
+        serveRound(roundNs);
+        counters.seconds = (nowNs() - startNs) / 1e9;
+    }
+    return true;
+}
+
+void EvalServer::accept() {
+    while (true) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;  // EAGAIN, or a connection that went away
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            ::close(fd);
+            continue;
+        }
+        connections.emplace(fd, std::make_unique<Connection>(fd));
+        ++counters.connections;
+    }
+}
+
+void EvalServer::readFrom(Connection &conn) {
+    if (conn.closing) return;
+    while (true) {
+        size_t used = conn.in.size();
+        conn.in.resize(used + kReadChunk);
+        ssize_t n = ::read(conn.fd, &conn.in[used], kReadChunk);
+        conn.in.resize(used + (n > 0 ? n : 0));
+        if (n > 0) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0 && errno == EINTR) continue;
+        conn.closing = true;
+        break;
+    }
+    if (!conn.inRound) {
+        conn.inRound = true;
+        active.push_back(&conn);
+    }
+}
+
+void EvalServer::flush(Connection &conn) {
+    while (!conn.drained()) {
+        ssize_t n = ::send(conn.fd, conn.out.data() + conn.sent, conn.out.size() - conn.sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.sent += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            // The peer is gone; drop what it will never read.
+            conn.closing = true;
+            conn.sent = conn.out.size();
+        }
+    }
+    if (conn.drained()) {
+        conn.out.clear();
+        conn.sent = 0;
+    }
+    watch(conn);
+}
+
+void EvalServer::watch(Connection &conn) {
+    uint32_t wanted = 0;
+    if (!conn.closing && conn.out.size() - conn.sent < kMaxBacklog) wanted |= EPOLLIN;
+    if (!conn.drained()) wanted |= EPOLLOUT;
+    if (wanted == conn.events) return;
+    epoll_event event{};
+    event.events = wanted;
+    event.data.fd = conn.fd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &event);
+    conn.events = wanted;
+}
+
+void EvalServer::close(int fd) {
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+}
+
+void EvalServer::serveRound(uint64_t roundNs) {
+    // Queue every complete line; the views point into the connections'
+    // input buffers, which are not touched again until the round ends.
+    for (Connection *conn : active) {
+        auto queue = [&](std::string_view line) {
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (line == "!stats") {
+                pending.push_back({conn, kStatsRequest});
+            } else {
+                pending.push_back({conn, evaluator.size()});
+                evaluator.add(line);
+            }
+        };
+        size_t pos = 0;
+        for (size_t nl; (nl = conn->in.find('\n', pos)) != std::string::npos; pos = nl + 1) {
+            queue(std::string_view(conn->in.data() + pos, nl - pos));
+        }
+        size_t rest = conn->in.size() - pos;
+        if (rest > kMaxLine) {
+            conn->closing = true;
+        } else if (rest && conn->closing) {
+            // The peer closed without a final newline; that is still a line.
+            queue(std::string_view(conn->in.data() + pos, rest));
+            pos = conn->in.size();
+        }
+        conn->consumed = pos;
+    }
+    if (evaluator.size()) {
+        evaluator.evaluate();
+        ++counters.rounds;
+        counters.groups += evaluator.groups();
+    }
+
+    for (const Pending &p : pending) {
+        if (p.request == kStatsRequest) {
+            std::ostringstream line;
+            counters.seconds = (nowNs() - startNs) / 1e9;
+            counters.print(line);
+            if (results) {
+                line << ", ";
+                results->stats().print(line);
+            }
+            line << '\n';
+            p.conn->out += line.str();
+        } else {
+            formatResponse(evaluator.results()[p.request], p.conn->out);
+        }
+    }
+    for (Connection *conn : active) {
+        conn->in.erase(0, conn->consumed);
+        conn->consumed = 0;
+        conn->inRound = false;
+        flush(*conn);
+    }
+    uint64_t doneNs = nowNs();
+    for (size_t i = 0; i < pending.size(); ++i) counters.latencyNs.record(doneNs - roundNs);
+    counters.requests += pending.size();
+    pending.clear();
+
+    for (Connection *conn : active) {
+        if (conn->closing && conn->drained()) close(conn->fd);
+    }
+    active.clear();
+}
@@ -0,0 +1,167 @@
+#ifndef EVAL_SERVER_H_
+#define EVAL_SERVER_H_
+
+#include<cstdint>
+#include<iostream>
+#include<memory>
+#include<string>
+#include<string_view>
+#include<unordered_map>
+#include<vector>
+
+#include "library.h"
+#include "parse_cache.h"
+#include "result.h"
+#include "result_cache.h"
+#include "stats.h"
+
+// Line protocol of the evaluation server. Every request is one line and
+// every request gets one response line; a connection may send any number
+// of requests without waiting, and its responses come back in request
+// order.
+//
+//   <expression>[; name=value]...   e.g. "x * y; x=3; y=-4"
+//   #<formula>[; name=value]...     formula index in the server's library
+//   !stats                          server counters, as one line
+//
+// A response is the value or "error: <reason>", with "column C: " before
+// the reason for errors in the request text. Unbound variables read 0,
+// and bindings for names the expression does not use are ignored.
+
+// Evaluates the requests of one event loop round together. Requests for
+// the same expression share one parse-cache lookup and, when there are
+// several, one evaluateBatch() pass with their bindings as the columns.
+// Library variable names are resolved once per round. With a ResultCache,
+// only the requests it cannot answer are evaluated.
+class BatchEvaluator {
+public:
+    explicit BatchEvaluator(size_t cacheCapacity = 4096, const ExpressionLibrary *library = nullptr,
+                            ResultCache *results = nullptr);
+
+    // Queues a request line, without its newline. The text must stay valid
+    // until evaluate() returns.
+    void add(std::string_view line);
+    size_t size() const { return requests.size(); }
+    // Evaluates everything queued; results()[i] answers the i-th add().
+    // The queue is empty afterwards.
+    void evaluate();
+    const std::vector<Result<int64_t>> &results() const { return answers; }
+    // Distinct expressions and formulas in the last evaluate().
+    size_t groups() const { return groupCount; }
+
+private:
+    struct Binding {
+        std::string_view name;
+        int64_t value;
+    };
+    struct Request {
+        std::string_view target;
+        uint32_t firstBinding;
+        uint32_t bindingCount;
+        Error error;
+    };
+    struct Group {
+        std::shared_ptr<const CachedExpression> expression;
+        size_t formula;
+        std::vector<uint32_t> rows;
+    };
+
+    ParseCache cache;
+    const ExpressionLibrary *library;
+    ResultCache *memo;
+    std::vector<Request> requests;
+    std::vector<Binding> bindings;
+    std::vector<Result<int64_t>> answers;
+    std::vector<Group> groupList;
+    size_t groupCount = 0;
+    // Scratch reused between rounds.
+    std::unordered_map<std::string_view, size_t> textGroups;
+    std::unordered_map<const CachedExpression *, size_t> expressionGroups;
+    std::unordered_map<size_t, size_t> formulaGroups;
+    std::unordered_map<std::string_view, size_t> librarySlots;
+    std::vector<int64_t> rowData;
+    std::vector<int64_t> columnData;
+    std::vector<int64_t> out;
+    std::vector<uint32_t> misses;   // rows of the group being evaluated
+
+    size_t groupFor(const Request &request, Error &error);
+    void evaluateExpression(const Group &group);
+    void evaluateRows(const Program &program, const Group &group, size_t slots);
+    void evaluateFormula(const Group &group);
+};
+
+// Appends the response line for a result, newline included.
+void formatResponse(const Result<int64_t> &result, std::string &out);
+
+struct ServerStats {
+    uint64_t connections = 0;   // accepted
+    uint64_t requests = 0;
+    uint64_t rounds = 0;        // loop rounds that evaluated requests
+    uint64_t groups = 0;        // summed BatchEvaluator::groups()
+    double seconds = 0;         // since listen()
+    // From the start of the loop round that read a request to the write
+    // of its response.
+    stats::Histogram latencyNs;
+
+    double throughput() const { return seconds > 0 ? requests / seconds : 0; }
+    // Requests, rounds, mean batch size, throughput, p50 and p99 on one
+    // line, without the newline.
+    void print(std::ostream &os) const;
+};
+
+// Single-threaded epoll server: all connections are non-blocking and
+// multiplexed on one loop, and each round of the loop reads everything
+// readable, evaluates the complete request lines as one batch and writes
+// the responses.
+class EvalServer {
+public:
+    // The library and result cache, when given, must outlive the server.
+    EvalServer(std::string socketPath, const ExpressionLibrary *library = nullptr,
+               ResultCache *results = nullptr);
+    ~EvalServer();
+    EvalServer(const EvalServer &) = delete;
+    EvalServer &operator=(const EvalServer &) = delete;
+
+    // Binds and listens, replacing a stale socket file at the path. False
+    // with errno set on failure.
+    bool listen();
+    // Serves until stop(); false with errno set if the loop fails.
+    bool run();
+    // Makes run() return after its current round. Safe from other threads
+    // and from signal handlers.
+    void stop();
+
+    // Updated by the loop; read it from the loop or after run() returns.
+    const ServerStats &stats() const { return counters; }
+
+private:
+    struct Connection;
+    // A request line of the current round; request is its BatchEvaluator
+    // index, or kStatsRequest.
+    struct Pending {
+        Connection *conn;
+        size_t request;
+    };
+    static constexpr size_t kStatsRequest = static_cast<size_t>(-1);
+
+    std::string path;
+    ResultCache *results;
+    BatchEvaluator evaluator;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    uint64_t startNs = 0;
+    ServerStats counters;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::vector<Connection *> active;
+    std::vector<Pending> pending;
+
+    void accept();
+    void readFrom(Connection &conn);
+    void flush(Connection &conn);
+    void watch(Connection &conn);
+    void close(int fd);
+    void serveRound(uint64_t readNs);
+};
+
+#endif  // EVAL_SERVER_H_
@@ -1,4 +1,11 @@
+#include <charconv>
+#include <stdexcept>
+
 #include "expression.h"
+#include "small_stack.h"
+#include "tree_eval.h"
+#include "stats.h"
+#include "functions.h"
 
 bool RootNode::evaluate() {
     return root->evaluate();
@@ -23,45 +30,194 @@ int64_t NumberNode::getValue() const {
 }
 
 void NumberNode::print(std::ostream &os) const {
-    os << val;
+    if (!digits.empty()) {
+        os << digits;
+        return;
+    }
+    if (isInteger()) {
+        os << val;
+        return;
+    }
+    // Shortest text that reads back as the same double.
+    char buffer[32];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof buffer, real);
+    os.write(buffer, end - buffer);
 }
 
 void NumberNode::accept(IVisitor *v) const {
     v->visitNumberNode(this);
 }
 
+int64_t BigNumberNode::getValue() const {
+    throw std::out_of_range("Number out of range");
+}
+
+bool VariableNode::evaluate() {
+    return true;
+}
+
+int64_t VariableNode::getValue() const {
+    return table->get(slot);
+}
+
+void VariableNode::print(std::ostream &os) const {
+    os << getName();
+}
+
+void VariableNode::accept(IVisitor *v) const {
+    v->visitVariableNode(this);
+}
+
 bool BinaryNode::evaluate() {
     // TODO: evaluate the input expressions and give error
     return left->evaluate() && right->evaluate();
 }
 
-int64_t BinaryNode::getValue() const {
+int64_t BinaryNode::apply(Operator op, int64_t lhs, int64_t rhs) {
     switch (op) {
-    case Operator::ADD: return left->getValue() + right->getValue();
-    case Operator::SUB: return left->getValue() - right->getValue();
-    case Operator::MUL: return left->getValue() * right->getValue();
+    case Operator::ADD: return wrappingAdd(lhs, rhs);
+    case Operator::SUB: return wrappingSub(lhs, rhs);
+    case Operator::MUL: return wrappingMul(lhs, rhs);
     case Operator::DIV:
-    {
-        auto rhsValue = right->getValue();
-        if (rhsValue == 0) {
+        if (rhs == 0) {
             throw std::runtime_error("Divide by zero");
         }
-        return left->getValue() / rhsValue;
-    }
+        // INT64_MIN / -1 has no int64 result and traps on x86.
+        if (lhs == INT64_MIN && rhs == -1) {
+            throw std::overflow_error("Division overflow");
+        }
+        return lhs / rhs;
     default:
         throw std::runtime_error("Unknown operator");
     }
 }
 
+namespace {
+
+// getValue() semantics: int64 arithmetic that wraps.
+struct WrappingInt64 {
+    using Value = int64_t;
+    static Value apply(Operator op, Value lhs, Value rhs) { return BinaryNode::apply(op, lhs, rhs); }
+    static Value call(Operator fn, Value x) { return applyFunction(fn, x); }
+};
+
+int64_t evaluateTree(const IExpression *root) {
+    return evaluateIteratively<WrappingInt64>(root, [](const IExpression *leaf) {
+        return leaf->getValue();
+    });
+}
+
+// tryEvaluate() semantics: as above, with the first error carried up to
+// the root in place of throwing.
+struct NoThrowInt64 {
+    struct Value {
+        int64_t value = 0;
+        ErrorCode error = ErrorCode::NONE;
+    };
+    static Value apply(Operator op, Value lhs, Value rhs) {
+        if (lhs.error != ErrorCode::NONE) return lhs;
+        if (rhs.error != ErrorCode::NONE) return rhs;
+        if (op == Operator::DIV && rhs.value == 0) return {0, ErrorCode::DIVIDE_BY_ZERO};
+        if (op == Operator::DIV && rhs.value == -1 && lhs.value == INT64_MIN) {
+            return {0, ErrorCode::DIVIDE_OVERFLOW};
+        }
+        return {BinaryNode::apply(op, lhs.value, rhs.value)};
+    }
+    static Value call(Operator fn, Value x) {
+        if (x.error != ErrorCode::NONE) return x;
+        // The batch kernels report a domain error by index, not by throwing.
+        int64_t out;
+        if (functionInfo(fn).batch(&x.value, &out, 1) != 1) return {0, ErrorCode::DOMAIN_ERROR};
+        return {out};
+    }
+};
+
+bool isLeaf(const IExpression *expr) {
+    return !expr->asBinary() && !expr->asUnary();
+}
+
+// Infix form, iteratively; each entry is either a subtree still to print
+// or a character to emit.
+void printTree(std::ostream &os, const IExpression *root) {
+    struct Item {
+        const IExpression *node;
+        char text;
+    };
+    SmallStack<Item, 32> stack;
+    stack.push({root, 0});
+    while (!stack.empty()) {
+        Item item = stack.top();
+        stack.pop();
+        if (!item.node) {
+            os << item.text;
+        } else if (const BinaryNode *binary = item.node->asBinary()) {
+            os << "(";
+            stack.push({nullptr, ')'});
+            stack.push({binary->right, 0});
+            stack.push({nullptr, BinaryNode::opToChar(binary->op)});
+            stack.push({binary->left, 0});
+        } else if (const UnaryFunctionNode *unary = item.node->asUnary()) {
+            os << unary->getName() << "(";
+            stack.push({nullptr, ')'});
+            stack.push({unary->arg, 0});
+        } else {
+            item.node->print(os);
+        }
+    }
+}
+
+}  // namespace
+
+int64_t BinaryNode::getValue() const {
+    EXPR_STATS_TIMER(timer, stats::Metric::EVALUATE_NS);
+    if (isLeaf(left) && isLeaf(right)) {
+        return apply(op, left->getValue(), right->getValue());
+    }
+    return evaluateTree(this);
+}
+
+Result<int64_t> tryEvaluate(const IExpression *expr) {
+    EXPR_STATS_TIMER(timer, stats::Metric::EVALUATE_NS);
+    NoThrowInt64::Value result = evaluateIteratively<NoThrowInt64>(expr, [](const IExpression *leaf) {
+        if (leaf->isOutOfRange()) return NoThrowInt64::Value{0, ErrorCode::NUMBER_OUT_OF_RANGE};
+        return NoThrowInt64::Value{leaf->getValue()};
+    });
+    if (result.error != ErrorCode::NONE) return Error{result.error};
+    return result.value;
+}
+
 void BinaryNode::print(std::ostream &os) const {
-    os << "(";
-    left->print(os);
-    os << opToChar(op);
-    right->print(os);
-    os << ")";
+    printTree(os, this);
 }
 
 void BinaryNode::accept(IVisitor *v) const {
     v->visitBinaryNode(this);
 }
 
+
+UnaryFunctionNode::UnaryFunctionNode(Operator op, IExpression *arg)
+    : fn(functionInfo(op).scalar), op(op), arg(arg) {
+    kind = Kind::UNARY;
+}
+
+bool UnaryFunctionNode::evaluate() {
+    return arg->evaluate();
+}
+
+int64_t UnaryFunctionNode::getValue() const {
+    EXPR_STATS_TIMER(timer, stats::Metric::EVALUATE_NS);
+    if (isLeaf(arg)) return fn(arg->getValue());
+    return evaluateTree(this);
+}
+
+void UnaryFunctionNode::print(std::ostream &os) const {
+    printTree(os, this);
+}
+
+void UnaryFunctionNode::accept(IVisitor *v) const {
+    v->visitUnaryFunctionNode(this);
+}
+
+const char *UnaryFunctionNode::getName() const {
+    return functionInfo(op).name;
+}
@@ -1,13 +1,28 @@
 #ifndef EXPRESSION_H_
 #define EXPRESSION_H_
 
+#include<cstdint>
 #include<string>
+#include<string_view>
 #include<iostream>
 
 #include "visitor.h"
+#include "arena.h"
+#include "result.h"
+#include "variables.h"
+
+class BinaryNode;
+class UnaryFunctionNode;
 
 // Expression interface
 class IExpression {
+public:
+    // What a node is, set by each node class so the iterative walks can
+    // test for it without a virtual call.
+    enum class Kind : uint8_t { OTHER, NUMBER, BIG_NUMBER, VARIABLE, BINARY, UNARY };
+protected:
+    // Fits in the padding after the vtable pointer.
+    Kind kind = Kind::OTHER;
 public:
     virtual ~IExpression() = default;
     virtual bool evaluate() = 0;
@@ -16,6 +31,11 @@ public:
     virtual void print(std::ostream &os) const = 0;
     template<typename T> T to() { return dynamic_cast<T>(this); }
     virtual void accept(IVisitor *v) const = 0;
+    // Cheap type tests for the iterative traversals; nullptr otherwise.
+    inline const BinaryNode *asBinary() const;
+    inline const UnaryFunctionNode *asUnary() const;
+    // A literal beyond int64_t (BigNumberNode).
+    bool isOutOfRange() const { return kind == Kind::BIG_NUMBER; }
 };
 
 enum class Operator {
@@ -29,6 +49,19 @@ enum class Operator {
     COS
 };
 
+// int64 arithmetic that wraps around on overflow, the semantics of
+// getValue() and every backend built on it. Computed as unsigned, where
+// wrap-around is defined; signed overflow is undefined behaviour.
+constexpr int64_t wrappingAdd(int64_t a, int64_t b) {
+    return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+}
+constexpr int64_t wrappingSub(int64_t a, int64_t b) {
+    return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+}
+constexpr int64_t wrappingMul(int64_t a, int64_t b) {
+    return static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+}
+
 class RootNode : public IExpression {
     IExpression *root;
 
@@ -39,15 +72,58 @@ public:
     void print(std::ostream &os) const override;
 };
 
+// A literal. A non-integer one (see Parser::setRealLiterals) keeps its
+// nearest double for evaluateAs<Float64>; getValue(), and so every integer
+// backend, sees it truncated toward zero.
 class NumberNode : public IExpression {
-    int val = 0;
+    int64_t val = 0;
+    double real = 0;
 public:
-    explicit NumberNode(int val) : val(val) {}
+    explicit NumberNode(int64_t val) : val(val), real(static_cast<double>(val)) { kind = Kind::NUMBER; }
+    NumberNode(int64_t val, double real) : val(val), real(real) { kind = Kind::NUMBER; }
     bool evaluate() override;
     int64_t getValue() const override;
+    double getReal() const { return real; }
+    bool isInteger() const { return real == static_cast<double>(val); }
+    // Decimal digits of a BigNumberNode; empty for a literal that fits.
+    std::string_view getDigits() const { return digits; }
     std::string getTypeName() override { return std::string("NumberNode"); }
     void print(std::ostream &os) const override;
     void accept(IVisitor *v) const override;
+protected:
+    std::string_view digits;
+};
+
+// An integer literal too large for int64_t (see Parser::setBigLiterals).
+// It keeps its decimal digits for evaluateAs<BigInteger>; getValue(), and
+// with it every int64 backend, throws std::out_of_range instead.
+class BigNumberNode : public NumberNode {
+    std::string text;
+public:
+    explicit BigNumberNode(std::string_view decimal) : NumberNode(0), text(decimal) {
+        digits = text;
+        kind = Kind::BIG_NUMBER;
+    }
+    int64_t getValue() const override;
+};
+
+// Reads its value from a slot of a VariableTable, so the same tree can be
+// evaluated again after rebinding the table without reparsing.
+class VariableNode : public IExpression {
+    const VariableTable *table;
+    size_t slot;
+public:
+    VariableNode(const VariableTable *table, size_t slot) : table(table), slot(slot) {
+        kind = Kind::VARIABLE;
+    }
+    bool evaluate() override;
+    int64_t getValue() const override;
+    std::string getTypeName() override { return std::string("VariableNode"); }
+    void print(std::ostream &os) const override;
+    void accept(IVisitor *v) const override;
+    size_t getSlot() const { return slot; }
+    const VariableTable *getTable() const { return table; }
+    const std::string &getName() const { return table->name(slot); }
 };
 
 class BinaryNode : public IExpression {
@@ -56,7 +132,7 @@ public:
     IExpression *left;
     IExpression *right;
     BinaryNode(Operator op, IExpression *left, IExpression *right) :
-        op(op), left(left), right(right) {}
+        op(op), left(left), right(right) { kind = Kind::BINARY; }
     bool evaluate() override;
     int64_t getValue() const override;
     std::string getTypeName() override { return std::string("BinaryNode"); }
@@ -69,6 +145,8 @@ public:
     }
     void print(std::ostream &os) const override;
     void accept(IVisitor *v) const override;
+    // Applies op to already evaluated operands.
+    static int64_t apply(Operator op, int64_t lhs, int64_t rhs);
     char getOperator() const {
         return opToChar(op);
     }
@@ -83,16 +161,83 @@ public:
     }
 };
 
+// Built-in function applied to one argument, e.g. sqrt(x). The function
+// is resolved when the node is built, so evaluation is a direct call.
+class UnaryFunctionNode : public IExpression {
+    int64_t (*fn)(int64_t);
+public:
+    Operator op;
+    IExpression *arg;
+    // op must be one of SQRT, ABS, SIN or COS.
+    UnaryFunctionNode(Operator op, IExpression *arg);
+    bool evaluate() override;
+    int64_t getValue() const override;
+    std::string getTypeName() override { return std::string("UnaryFunctionNode"); }
+    void print(std::ostream &os) const override;
+    void accept(IVisitor *v) const override;
+    // Applies the function to an already evaluated argument.
+    int64_t apply(int64_t x) const { return fn(x); }
+    const char *getName() const;
+};
+
+inline const BinaryNode *IExpression::asBinary() const {
+    return kind == Kind::BINARY ? static_cast<const BinaryNode *>(this) : nullptr;
+}
+
+inline const UnaryFunctionNode *IExpression::asUnary() const {
+    return kind == Kind::UNARY ? static_cast<const UnaryFunctionNode *>(this) : nullptr;
+}
+
 class ExpressionFactory {
 public:
-    static IExpression* createNumber(int value) {
+    static IExpression* createNumber(int64_t value) {
         return new NumberNode(value);
     }
+    // value must be within int64_t range once truncated.
+    static IExpression* createReal(double value) {
+        return new NumberNode(static_cast<int64_t>(value), value);
+    }
+    static IExpression* createBigNumber(std::string_view digits) {
+        return new BigNumberNode(digits);
+    }
+    static IExpression* createVariable(const VariableTable *table, size_t slot) {
+        return new VariableNode(table, slot);
+    }
     static IExpression* createBinary(Operator op,
             IExpression* left,
             IExpression* right) {
         return new BinaryNode(op, left, right);
     }
+    static IExpression* createUnary(Operator op, IExpression* arg) {
+        return new UnaryFunctionNode(op, arg);
+    }
+
+    // Arena variants: the node lives as long as the arena does.
+    static IExpression* createNumber(Arena &arena, int64_t value) {
+        return arena.create<NumberNode>(value);
+    }
+    static IExpression* createReal(Arena &arena, double value) {
+        return arena.create<NumberNode>(static_cast<int64_t>(value), value);
+    }
+    static IExpression* createBigNumber(Arena &arena, std::string_view digits) {
+        return arena.create<BigNumberNode>(digits);
+    }
+    static IExpression* createVariable(Arena &arena, const VariableTable *table, size_t slot) {
+        return arena.create<VariableNode>(table, slot);
+    }
+    static IExpression* createBinary(Arena &arena, Operator op,
+            IExpression* left,
+            IExpression* right) {
+        return arena.create<BinaryNode>(op, left, right);
+    }
+    static IExpression* createUnary(Arena &arena, Operator op, IExpression* arg) {
+        return arena.create<UnaryFunctionNode>(op, arg);
+    }
 };
 
+// getValue() without exceptions: divide by zero, INT64_MIN / -1, function
+// domain errors and literals beyond int64_t come back as DIVIDE_BY_ZERO,
+// DIVIDE_OVERFLOW, DOMAIN_ERROR and NUMBER_OUT_OF_RANGE.
+Result<int64_t> tryEvaluate(const IExpression *expr);
+
 #endif  // EXPRESSION_H_
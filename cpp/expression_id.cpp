@@ -0,0 +1,8 @@
+#include <atomic>
+
+#include "expression_id.h"
+
+uint64_t newExpressionIds(size_t count) {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(count, std::memory_order_relaxed);
+}
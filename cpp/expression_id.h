@@ -0,0 +1,12 @@
+#ifndef EXPRESSION_ID_H_
+#define EXPRESSION_ID_H_
+
+#include<cstddef>
+#include<cstdint>
+
+// Process-wide identities for compiled expressions, never reused, so a
+// cache key cannot outlive its expression and match a newer one at the
+// same address. Returns the first of `count` consecutive ids.
+uint64_t newExpressionIds(size_t count = 1);
+
+#endif  // EXPRESSION_ID_H_
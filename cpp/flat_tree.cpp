@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "flat_tree.h"
+#include "functions.h"
+#include "tree_eval.h"
+#include "visitor.h"
+
+// Appends nodes in post-order; FlatTree's constructor visits the pointer
+// tree in post-order, so operands are appended before their parent.
+class FlatTreeBuilder : public IVisitor {
+    FlatTree &tree;
+    // Indices of completed subtrees still waiting for their parent.
+    SmallStack<uint32_t, 32> operands;
+    void append(FlatOp op, uint32_t left, int64_t immediate) {
+        FlatNode node;
+        node.op = op;
+        node.left = left;
+        node.immediate = immediate;
+        tree.nodes.push_back(node);
+        operands.push(static_cast<uint32_t>(tree.nodes.size() - 1));
+    }
+    uint32_t pop() {
+        uint32_t index = operands.top();
+        operands.pop();
+        return index;
+    }
+public:
+    explicit FlatTreeBuilder(FlatTree &tree) : tree(tree) {}
+
+    void visitNumberNode(const NumberNode *expr) override {
+        append(FlatOp::NUMBER, 0, expr->getValue());
+    }
+    void visitVariableNode(const VariableNode *expr) override {
+        tree.variables = expr->getTable();
+        append(FlatOp::VARIABLE, 0, static_cast<int64_t>(expr->getSlot()));
+    }
+    void visitBinaryNode(const BinaryNode *expr) override {
+        uint32_t right = pop();
+        uint32_t left = pop();
+        FlatOp op;
+        switch (expr->op) {
+        case Operator::ADD: op = FlatOp::ADD; break;
+        case Operator::SUB: op = FlatOp::SUB; break;
+        case Operator::MUL: op = FlatOp::MUL; break;
+        case Operator::DIV: op = FlatOp::DIV; break;
+        default:
+            throw std::runtime_error("Unknown operator");
+        }
+        append(op, left, 0);
+        tree.nodes.back().right = right;
+    }
+    void visitUnaryFunctionNode(const UnaryFunctionNode *expr) override {
+        uint32_t arg = pop();
+        FlatOp op;
+        switch (expr->op) {
+        case Operator::SQRT: op = FlatOp::SQRT; break;
+        case Operator::ABS: op = FlatOp::ABS; break;
+        case Operator::SIN: op = FlatOp::SIN; break;
+        case Operator::COS: op = FlatOp::COS; break;
+        default:
+            throw std::runtime_error("Unknown function");
+        }
+        append(op, arg, 0);
+    }
+};
+
+Operator toOperator(FlatOp op) {
+    switch (op) {
+    case FlatOp::ADD: return Operator::ADD;
+    case FlatOp::SUB: return Operator::SUB;
+    case FlatOp::MUL: return Operator::MUL;
+    case FlatOp::DIV: return Operator::DIV;
+    case FlatOp::SQRT: return Operator::SQRT;
+    case FlatOp::ABS: return Operator::ABS;
+    case FlatOp::SIN: return Operator::SIN;
+    case FlatOp::COS: return Operator::COS;
+    default:
+        throw std::runtime_error("Not an operator");
+    }
+}
+
+FlatTree::FlatTree(const IExpression *expr) {
+    if (!expr) return;
+    FlatTreeBuilder builder(*this);
+    acceptPostOrder(expr, &builder);
+    depth = flatStackDepth(nodes.data(), nodes.size());
+}
+
+int64_t FlatTree::evaluate() const {
+    return evaluate(variables ? variables->data() : nullptr);
+}
+
+int64_t FlatTree::evaluate(const int64_t *vars) const {
+    return evaluateFlat(nodes.data(), nodes.size(), vars, depth);
+}
+
+size_t flatStackDepth(const FlatNode *nodes, size_t count) {
+    size_t depth = 0, deepest = 0;
+    for (size_t i = 0; i < count; ++i) {
+        FlatOp op = nodes[i].op;
+        if (op == FlatOp::NUMBER || op == FlatOp::VARIABLE) {
+            deepest = std::max(deepest, ++depth);
+        } else if (op >= FlatOp::ADD && op <= FlatOp::DIV) {
+            --depth;
+        }
+    }
+    return deepest;
+}
+
+namespace {
+
+// Loop shared by evaluateFlat() (Throw) and tryEvaluateFlat(), like
+// Program::run.
+template<bool Throw>
+int64_t runFlat(const FlatNode *nodes, size_t count, const int64_t *vars, size_t stackDepth,
+                ErrorCode &error) {
+    if (count == 0) {
+        if (Throw) throw std::runtime_error("Empty expression");
+        error = ErrorCode::MALFORMED_PROGRAM;
+        return 0;
+    }
+    // Post-order means a single forward sweep with a value stack: a leaf
+    // pushes, an operator pops its two operands.
+    constexpr size_t kInlineStack = 64;
+    int64_t inlineStack[kInlineStack];
+    std::vector<int64_t> heapStack;
+    int64_t *stack = inlineStack;
+    if (stackDepth > kInlineStack) {
+        heapStack.resize(stackDepth);
+        stack = heapStack.data();
+    }
+
+    int64_t *sp = stack;
+    for (size_t i = 0; i < count; ++i) {
+        const FlatNode &node = nodes[i];
+        switch (node.op) {
+        case FlatOp::NUMBER:
+            *sp++ = node.immediate;
+            break;
+        case FlatOp::VARIABLE:
+            *sp++ = vars[node.immediate];
+            break;
+        case FlatOp::ADD:
+            --sp;
+            sp[-1] = wrappingAdd(sp[-1], sp[0]);
+            break;
+        case FlatOp::SUB:
+            --sp;
+            sp[-1] = wrappingSub(sp[-1], sp[0]);
+            break;
+        case FlatOp::MUL:
+            --sp;
+            sp[-1] = wrappingMul(sp[-1], sp[0]);
+            break;
+        case FlatOp::DIV:
+            --sp;
+            if (sp[0] == 0) {
+                if (Throw) throw std::runtime_error("Divide by zero");
+                error = ErrorCode::DIVIDE_BY_ZERO;
+                return 0;
+            }
+            if (sp[0] == -1 && sp[-1] == INT64_MIN) {
+                if (Throw) throw std::overflow_error("Division overflow");
+                error = ErrorCode::DIVIDE_OVERFLOW;
+                return 0;
+            }
+            sp[-1] = sp[-1] / sp[0];
+            break;
+        case FlatOp::SQRT:
+        case FlatOp::ABS:
+        case FlatOp::SIN:
+        case FlatOp::COS:
+            if (Throw) {
+                sp[-1] = applyFunction(toOperator(node.op), sp[-1]);
+            } else if (functionInfo(toOperator(node.op)).batch(sp - 1, sp - 1, 1) != 1) {
+                error = ErrorCode::DOMAIN_ERROR;
+                return 0;
+            }
+            break;
+        }
+    }
+    return stack[0];
+}
+
+}  // namespace
+
+int64_t evaluateFlat(const FlatNode *nodes, size_t count, const int64_t *vars, size_t stackDepth) {
+    ErrorCode unused;
+    return runFlat<true>(nodes, count, vars, stackDepth, unused);
+}
+
+Result<int64_t> tryEvaluateFlat(const FlatNode *nodes, size_t count, const int64_t *vars,
+                                size_t stackDepth) {
+    ErrorCode error = ErrorCode::NONE;
+    int64_t value = runFlat<false>(nodes, count, vars, stackDepth, error);
+    if (error != ErrorCode::NONE) return Error{error};
+    return value;
+}
@@ -0,0 +1,81 @@
+#ifndef FLAT_TREE_H_
+#define FLAT_TREE_H_
+
+#include<cstdint>
+#include<vector>
+
+#include "expression.h"
+
+enum class FlatOp : uint8_t {
+    NUMBER,
+    VARIABLE,
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    SQRT,  // functions have one child, in left
+    ABS,
+    SIN,
+    COS
+};
+
+// Operator for the operator and function tags.
+Operator toOperator(FlatOp op);
+
+// 16-byte tagged node. Leaves carry an immediate (the constant, or the
+// variable slot); operators carry the indices of their two children and
+// functions the index of their argument. A constant is the literal's
+// getValue(), so a decimal literal (Parser::setRealLiterals) is stored,
+// evaluated and printed truncated toward zero.
+struct FlatNode {
+    FlatOp op;
+    uint32_t left;
+    union {
+        int64_t immediate;
+        uint32_t right;
+    };
+};
+
+// Devirtualized AST: all nodes in one vector in post-order, so children
+// always precede their parent and the root is the last node. Evaluation
+// and printing dispatch with a switch on the tag instead of virtual calls.
+class FlatTree {
+    std::vector<FlatNode> nodes;
+    const VariableTable *variables = nullptr;
+    size_t depth = 0;  // flatStackDepth of nodes, computed once
+    friend class FlatTreeBuilder;
+public:
+    FlatTree() = default;
+    // Converts a pointer tree; shared subtrees of a DAG are copied.
+    explicit FlatTree(const IExpression *expr);
+
+    // Variable slot i reads vars[i]; throws std::runtime_error on divide
+    // by zero or overflow like BinaryNode::getValue().
+    int64_t evaluate(const int64_t *vars) const;
+    // Reads variables from the table the source tree was parsed with.
+    int64_t evaluate() const;
+
+    const std::vector<FlatNode> &data() const { return nodes; }
+    size_t size() const { return nodes.size(); }
+    bool empty() const { return nodes.empty(); }
+    uint32_t root() const { return static_cast<uint32_t>(nodes.size() - 1); }
+    // Deepest value stack evaluate() needs.
+    size_t stackDepth() const { return depth; }
+    // Table the variables were resolved against, nullptr if there are none.
+    const VariableTable *variableTable() const { return variables; }
+};
+
+// Evaluation loop behind FlatTree::evaluate, for nodes stored elsewhere
+// (e.g. a mapped ExpressionLibrary): count nodes in post-order whose value
+// stack never holds more than stackDepth entries. Throws
+// std::runtime_error when count is 0, on divide by zero or INT64_MIN / -1,
+// and on a function domain error.
+int64_t evaluateFlat(const FlatNode *nodes, size_t count, const int64_t *vars, size_t stackDepth);
+// Same, reporting DIVIDE_BY_ZERO, DIVIDE_OVERFLOW, DOMAIN_ERROR or, when
+// count is 0, MALFORMED_PROGRAM instead of throwing.
+Result<int64_t> tryEvaluateFlat(const FlatNode *nodes, size_t count, const int64_t *vars,
+                                size_t stackDepth);
+// Deepest value stack evaluateFlat needs for the nodes.
+size_t flatStackDepth(const FlatNode *nodes, size_t count);
+
+#endif  // FLAT_TREE_H_
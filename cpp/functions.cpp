@@ -0,0 +1,112 @@
+#include <cmath>
+#include <stdexcept>
+
+#include "functions.h"
+
+namespace {
+
+int64_t squareRoot(int64_t x) {
+    if (x < 0) throw std::runtime_error("Invalid argument to sqrt");
+    // The double estimate can be one off above 2^52; correct it exactly.
+    uint64_t v = static_cast<uint64_t>(x);
+    uint64_t r = static_cast<uint64_t>(std::sqrt(static_cast<double>(x)));
+    while (r * r > v) --r;
+    while ((r + 1) * (r + 1) <= v) ++r;
+    return static_cast<int64_t>(r);
+}
+
+int64_t absolute(int64_t x) {
+    // Negate as unsigned so abs(INT64_MIN) wraps instead of being undefined.
+    return x < 0 ? static_cast<int64_t>(0 - static_cast<uint64_t>(x)) : x;
+}
+
+int64_t sine(int64_t x) {
+    return static_cast<int64_t>(std::sin(static_cast<double>(x)));
+}
+
+int64_t cosine(int64_t x) {
+    return static_cast<int64_t>(std::cos(static_cast<double>(x)));
+}
+
+// Batch kernels: plain loops over restrict pointers, which the compiler
+// vectorizes where the target has the instructions (abs everywhere, the
+// conversions with AVX-512); sqrt checks the whole chunk's domain first so
+// the computing loop has no early exit.
+
+size_t squareRootBatch(const int64_t *in, int64_t *out, size_t n) {
+    size_t valid = 0;
+    while (valid < n && in[valid] >= 0) ++valid;
+    for (size_t i = 0; i < valid; ++i) {
+        uint64_t v = static_cast<uint64_t>(in[i]);
+        uint64_t r = static_cast<uint64_t>(std::sqrt(static_cast<double>(in[i])));
+        r -= r * r > v;
+        r += (r + 1) * (r + 1) <= v;
+        out[i] = static_cast<int64_t>(r);
+    }
+    return valid;
+}
+
+size_t absoluteBatch(const int64_t *in, int64_t *out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t v = static_cast<uint64_t>(in[i]);
+        uint64_t sign = static_cast<uint64_t>(in[i] >> 63);
+        out[i] = static_cast<int64_t>((v ^ sign) - sign);
+    }
+    return n;
+}
+
+size_t sineBatch(const int64_t *in, int64_t *out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = sine(in[i]);
+    return n;
+}
+
+size_t cosineBatch(const int64_t *in, int64_t *out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = cosine(in[i]);
+    return n;
+}
+
+const FunctionInfo kFunctions[] = {
+    {"sqrt", Operator::SQRT, squareRoot, squareRootBatch},
+    {"abs", Operator::ABS, absolute, absoluteBatch},
+    {"sin", Operator::SIN, sine, sineBatch},
+    {"cos", Operator::COS, cosine, cosineBatch},
+};
+
+// Perfect hash over the built-in names: (name[0] + name[1] + length) & 3
+// maps sqrt, cos, abs and sin to 0, 1, 2 and 3. Found by exhaustive search;
+// adding a function means searching again (and possibly a larger table).
+const FunctionInfo *const kHashTable[4] = {
+    &kFunctions[0], &kFunctions[3], &kFunctions[1], &kFunctions[2],
+};
+
+}  // namespace
+
+const FunctionInfo *lookupFunction(std::string_view name) {
+    if (name.size() < 2) return nullptr;
+    size_t h = (static_cast<unsigned char>(name[0]) +
+                static_cast<unsigned char>(name[1]) + name.size()) & 3;
+    const FunctionInfo *candidate = kHashTable[h];
+    return name == candidate->name ? candidate : nullptr;
+}
+
+const FunctionInfo &functionInfo(Operator op) {
+    switch (op) {
+    case Operator::SQRT: return kFunctions[0];
+    case Operator::ABS: return kFunctions[1];
+    case Operator::SIN: return kFunctions[2];
+    case Operator::COS: return kFunctions[3];
+    default:
+        throw std::runtime_error("Unknown function");
+    }
+}
+
+int64_t applyFunction(Operator op, int64_t x) {
+    switch (op) {
+    case Operator::SQRT: return squareRoot(x);
+    case Operator::ABS: return absolute(x);
+    case Operator::SIN: return sine(x);
+    case Operator::COS: return cosine(x);
+    default:
+        throw std::runtime_error("Unknown function");
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef FUNCTIONS_H_
+#define FUNCTIONS_H_
+
+#include<cstdint>
+#include<string_view>
+
+#include "expression.h"
+
+// Built-in unary functions. A name is resolved once, when the expression is
+// parsed, to its FunctionInfo; evaluation dispatches on the Operator or
+// calls through the pointers and never compares strings.
+//
+// Like the rest of the evaluator they map int64 to int64: sqrt is the exact
+// integer square root and throws on negative arguments, abs wraps for
+// INT64_MIN, and sin and cos (in radians) truncate toward zero.
+struct FunctionInfo {
+    const char *name;
+    Operator op;
+    // Throws std::runtime_error for an argument outside the domain.
+    int64_t (*scalar)(int64_t);
+    // Applies the function to n values; out may alias in. Returns n, or the
+    // index of the first argument outside the domain, having computed only
+    // the values before it.
+    size_t (*batch)(const int64_t *in, int64_t *out, size_t n);
+};
+
+// nullptr when name is not a built-in function.
+const FunctionInfo *lookupFunction(std::string_view name);
+// op must be one of the function operators.
+const FunctionInfo &functionInfo(Operator op);
+
+inline bool isFunction(Operator op) {
+    return op == Operator::SQRT || op == Operator::ABS ||
+           op == Operator::SIN || op == Operator::COS;
+}
+
+int64_t applyFunction(Operator op, int64_t x);
+
+#endif  // FUNCTIONS_H_
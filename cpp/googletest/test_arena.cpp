@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "parser.h"
+
+namespace {
+struct Tracked {
+    int *counter;
+    explicit Tracked(int *counter) : counter(counter) {}
+    ~Tracked() { ++*counter; }
+};
+}
+
+TEST(ArenaTest, AllocationsAreAligned) {
+    Arena arena(64);
+    arena.allocate(1, 1);
+    void *p = arena.allocate(sizeof(int64_t), alignof(int64_t));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % alignof(int64_t), 0u);
+}
+
+TEST(ArenaTest, GrowsAndHandlesOversizedRequests) {
+    Arena arena(64);
+    for (int i = 0; i < 32; ++i) arena.allocate(16, 8);
+    EXPECT_GT(arena.blockCount(), 1u);
+    void *big = arena.allocate(1024, 8);
+    EXPECT_NE(big, nullptr);
+    EXPECT_GE(arena.bytesUsed(), 32u * 16u + 1024u);
+}
+
+TEST(ArenaTest, RunsDestructorsOnResetAndDestruction) {
+    int destroyed = 0;
+    {
+        Arena arena;
+        arena.create<Tracked>(&destroyed);
+        arena.create<Tracked>(&destroyed);
+        arena.reset();
+        EXPECT_EQ(destroyed, 2);
+        EXPECT_EQ(arena.bytesUsed(), 0u);
+        arena.create<Tracked>(&destroyed);
+    }
+    EXPECT_EQ(destroyed, 3);
+}
+
+TEST(ArenaTest, ResetKeepsFirstBlock) {
+    Arena arena(128);
+    for (int i = 0; i < 64; ++i) arena.allocate(16, 8);
+    arena.reset();
+    EXPECT_EQ(arena.blockCount(), 1u);
+}
+
+TEST(ArenaParserTest, ParseIntoArena) {
+    Arena arena;
+    Parser parser;
+    IExpression *expr = parser.parse("(3+4)*(2-1)", arena);
+    ASSERT_NE(expr, nullptr);
+    EXPECT_EQ(expr->getValue(), 7);
+    std::ostringstream oss;
+    expr->print(oss);
+    EXPECT_EQ(oss.str(), "((3+4)*(2-1))");
+    EXPECT_GE(arena.bytesUsed(), 7 * sizeof(NumberNode));
+}
+
+TEST(ArenaParserTest, HandleOwnsTree) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("1+2*3");
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->getValue(), 7);
+
+    ParsedExpression moved = std::move(parsed);
+    EXPECT_FALSE(parsed);
+    ASSERT_TRUE(moved);
+    EXPECT_EQ(moved.get()->getValue(), 7);
+    EXPECT_GT(moved.memory().bytesUsed(), 0u);
+}
+
+TEST(ArenaParserTest, InvalidInputReturnsEmptyHandle) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("2+*3");
+    EXPECT_FALSE(parsed);
+}
+
+TEST(ArenaParserTest, HeapParseAfterArenaParse) {
+    Arena arena;
+    Parser parser;
+    ASSERT_NE(parser.parse("1+1", arena), nullptr);
+    size_t used = arena.bytesUsed();
+    IExpression *expr = parser.parse("2+2");
+    ASSERT_NE(expr, nullptr);
+    EXPECT_EQ(arena.bytesUsed(), used);
+    EXPECT_EQ(expr->getValue(), 4);
+}
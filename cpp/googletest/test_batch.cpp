@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "batch.h"
+
+namespace {
+std::vector<int64_t> sequence(size_t n, int64_t start, int64_t step) {
+    std::vector<int64_t> v(n);
+    for (size_t i = 0; i < n; ++i) v[i] = start + int64_t(i) * step;
+    return v;
+}
+}
+
+TEST(BatchKernelTest, MatchesScalarArithmetic) {
+    // Odd length exercises the vector loop tails.
+    const size_t n = 37;
+    auto a = sequence(n, -20, 7);
+    auto b = sequence(n, 3, 5);
+    a[5] = std::numeric_limits<int64_t>::max();
+    b[5] = 3;
+    a[6] = -123456789012345;
+    b[6] = 98765;
+    std::vector<int64_t> out(n);
+
+    EXPECT_EQ(batchApply(Operator::ADD, a.data(), b.data(), out.data(), n), n);
+    for (size_t i = 0; i < n; ++i) {
+        if (i != 5) {
+            EXPECT_EQ(out[i], a[i] + b[i]) << i;
+        }
+    }
+    EXPECT_EQ(batchApply(Operator::SUB, a.data(), b.data(), out.data(), n), n);
+    for (size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], a[i] - b[i]) << i;
+    EXPECT_EQ(batchApply(Operator::MUL, a.data(), b.data(), out.data(), n), n);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_EQ(out[i], int64_t(uint64_t(a[i]) * uint64_t(b[i]))) << i;
+    }
+    EXPECT_EQ(batchApply(Operator::DIV, a.data(), b.data(), out.data(), n), n);
+    for (size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], a[i] / b[i]) << i;
+}
+
+TEST(BatchKernelTest, DivideStopsAtFirstZero) {
+    auto a = sequence(11, 100, 1);
+    auto b = sequence(11, 1, 1);
+    b[9] = 0;
+    b[7] = 0;
+    std::vector<int64_t> out(11, -1);
+    EXPECT_EQ(batchApply(Operator::DIV, a.data(), b.data(), out.data(), 11), 7u);
+    EXPECT_EQ(out[6], a[6] / b[6]);
+}
+
+TEST(BatchKernelTest, DivideStopsAtOverflow) {
+    auto a = sequence(11, 100, 1);
+    auto b = sequence(11, 1, 1);
+    a[4] = INT64_MIN;
+    b[4] = 2;
+    a[6] = INT64_MIN;
+    b[6] = -1;
+    std::vector<int64_t> out(11, -1);
+    EXPECT_EQ(batchApply(Operator::DIV, a.data(), b.data(), out.data(), 11), 6u);
+    EXPECT_EQ(out[4], INT64_MIN / 2);
+}
+
+TEST(BatchKernelTest, OutputMayAliasInput) {
+    auto a = sequence(9, 1, 1);
+    auto b = sequence(9, 2, 0);
+    batchApply(Operator::MUL, a.data(), b.data(), a.data(), 9);
+    EXPECT_EQ(a[8], 18);
+}
+
+TEST(BatchEvaluateTest, MatchesRowByRowEvaluation) {
+    CompiledExpression expr("x * 3 + y / 2 - (x - y) * 7");
+    ASSERT_TRUE(expr.ok());
+    const size_t rows = 2000;
+    auto x = sequence(rows, -1000, 1);
+    auto y = sequence(rows, 5, 3);
+    std::vector<ColumnView> columns(expr.variables().size());
+    columns[expr.slot("x")] = ColumnView{x.data(), rows};
+    columns[expr.slot("y")] = ColumnView{y.data(), rows};
+
+    std::vector<int64_t> out(rows);
+    evaluateBatch(expr.code(), columns, rows, out.data());
+    int64_t values[2];
+    for (size_t i = 0; i < rows; ++i) {
+        values[expr.slot("x")] = x[i];
+        values[expr.slot("y")] = y[i];
+        ASSERT_EQ(out[i], expr.evaluate(values)) << i;
+    }
+}
+
+TEST(BatchEvaluateTest, ConstantAndSingleColumnPrograms) {
+    CompiledExpression constant("(3+4)*2");
+    std::vector<int64_t> out(3);
+    evaluateBatch(constant.code(), {}, 3, out.data());
+    EXPECT_EQ(out, (std::vector<int64_t>{14, 14, 14}));
+
+    CompiledExpression identity("v");
+    std::vector<int64_t> v{4, 5, 6};
+    evaluateBatch(identity.code(), {ColumnView{v.data(), v.size()}}, 3, out.data());
+    EXPECT_EQ(out, v);
+}
+
+TEST(BatchEvaluateTest, ReportsLowestFailingRow) {
+    CompiledExpression expr("100 / a + 100 / b");
+    ASSERT_TRUE(expr.ok());
+    const size_t rows = 1500;
+    std::vector<int64_t> a(rows, 1), b(rows, 1);
+    a[1400] = 0;
+    b[700] = 0;
+    std::vector<ColumnView> columns(2);
+    columns[expr.slot("a")] = ColumnView{a.data(), rows};
+    columns[expr.slot("b")] = ColumnView{b.data(), rows};
+    std::vector<int64_t> out(rows);
+    try {
+        evaluateBatch(expr.code(), columns, rows, out.data());
+        FAIL() << "expected DivideByZeroError";
+    } catch (const DivideByZeroError &e) {
+        EXPECT_EQ(e.row(), 700u);
+    }
+}
+
+TEST(BatchEvaluateTest, ReportsDivisionOverflow) {
+    CompiledExpression expr("a / b + 100 / b");
+    ASSERT_TRUE(expr.ok());
+    const size_t rows = 1500;
+    std::vector<int64_t> a(rows, 1), b(rows, 1);
+    a[900] = INT64_MIN;
+    b[900] = -1;
+    b[1200] = 0;
+    std::vector<ColumnView> columns(2);
+    columns[expr.slot("a")] = ColumnView{a.data(), rows};
+    columns[expr.slot("b")] = ColumnView{b.data(), rows};
+    std::vector<int64_t> out(rows);
+    try {
+        evaluateBatch(expr.code(), columns, rows, out.data());
+        FAIL() << "expected DivideOverflowError";
+    } catch (const DivideOverflowError &e) {
+        EXPECT_EQ(e.row(), 900u);
+        EXPECT_EQ(e.reason(), "Division overflow");
+    }
+}
+
+TEST(BatchEvaluateTest, RejectsMissingOrShortColumns) {
+    CompiledExpression expr("x + y");
+    std::vector<int64_t> x(4), out(4);
+    EXPECT_THROW(evaluateBatch(expr.code(), {ColumnView{x.data(), 4}}, 4, out.data()),
+                 std::invalid_argument);
+    EXPECT_THROW(evaluateBatch(expr.code(), {ColumnView{x.data(), 4}, ColumnView{x.data(), 2}},
+                               4, out.data()),
+                 std::invalid_argument);
+}
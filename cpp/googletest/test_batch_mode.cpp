@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include "batch_mode.h"
+
+namespace {
+// Runs the batch over `input` written to a temporary file; returns stdout.
+std::string runOn(const std::string &input, BatchSummary &summary) {
+    char inPath[] = "/tmp/batch_inXXXXXX";
+    char outPath[] = "/tmp/batch_outXXXXXX";
+    int in = mkstemp(inPath);
+    int out = mkstemp(outPath);
+    EXPECT_EQ(write(in, input.data(), input.size()), ssize_t(input.size()));
+    close(in);
+    EXPECT_TRUE(runBatch(inPath, out, summary));
+    std::string result(4096, '\0');
+    ssize_t n = pread(out, &result[0], result.size(), 0);
+    result.resize(n > 0 ? n : 0);
+    close(out);
+    unlink(inPath);
+    unlink(outPath);
+    return result;
+}
+}
+
+TEST(BatchModeTest, EvaluatesEveryLine) {
+    BatchSummary summary;
+    std::string out = runOn("1+2\n\n(3+4)*(2-1)/5\r\n7*6", summary);
+    EXPECT_EQ(out, "3\n1\n42\n");
+    EXPECT_EQ(summary.lines, 3u);
+    EXPECT_EQ(summary.evaluated, 3u);
+    EXPECT_EQ(summary.bytes, 23u);
+}
+
+TEST(BatchModeTest, ReportsErrorsPerLine) {
+    BatchSummary summary;
+    std::string out = runOn("2+*3\n10/0\n5\n", summary);
+    EXPECT_EQ(out, "error: line 1: column 3: Expected a number, name or '('\n"
+                   "error: line 2: Divide by zero\n5\n");
+    EXPECT_EQ(summary.parseErrors, 1u);
+    EXPECT_EQ(summary.evalErrors, 1u);
+    EXPECT_EQ(summary.evaluated, 1u);
+}
+
+TEST(BatchModeTest, RejectsTrailingInput) {
+    BatchSummary summary;
+    std::string out = runOn("1 2\n1 )\n", summary);
+    EXPECT_EQ(out, "error: line 1: column 3: Unexpected token\n"
+                   "error: line 2: column 3: Unexpected token\n");
+    EXPECT_EQ(summary.parseErrors, 2u);
+}
+
+TEST(BatchModeTest, MissingFile) {
+    BatchSummary summary;
+    EXPECT_FALSE(runBatch("/nonexistent/expressions.txt", 1, summary));
+}
+
+TEST(BatchModeTest, ReadErrorIsNotEndOfInput) {
+    // A directory opens but fails every read with EISDIR.
+    BatchSummary summary;
+    EXPECT_FALSE(runBatch("/tmp", 1, summary));
+    EXPECT_EQ(errno, EISDIR);
+}
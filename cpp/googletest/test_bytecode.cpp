@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include "bytecode.h"
+#include "parser.h"
+
+namespace {
+int64_t run(const std::string &input) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    if (!parsed) throw std::invalid_argument(input);
+    BytecodeCompiler compiler;
+    return compiler.compile(parsed.get()).execute();
+}
+}
+
+TEST(BytecodeTest, CompilesToPostfix) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("1+2*3");
+    ASSERT_TRUE(parsed);
+    BytecodeCompiler compiler;
+    Program program = compiler.compile(parsed.get());
+    const auto &code = program.instructions();
+    ASSERT_EQ(code.size(), 5u);
+    EXPECT_EQ(code[0].op, OpCode::PUSH);
+    EXPECT_EQ(code[0].operand, 1);
+    EXPECT_EQ(code[1].op, OpCode::PUSH);
+    EXPECT_EQ(code[2].op, OpCode::PUSH);
+    EXPECT_EQ(code[3].op, OpCode::MUL);
+    EXPECT_EQ(code[4].op, OpCode::ADD);
+    EXPECT_EQ(program.stackDepth(), 3u);
+}
+
+TEST(BytecodeTest, MatchesTreeEvaluation) {
+    const char *inputs[] = {
+        "2+3", "2+3*4", "(2+3)*4", "10-6/2", "1+2*(3+4)-5/5",
+        "1-2+3", "((1+2)*(3+4))", "100000*200000", "7/2-9/4",
+    };
+    Parser parser;
+    BytecodeCompiler compiler;
+    for (const char *input : inputs) {
+        ParsedExpression parsed = parser.parseInArena(input);
+        ASSERT_TRUE(parsed) << input;
+        EXPECT_EQ(compiler.compile(parsed.get()).execute(), parsed->getValue()) << input;
+    }
+}
+
+TEST(BytecodeTest, DivideByZeroThrows) {
+    EXPECT_THROW(run("1/(2-2)"), std::runtime_error);
+    EXPECT_THROW(run("5+4/0*3"), std::runtime_error);
+}
+
+TEST(BytecodeTest, DeepExpressionUsesLargeStack) {
+    // Right-nested parentheses keep every operand on the stack.
+    std::string input;
+    for (int i = 0; i < 200; ++i) input += "1+(";
+    input += "1";
+    input += std::string(200, ')');
+    EXPECT_EQ(run(input), 201);
+}
+
+TEST(BytecodeTest, DivisionOverflowThrows) {
+    CompiledExpression expr("x / y");
+    ASSERT_TRUE(expr.ok());
+    int64_t values[2];
+    values[expr.slot("x")] = INT64_MIN;
+    values[expr.slot("y")] = -1;
+    EXPECT_THROW(expr.evaluate(values), std::overflow_error);
+    values[expr.slot("y")] = 2;
+    EXPECT_EQ(expr.evaluate(values), INT64_MIN / 2);
+}
+
+TEST(BytecodeTest, OverflowWrapsAround) {
+    EXPECT_EQ(run("9223372036854775807 + 1"), INT64_MIN);
+    EXPECT_EQ(run("0 - 9223372036854775807 - 2"), INT64_MAX);
+    EXPECT_EQ(run("9223372036854775807 * 2"), -2);
+}
+
+TEST(BytecodeTest, CompilesDeepTreesWithoutRecursion) {
+    // 1+(1+(...1)): as deep as the parser accepts, far past the native stack.
+    const int depth = 200000;
+    std::string input;
+    for (int i = 0; i < depth; ++i) input += "1+(";
+    input += "1";
+    input.append(depth, ')');
+    EXPECT_EQ(run(input), depth + 1);
+    CompiledExpression compiled(input);
+    ASSERT_TRUE(compiled.ok());
+    EXPECT_EQ(compiled.code().stackDepth(), size_t(depth) + 1);
+    EXPECT_EQ(compiled.evaluate(nullptr), depth + 1);
+}
+
+TEST(BytecodeTest, EmptyProgramThrows) {
+    Program program;
+    EXPECT_TRUE(program.empty());
+    EXPECT_THROW(program.execute(), std::runtime_error);
+}
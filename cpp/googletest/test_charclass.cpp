@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <cctype>
+#include <random>
+#include <string>
+#include "charclass.h"
+#include "parser.h"
+
+TEST(CharClassTest, MatchesCLocale) {
+    for (int c = 0; c < 256; ++c) {
+        char ch = static_cast<char>(c);
+        EXPECT_EQ(charclass::isSpace(ch), std::isspace(c) != 0) << c;
+        EXPECT_EQ(charclass::isDigit(ch), std::isdigit(c) != 0) << c;
+        EXPECT_EQ(charclass::isAlpha(ch), std::isalpha(c) != 0) << c;
+        EXPECT_EQ(charclass::isAlnum(ch), std::isalnum(c) != 0) << c;
+    }
+}
+
+TEST(CharClassTest, SkipFindsRunEnds) {
+    std::string s = std::string(100, ' ') + "\t\n" + std::string(70, '7') + "abcXYZ09_";
+    EXPECT_EQ(charclass::skip(s.data(), 0, s.size(), charclass::SPACE), 102u);
+    EXPECT_EQ(charclass::skip(s.data(), 102, s.size(), charclass::DIGIT), 172u);
+    EXPECT_EQ(charclass::skip(s.data(), 102, s.size(), charclass::ALNUM), 180u);
+    EXPECT_EQ(charclass::skip(s.data(), 5, 40, charclass::SPACE), 40u);
+    EXPECT_EQ(charclass::skip(s.data(), 40, 40, charclass::SPACE), 40u);
+}
+
+TEST(CharClassTest, VectorPathMatchesScalar) {
+    std::mt19937 rng(7);
+    // Mostly long runs of one class, with every byte value showing up.
+    const char runs[] = {' ', '5', 'q', 'Q', '\t'};
+    std::string s;
+    while (s.size() < 4096) {
+        size_t length = rng() % 80;
+        char fill = runs[rng() % 5];
+        s.append(length, fill);
+        s += static_cast<char>(rng() % 256);
+    }
+    const uint8_t masks[] = {charclass::SPACE, charclass::DIGIT, charclass::ALPHA, charclass::ALNUM};
+    for (uint8_t mask : masks) {
+        for (size_t from = 0; from < s.size(); from += 1 + rng() % 5) {
+            size_t end = from + rng() % 200;
+            if (end > s.size()) end = s.size();
+            ASSERT_EQ(charclass::skip(s.data(), from, end, mask),
+                      charclass::skipScalar(s.data(), from, end, mask))
+                << "from " << from << " mask " << int(mask);
+        }
+    }
+}
+
+TEST(CharClassTest, TokenizersOnLongRuns) {
+    std::string name(1000, 'a');
+    name += "9";
+    std::string input = std::string(300, ' ') + name + std::string(64, '\n') + "+" +
+                        std::string(50, '0') + "12";
+    ViewTokenizer view(input);
+    TokenView id = view.next();
+    EXPECT_EQ(id.type, Token::Type::ID);
+    EXPECT_EQ(id.offset, 300u);
+    EXPECT_EQ(id.length, 1001u);
+    EXPECT_EQ(view.next().type, Token::Type::PLUS);
+    EXPECT_EQ(view.next().number, 12);
+    EXPECT_EQ(view.next().type, Token::Type::END);
+
+    Tokenizer tokenizer(input);
+    EXPECT_EQ(tokenizer.next().value, name);
+    EXPECT_EQ(tokenizer.next().type, Token::Type::PLUS);
+    EXPECT_EQ(tokenizer.next().value, std::string(50, '0') + "12");
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "dag.h"
+#include "optimizer.h"
+#include "parser.h"
+
+TEST(HashConsingTest, IdenticalNodesAreShared) {
+    Arena arena;
+    HashConsingFactory factory(arena);
+    IExpression *a = factory.createNumber(3);
+    EXPECT_EQ(factory.createNumber(3), a);
+    EXPECT_NE(factory.createNumber(4), a);
+    IExpression *sum = factory.createBinary(Operator::ADD, a, factory.createNumber(4));
+    EXPECT_EQ(factory.createBinary(Operator::ADD, factory.createNumber(3), factory.createNumber(4)), sum);
+    EXPECT_NE(factory.createBinary(Operator::SUB, a, factory.createNumber(4)), sum);
+    EXPECT_EQ(factory.unique(), 4u);
+    EXPECT_EQ(factory.requested(), 10u);
+}
+
+TEST(HashConsingTest, ParserBuildsDag) {
+    VariableTable table;
+    Arena arena;
+    HashConsingFactory factory(arena);
+    Parser parser;
+    parser.setVariables(&table);
+    parser.setFactory(&factory);
+    IExpression *expr = parser.parse("(a+b)*(a+b)+(a+b)");
+    ASSERT_NE(expr, nullptr);
+    // a, b, a+b, (a+b)*(a+b), root
+    EXPECT_EQ(factory.unique(), 5u);
+    EXPECT_EQ(countNodes(expr), 11u);
+    auto *root = static_cast<BinaryNode *>(expr);
+    auto *product = static_cast<BinaryNode *>(root->left);
+    EXPECT_EQ(product->left, product->right);
+    EXPECT_EQ(product->left, root->right);
+
+    std::ostringstream oss;
+    expr->print(oss);
+    EXPECT_EQ(oss.str(), "(((a+b)*(a+b))+(a+b))");
+    table.set("a", 2);
+    table.set("b", 3);
+    EXPECT_EQ(expr->getValue(), 30);
+}
+
+TEST(DagEvaluatorTest, EvaluatesSharedNodesOnce) {
+    VariableTable table;
+    Arena arena;
+    HashConsingFactory factory(arena);
+    Parser parser;
+    parser.setVariables(&table);
+    parser.setFactory(&factory);
+    IExpression *expr = parser.parse("(a+b)*(a+b)+(a+b)*(a-b)");
+    ASSERT_NE(expr, nullptr);
+    DagEvaluator dag(expr);
+    EXPECT_EQ(dag.size(), factory.unique());
+    for (int64_t a = -3; a <= 3; ++a) {
+        table.set("a", a);
+        table.set("b", 5);
+        EXPECT_EQ(dag.evaluate(table.data()), expr->getValue());
+    }
+}
+
+TEST(DagEvaluatorTest, WorksOnPlainTrees) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("1+2*(3+4)-5/5");
+    ASSERT_TRUE(parsed);
+    DagEvaluator dag(parsed.get());
+    EXPECT_EQ(dag.size(), 11u);
+    EXPECT_EQ(dag.evaluate(), parsed->getValue());
+}
+
+TEST(DagEvaluatorTest, VariablesNeedBindings) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("x + 1");
+    ASSERT_TRUE(parsed);
+    DagEvaluator dag(parsed.get());
+    EXPECT_THROW(dag.evaluate(), std::invalid_argument);
+    int64_t x = 41;
+    EXPECT_EQ(dag.evaluate(&x), 42);
+}
+
+TEST(DagEvaluatorTest, DeepTrees) {
+    const int depth = 200000;
+    std::string input;
+    for (int i = 0; i < depth; ++i) input += "x+(";
+    input += "1" + std::string(depth, ')');
+    VariableTable table;
+    Arena arena;
+    HashConsingFactory factory(arena);
+    Parser parser;
+    parser.setVariables(&table);
+    parser.setFactory(&factory);
+    IExpression *expr = parser.parse(input);
+    ASSERT_NE(expr, nullptr);
+    DagEvaluator dag(expr);
+    EXPECT_EQ(dag.size(), factory.unique());
+    int64_t x = 2;
+    EXPECT_EQ(dag.evaluate(&x), 2 * depth + 1);
+}
+
+TEST(DagEvaluatorTest, DivisionOverflowThrows) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("x / y + x");
+    ASSERT_TRUE(parsed);
+    DagEvaluator dag(parsed.get());
+    int64_t vars[2];
+    vars[table.find("x")] = INT64_MIN;
+    vars[table.find("y")] = -1;
+    EXPECT_THROW(dag.evaluate(vars), std::overflow_error);
+}
+
+TEST(DagEvaluatorTest, DivideByZeroThrows) {
+    VariableTable table;
+    Arena arena;
+    HashConsingFactory factory(arena);
+    Parser parser;
+    parser.setVariables(&table);
+    parser.setFactory(&factory);
+    IExpression *expr = parser.parse("(x-x)+1/(x-x)");
+    ASSERT_NE(expr, nullptr);
+    DagEvaluator dag(expr);
+    EXPECT_THROW(dag.evaluate(table.data()), std::runtime_error);
+}
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "eval_server.h"
+#include "load_generator.h"
+
+namespace {
+
+std::string respond(BatchEvaluator &evaluator, const std::vector<std::string> &lines) {
+    for (const std::string &line : lines) evaluator.add(line);
+    evaluator.evaluate();
+    std::string out;
+    for (const Result<int64_t> &result : evaluator.results()) formatResponse(result, out);
+    return out;
+}
+
+std::string socketPath(const char *name) {
+    return testing::TempDir() + name;
+}
+
+// Sends everything on one connection and reads until the server is done.
+std::string roundTrip(const std::string &path, const std::string &requests) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    EXPECT_GE(fd, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+    EXPECT_EQ(::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+    for (size_t sent = 0; sent < requests.size();) {
+        ssize_t n = ::write(fd, requests.data() + sent, requests.size() - sent);
+        if (n <= 0) break;
+        sent += size_t(n);
+    }
+    ::shutdown(fd, SHUT_WR);
+    std::string received;
+    char buffer[256];
+    for (ssize_t n; (n = ::read(fd, buffer, sizeof(buffer))) > 0;) received.append(buffer, n);
+    ::close(fd);
+    return received;
+}
+
+ExpressionLibrary::Status loadLibrary(LibraryBuilder &builder, std::vector<uint64_t> &words,
+                                      ExpressionLibrary &library) {
+    std::string bytes = builder.serialize();
+    words.assign((bytes.size() + 7) / 8, 0);
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+    return library.load(words.data(), bytes.size());
+}
+
+// Runs a server on its own thread for the lifetime of the object.
+struct RunningServer {
+    EvalServer server;
+    std::thread loop;
+    explicit RunningServer(const std::string &path, const ExpressionLibrary *library = nullptr)
+        : server(path, library) {
+        EXPECT_TRUE(server.listen());
+        loop = std::thread([this] { EXPECT_TRUE(server.run()); });
+    }
+    ~RunningServer() {
+        server.stop();
+        loop.join();
+    }
+};
+
+}  // namespace
+
+TEST(BatchEvaluatorTest, GroupsRequestsForTheSameExpression) {
+    BatchEvaluator evaluator;
+    std::string out = respond(evaluator, {
+        "x * y; x=3; y=-4",
+        "x*y; y=5; x=2",
+        "x * y; x=7",
+        "x * y; x=1; y=1; unused=9",
+        "2 + 3",
+    });
+    EXPECT_EQ(out, "-12\n10\n0\n1\n5\n");
+    EXPECT_EQ(evaluator.groups(), 2u);
+    EXPECT_EQ(evaluator.size(), 0u);
+}
+
+TEST(BatchEvaluatorTest, FailingRowDoesNotSpoilItsGroup) {
+    BatchEvaluator evaluator;
+    std::vector<std::string> lines;
+    for (int d = -3; d <= 3; ++d) lines.push_back("12 / d; d=" + std::to_string(d));
+    lines.push_back("sqrt(x); x=-1");
+    lines.push_back("sqrt(x); x=16");
+    EXPECT_EQ(respond(evaluator, lines),
+              "-4\n-6\n-12\nerror: Divide by zero\n12\n6\n4\n"
+              "error: Invalid function argument\n4\n");
+}
+
+TEST(BatchEvaluatorTest, ReportsMalformedRequests) {
+    BatchEvaluator evaluator;
+    EXPECT_EQ(respond(evaluator, {"1 + (2", "1 2", "x; x=", "x; =1", "x; x=1;", "#0", "#zero", ""}),
+              "error: column 7: Expected ')'\n"
+              "error: column 3: Unexpected token\n"
+              "error: column 3: Malformed request\n"
+              "error: column 3: Malformed request\n"
+              "1\n"
+              "error: Unknown formula\n"
+              "error: column 1: Malformed request\n"
+              "error: column 1: Input is empty\n");
+}
+
+TEST(BatchEvaluatorTest, EvaluatesLibraryFormulas) {
+    LibraryBuilder builder;
+    ASSERT_TRUE(builder.add("a * 2 + b"));
+    ASSERT_TRUE(builder.add("10 / (c - 1)"));
+    std::vector<uint64_t> words;
+    ExpressionLibrary library;
+    ASSERT_EQ(loadLibrary(builder, words, library), ExpressionLibrary::Status::OK);
+
+    BatchEvaluator evaluator(16, &library);
+    // Bindings do not leak from one request to the next.
+    EXPECT_EQ(respond(evaluator, {"#0; a=5; b=1", "#0; b=3", " # 1 ; c=3", "#1; c=1", "#2"}),
+              "11\n3\n5\nerror: Divide by zero\nerror: Unknown formula\n");
+    EXPECT_EQ(evaluator.groups(), 2u);
+}
+
+TEST(EvalServerTest, AnswersPipelinedRequestsInOrder) {
+    std::string path = socketPath("eval_server_pipeline.sock");
+    RunningServer running(path);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+    ASSERT_EQ(::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+
+    // Two writes, the second finishing a line the first started.
+    std::string first = "x + 1; x=41\n1/0\r\n(2";
+    std::string second = " * 3)\n!stats\n";
+    ASSERT_EQ(::write(fd, first.data(), first.size()), ssize_t(first.size()));
+    ASSERT_EQ(::write(fd, second.data(), second.size()), ssize_t(second.size()));
+    ::shutdown(fd, SHUT_WR);
+    std::string received;
+    char buffer[256];
+    for (ssize_t n; (n = ::read(fd, buffer, sizeof(buffer))) > 0;) received.append(buffer, n);
+    ::close(fd);
+
+    EXPECT_EQ(received.substr(0, received.find("requests:")), "42\nerror: Divide by zero\n6\n");
+    EXPECT_NE(received.find("p99:"), std::string::npos);
+}
+
+TEST(EvalServerTest, SurvivesRequestsThatUsedToCrashIt) {
+    LibraryBuilder builder;
+    ASSERT_TRUE(builder.add("a / b"));
+    std::vector<uint64_t> words;
+    ExpressionLibrary library;
+    ASSERT_EQ(loadLibrary(builder, words, library), ExpressionLibrary::Status::OK);
+
+    std::string path = socketPath("eval_server_hostile.sock");
+    RunningServer running(path, &library);
+    // Nested far deeper than a recursive compiler could follow.
+    const int depth = 200000;
+    std::string deep;
+    for (int i = 0; i < depth; ++i) deep += "1+(";
+    deep += "1" + std::string(depth, ')');
+    std::string requests = deep + "\n"
+        "x / y; x=-9223372036854775808; y=-1\n"
+        "x / y; x=-9223372036854775808; y=-1\n"
+        "x / y; x=-9223372036854775808; y=2\n"
+        "#0; a=-9223372036854775808; b=-1\n"
+        "1 2\n"
+        "6 * 7\n";
+    EXPECT_EQ(roundTrip(path, requests),
+              std::to_string(depth + 1) + "\n"
+              "error: Division overflow\n"
+              "error: Division overflow\n"
+              "-4611686018427387904\n"
+              "error: Division overflow\n"
+              "error: column 3: Unexpected token\n"
+              "42\n");
+}
+
+TEST(EvalServerTest, AnswersALastLineWithoutNewline) {
+    std::string path = socketPath("eval_server_unterminated.sock");
+    RunningServer running(path);
+    EXPECT_EQ(roundTrip(path, "1+2"), "3\n");
+    EXPECT_EQ(roundTrip(path, "6*7\nx; x=5"), "42\n5\n");
+}
+
+TEST(EvalServerTest, ServesTheLoadGenerator) {
+    std::string path = socketPath("eval_server_load.sock");
+    LoadReport report;
+    {
+        RunningServer running(path);
+        LoadOptions options;
+        options.socketPath = path;
+        options.connections = 3;
+        options.depth = 8;
+        options.total = 3000;
+        ASSERT_TRUE(runLoad(options, report));
+
+        options.requests = {"1/0"};
+        options.total = 10;
+        LoadReport failing;
+        ASSERT_TRUE(runLoad(options, failing));
+        EXPECT_EQ(failing.errors, 10u);
+    }
+    EXPECT_EQ(report.responses, 3000u);
+    EXPECT_EQ(report.errors, 0u);
+    EXPECT_LE(report.p50Ns, report.p99Ns);
+    EXPECT_LE(report.p99Ns, report.maxNs);
+
+    LoadOptions gone;
+    gone.socketPath = path;
+    EXPECT_FALSE(runLoad(gone, report));
+}
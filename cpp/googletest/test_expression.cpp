@@ -3,7 +3,7 @@
 #include <stdexcept>
 
 // Helper functions to create nodes
-NumberNode* makeNumber(int val) {
+NumberNode* makeNumber(int64_t val) {
     return new NumberNode(val);
 }
 
@@ -75,6 +75,23 @@ TEST(BinaryNodeTest, DivByZeroThrows) {
     delete r;
 }
 
+TEST(BinaryNodeTest, DivisionOverflowThrows) {
+    // INT64_MIN / -1 traps in hardware; it must surface as an error.
+    EXPECT_THROW(BinaryNode::apply(Operator::DIV, INT64_MIN, -1), std::overflow_error);
+    EXPECT_EQ(BinaryNode::apply(Operator::DIV, INT64_MIN, 1), INT64_MIN);
+    EXPECT_EQ(BinaryNode::apply(Operator::DIV, INT64_MIN + 1, -1), INT64_MAX);
+
+    VariableTable table;
+    Arena arena;
+    size_t x = table.declare("x"), y = table.declare("y");
+    IExpression *div = ExpressionFactory::createBinary(arena, Operator::DIV,
+        ExpressionFactory::createVariable(arena, &table, x),
+        ExpressionFactory::createVariable(arena, &table, y));
+    table.set(x, INT64_MIN);
+    table.set(y, -1);
+    EXPECT_THROW(div->getValue(), std::overflow_error);
+}
+
 TEST(BinaryNodeTest, UnknownOperatorThrows) {
     NumberNode* l = makeNumber(1);
     NumberNode* r = makeNumber(2);
@@ -144,4 +161,43 @@ TEST(BinaryNodeTest, LargeNumbersMultiplication) {
     EXPECT_EQ(b.getValue(), 20000000000LL);
     delete l;
     delete r;
-}
\ No newline at end of file
+}
+TEST(BinaryNodeTest, OverflowWrapsAround) {
+    NumberNode* max = makeNumber(INT64_MAX);
+    NumberNode* one = makeNumber(1);
+    NumberNode* two = makeNumber(2);
+    EXPECT_EQ(BinaryNode(Operator::ADD, max, one).getValue(), INT64_MIN);
+    EXPECT_EQ(BinaryNode(Operator::MUL, max, two).getValue(), -2);
+    NumberNode* min = makeNumber(INT64_MIN);
+    EXPECT_EQ(BinaryNode(Operator::SUB, min, one).getValue(), INT64_MAX);
+    delete max;
+    delete one;
+    delete two;
+    delete min;
+}
+
+TEST(BinaryNodeTest, DeepTreeDoesNotRecurse) {
+    // Alternating left and right spines, deeper than the native stack allows
+    // for a recursive walk.
+    Arena arena;
+    IExpression *expr = ExpressionFactory::createNumber(arena, 1);
+    for (int i = 0; i < 300000; ++i) {
+        IExpression *one = ExpressionFactory::createNumber(arena, 1);
+        expr = (i % 2) ? ExpressionFactory::createBinary(arena, Operator::ADD, expr, one)
+                       : ExpressionFactory::createBinary(arena, Operator::MUL, one, expr);
+    }
+    EXPECT_EQ(expr->getValue(), 150001);
+}
+
+TEST(BinaryNodeTest, DeepTreeDivideByZeroThrows) {
+    Arena arena;
+    IExpression *expr = ExpressionFactory::createNumber(arena, 0);
+    for (int i = 0; i < 1000; ++i) {
+        expr = ExpressionFactory::createBinary(arena, Operator::ADD,
+            ExpressionFactory::createNumber(arena, 1), expr);
+    }
+    expr = ExpressionFactory::createBinary(arena, Operator::DIV,
+        ExpressionFactory::createNumber(arena, 5),
+        ExpressionFactory::createBinary(arena, Operator::SUB, expr, expr));
+    EXPECT_THROW(expr->getValue(), std::runtime_error);
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "ast.h"
+#include "flat_tree.h"
+#include "parser.h"
+
+TEST(FlatTreeTest, NodesAreCompact) {
+    EXPECT_EQ(sizeof(FlatNode), 16u);
+}
+
+TEST(FlatTreeTest, PostOrderLayout) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("1+2*3");
+    FlatTree flat(parsed.get());
+    ASSERT_EQ(flat.size(), 5u);
+    const auto &n = flat.data();
+    EXPECT_EQ(n[0].op, FlatOp::NUMBER);
+    EXPECT_EQ(n[0].immediate, 1);
+    EXPECT_EQ(n[3].op, FlatOp::MUL);
+    EXPECT_EQ(n[3].left, 1u);
+    EXPECT_EQ(n[3].right, 2u);
+    EXPECT_EQ(n[4].op, FlatOp::ADD);
+    EXPECT_EQ(n[4].left, 0u);
+    EXPECT_EQ(n[4].right, 3u);
+    EXPECT_EQ(flat.root(), 4u);
+}
+
+TEST(FlatTreeTest, MatchesPointerTree) {
+    const char *inputs[] = {
+        "2+3", "2+3*4", "(2+3)*4", "10-6/2", "1+2*(3+4)-5/5", "1-2+3",
+        "100000*200000", "x*3+y/2-(x-y)*7", "(a+b)*(a-b)/(b+1)",
+    };
+    for (const char *input : inputs) {
+        VariableTable table;
+        Parser parser;
+        parser.setVariables(&table);
+        ParsedExpression parsed = parser.parseInArena(input);
+        ASSERT_TRUE(parsed) << input;
+        FlatTree flat(parsed.get());
+        for (int64_t v = 1; v <= 9; ++v) {
+            for (size_t s = 0; s < table.size(); ++s) table.set(s, v + int64_t(s) * 3);
+            EXPECT_EQ(flat.evaluate(), parsed->getValue()) << input;
+            EXPECT_EQ(flat.evaluate(table.data()), parsed->getValue()) << input;
+        }
+    }
+}
+
+TEST(FlatTreeTest, PrinterMatchesPointerTree) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("rate*(qty-1)+7/2");
+    std::ostringstream viaTree, viaFlat;
+    ASTPrinter(viaTree).print(parsed.get());
+    ASTPrinter(viaFlat).print(FlatTree(parsed.get()));
+    EXPECT_EQ(viaFlat.str(), viaTree.str());
+}
+
+TEST(FlatTreeTest, DecimalLiteralsAreTruncated) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    parser.setRealLiterals(true);
+    ParsedExpression parsed = parser.parseInArena("2.5 + x");
+    ASSERT_TRUE(parsed);
+    std::ostringstream viaTree, viaFlat;
+    ASTPrinter(viaTree).print(parsed.get());
+    ASTPrinter(viaFlat).print(FlatTree(parsed.get()));
+    EXPECT_EQ(viaTree.str(), "(+ 2.5 x)\n");
+    EXPECT_EQ(viaFlat.str(), "(+ 2 x)\n");
+    int64_t x = 1;
+    EXPECT_EQ(FlatTree(parsed.get()).evaluate(&x), 3);
+}
+
+TEST(FlatTreeTest, DivideByZeroThrows) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("4/(2-2)");
+    FlatTree flat(parsed.get());
+    EXPECT_THROW(flat.evaluate(), std::runtime_error);
+}
+
+TEST(FlatTreeTest, DivisionOverflowThrows) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("x / y");
+    FlatTree flat(parsed.get());
+    int64_t vars[2];
+    vars[table.find("x")] = INT64_MIN;
+    vars[table.find("y")] = -1;
+    EXPECT_THROW(flat.evaluate(vars), std::overflow_error);
+}
+
+TEST(FlatTreeTest, StackDepthIsComputedOnce) {
+    // A left-leaning chain of 1000 additions never holds more than two
+    // values, so evaluation stays on the inline stack.
+    std::string chain = "1";
+    for (int i = 0; i < 1000; ++i) chain += "+1";
+    Parser parser;
+    ParsedExpression left = parser.parseInArena(chain);
+    FlatTree flat(left.get());
+    EXPECT_EQ(flat.size(), 2001u);
+    EXPECT_EQ(flat.stackDepth(), 2u);
+    EXPECT_EQ(flat.evaluate(), 1001);
+
+    ParsedExpression right = parser.parseInArena("1+(2*(3-(4/5)))");
+    EXPECT_EQ(FlatTree(right.get()).stackDepth(), 5u);
+    EXPECT_EQ(FlatTree().stackDepth(), 0u);
+}
+
+TEST(FlatTreeTest, OverflowWrapsAround) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("9223372036854775807 * 2 + 3");
+    EXPECT_EQ(FlatTree(parsed.get()).evaluate(), 1);
+    EXPECT_EQ(parsed->getValue(), 1);
+}
+
+TEST(FlatTreeTest, EmptyTree) {
+    FlatTree flat(nullptr);
+    EXPECT_TRUE(flat.empty());
+    EXPECT_THROW(flat.evaluate(), std::runtime_error);
+}
+
+TEST(FlatTreeTest, DeepTrees) {
+    const int depth = 200000;
+    std::string input;
+    for (int i = 0; i < depth; ++i) input += "1+(";
+    input += "1" + std::string(depth, ')');
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    ASSERT_TRUE(parsed);
+    FlatTree flat(parsed.get());
+    EXPECT_EQ(flat.size(), size_t(2 * depth + 1));
+    EXPECT_EQ(flat.evaluate(), depth + 1);
+}
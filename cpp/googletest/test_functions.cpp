@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+#include "ast.h"
+#include "batch.h"
+#include "bytecode.h"
+#include "dag.h"
+#include "flat_tree.h"
+#include "functions.h"
+#include "jit.h"
+#include "optimizer.h"
+#include "parser.h"
+
+namespace {
+int64_t evalText(const char *text) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(text);
+    if (!parsed) throw std::invalid_argument(text);
+    return parsed->getValue();
+}
+}
+
+TEST(FunctionTableTest, LookupResolvesEveryName) {
+    const char *names[] = {"sqrt", "abs", "sin", "cos"};
+    Operator ops[] = {Operator::SQRT, Operator::ABS, Operator::SIN, Operator::COS};
+    for (int i = 0; i < 4; ++i) {
+        const FunctionInfo *info = lookupFunction(names[i]);
+        ASSERT_NE(info, nullptr) << names[i];
+        EXPECT_EQ(info->op, ops[i]);
+        EXPECT_EQ(&functionInfo(ops[i]), info);
+    }
+}
+
+TEST(FunctionTableTest, LookupRejectsOtherNames) {
+    const char *names[] = {"", "s", "sq", "sqr", "sqrtx", "Sqrt", "tan", "abc", "cot", "x"};
+    for (const char *name : names) EXPECT_EQ(lookupFunction(name), nullptr) << name;
+}
+
+TEST(FunctionTableTest, ScalarValues) {
+    EXPECT_EQ(applyFunction(Operator::SQRT, 0), 0);
+    EXPECT_EQ(applyFunction(Operator::SQRT, 15), 3);
+    EXPECT_EQ(applyFunction(Operator::SQRT, 16), 4);
+    EXPECT_EQ(applyFunction(Operator::SQRT, INT64_MAX), 3037000499);
+    // (2^26 + 1)^2 and one less: the double estimate alone rounds the latter up.
+    EXPECT_EQ(applyFunction(Operator::SQRT, 4503599761588225), 67108865);
+    EXPECT_EQ(applyFunction(Operator::SQRT, 4503599761588224), 67108864);
+    EXPECT_THROW(applyFunction(Operator::SQRT, -1), std::runtime_error);
+    EXPECT_EQ(applyFunction(Operator::ABS, -7), 7);
+    EXPECT_EQ(applyFunction(Operator::ABS, INT64_MIN), INT64_MIN);
+    EXPECT_EQ(applyFunction(Operator::COS, 0), 1);
+    EXPECT_EQ(applyFunction(Operator::SIN, 0), 0);
+    EXPECT_EQ(applyFunction(Operator::SIN, 2), 0);
+}
+
+TEST(FunctionTableTest, BatchKernelsMatchScalar) {
+    std::vector<int64_t> in;
+    for (int64_t v = -300; v <= 300; v += 7) in.push_back(v * v * (v % 3 ? 1 : -1));
+    for (Operator op : {Operator::ABS, Operator::SIN, Operator::COS}) {
+        std::vector<int64_t> out(in.size());
+        ASSERT_EQ(functionInfo(op).batch(in.data(), out.data(), in.size()), in.size());
+        for (size_t i = 0; i < in.size(); ++i) EXPECT_EQ(out[i], applyFunction(op, in[i]));
+    }
+    std::vector<int64_t> squares = {0, 1, 2, 99, 100, INT64_MAX, -4, 9};
+    std::vector<int64_t> out(squares.size());
+    EXPECT_EQ(functionInfo(Operator::SQRT).batch(squares.data(), out.data(), squares.size()), 6u);
+    for (size_t i = 0; i < 6; ++i) EXPECT_EQ(out[i], applyFunction(Operator::SQRT, squares[i]));
+}
+
+TEST(FunctionParserTest, EvaluatesCalls) {
+    EXPECT_EQ(evalText("(3 + 4) * (2 - 1) / 5 + sqrt(16)"), 5);
+    EXPECT_EQ(evalText("abs(2-9)*2"), 14);
+    EXPECT_EQ(evalText("sqrt(abs(0-81)) + cos(0)"), 10);
+    EXPECT_EQ(evalText("sqrt ( 10*10 )"), 10);
+    EXPECT_THROW(evalText("sqrt(0-4)"), std::runtime_error);
+}
+
+TEST(FunctionParserTest, Errors) {
+    Parser parser;
+    EXPECT_EQ(parser.parse("foo(1)"), nullptr);
+    EXPECT_EQ(parser.parse("sqrt()"), nullptr);
+    EXPECT_EQ(parser.parse("sqrt(4"), nullptr);
+    // Without a variable table a bare function name is an unknown identifier.
+    EXPECT_EQ(parser.parse("sqrt+1"), nullptr);
+}
+
+TEST(FunctionParserTest, FunctionNamesStayUsableAsVariables) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("abs + abs(abs)");
+    ASSERT_TRUE(parsed);
+    table.set("abs", -3);
+    EXPECT_EQ(parsed->getValue(), 0);
+}
+
+TEST(FunctionParserTest, Printing) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("sqrt(1+abs(2))*3");
+    std::ostringstream infix, prefix, flat;
+    parsed->print(infix);
+    EXPECT_EQ(infix.str(), "(sqrt((1+abs(2)))*3)");
+    ASTPrinter(prefix).print(parsed.get());
+    EXPECT_EQ(prefix.str(), "(* (sqrt (+ 1 (abs 2))) 3)\n");
+    ASTPrinter(flat).print(FlatTree(parsed.get()));
+    EXPECT_EQ(flat.str(), prefix.str());
+}
+
+TEST(FunctionParserTest, DeepNestingDoesNotRecurse) {
+    const int depth = 100000;
+    std::string input;
+    for (int i = 0; i < depth; ++i) input += "abs(1-";
+    input += "1";
+    input.append(depth, ')');
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    ASSERT_TRUE(parsed);
+    // Levels alternate 0, 1, 0, ... from the innermost abs(1-1).
+    EXPECT_EQ(parsed->getValue(), 1);
+}
+
+TEST(FunctionBackendsTest, AllEvaluatorsAgree) {
+    const char *inputs[] = {"sqrt(x*x+y*y)", "abs(x-y)*cos(0)+sin(y)", "sqrt(abs(x)+1)/(abs(y)+1)"};
+    for (const char *input : inputs) {
+        VariableTable table;
+        Parser parser;
+        parser.setVariables(&table);
+        ParsedExpression parsed = parser.parseInArena(input);
+        ASSERT_TRUE(parsed) << input;
+        BytecodeCompiler compiler;
+        Program program = compiler.compile(parsed.get());
+        FlatTree flat(parsed.get());
+        DagEvaluator dag(parsed.get());
+        JitFunction jit(parsed.get());
+        Arena arena;
+        ConstantFolder folder(arena);
+        IExpression *folded = folder.fold(parsed.get());
+        for (int64_t x = -6; x <= 6; x += 3) {
+            for (int64_t y = -5; y <= 5; y += 5) {
+                table.set("x", x);
+                table.set("y", y);
+                int64_t expected = parsed->getValue();
+                EXPECT_EQ(program.execute(table.data()), expected) << input;
+                EXPECT_EQ(flat.evaluate(), expected) << input;
+                EXPECT_EQ(dag.evaluate(table.data()), expected) << input;
+                EXPECT_EQ(jit(table.data()), expected) << input;
+                EXPECT_EQ(folded->getValue(), expected) << input;
+            }
+        }
+    }
+}
+
+TEST(FunctionBackendsTest, FolderFoldsConstantCalls) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("sqrt(16)+abs(0-2)");
+    Arena arena;
+    ConstantFolder folder(arena);
+    IExpression *folded = folder.fold(parsed.get());
+    EXPECT_EQ(folder.nodesAfter(), 1u);
+    EXPECT_EQ(folded->getValue(), 6);
+
+    ParsedExpression failing = parser.parseInArena("sqrt(0-1)*0");
+    IExpression *kept = folder.fold(failing.get());
+    EXPECT_THROW(kept->getValue(), std::runtime_error);
+}
+
+TEST(FunctionBackendsTest, HashConsingSharesCalls) {
+    Arena arena;
+    HashConsingFactory factory(arena);
+    Parser parser;
+    parser.setFactory(&factory);
+    IExpression *expr = parser.parse("sqrt(4)+sqrt(4)", arena);
+    ASSERT_NE(expr, nullptr);
+    EXPECT_EQ(expr->getValue(), 4);
+    const BinaryNode *sum = expr->asBinary();
+    ASSERT_NE(sum, nullptr);
+    EXPECT_EQ(sum->left, sum->right);
+}
+
+TEST(FunctionBackendsTest, BatchReportsDomainErrorRow) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("sqrt(x)+abs(x)");
+    BytecodeCompiler compiler;
+    Program program = compiler.compile(parsed.get());
+
+    std::vector<int64_t> x(2000);
+    for (size_t i = 0; i < x.size(); ++i) x[i] = int64_t(i * i);
+    std::vector<int64_t> out(x.size());
+    evaluateBatch(program, {ColumnView{x.data(), x.size()}}, x.size(), out.data());
+    for (size_t i = 0; i < x.size(); ++i) EXPECT_EQ(out[i], int64_t(i + i * i));
+
+    x[1500] = -1;
+    try {
+        evaluateBatch(program, {ColumnView{x.data(), x.size()}}, x.size(), out.data());
+        FAIL() << "expected DomainError";
+    } catch (const DomainError &e) {
+        EXPECT_EQ(e.row(), 1500u);
+        EXPECT_EQ(e.reason(), "Invalid argument to sqrt");
+    }
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include "incremental.h"
+#include "parser.h"
+
+namespace {
+
+// ((x0+x1)+(x2+x3))+... as a balanced tree over n variables.
+std::string balancedSum(int first, int count) {
+    if (count == 1) return "x" + std::to_string(first);
+    int half = count / 2;
+    return "(" + balancedSum(first, half) + "+" + balancedSum(first + half, count - half) + ")";
+}
+
+}  // namespace
+
+TEST(IncrementalTest, MatchesFullEvaluation) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("(a*b - c) / (abs(d) + 1) + a*3");
+    table.set("a", 4);
+    table.set("b", 5);
+    table.set("c", 2);
+    table.set("d", -3);
+    IncrementalEvaluator eval(parsed.get());
+    EXPECT_EQ(eval.value(), parsed->getValue());
+    EXPECT_EQ(eval.lastRecomputed(), eval.size());
+
+    const char *names[] = {"a", "b", "c", "d"};
+    for (int step = 0; step < 40; ++step) {
+        const char *name = names[step % 4];
+        int64_t value = step * 7 % 23 - 11;
+        ASSERT_TRUE(eval.set(name, value));
+        table.set(name, value);
+        EXPECT_EQ(eval.value(), parsed->getValue()) << "step " << step;
+    }
+}
+
+TEST(IncrementalTest, RecomputesOnlyTheDirtyPath) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena(balancedSum(0, 64));
+    for (int i = 0; i < 64; ++i) table.set("x" + std::to_string(i), i);
+    IncrementalEvaluator eval(parsed.get());
+    EXPECT_EQ(eval.value(), 64 * 63 / 2);
+
+    // Nothing changed: nothing to do.
+    EXPECT_EQ(eval.value(), 64 * 63 / 2);
+    EXPECT_EQ(eval.lastRecomputed(), 0u);
+
+    // One leaf and its six ancestors in a tree of height six.
+    eval.set("x17", 1017);
+    EXPECT_EQ(eval.value(), 64 * 63 / 2 + 1000);
+    EXPECT_EQ(eval.lastRecomputed(), 7u);
+
+    // Rebinding to the current value is not a change.
+    eval.set("x17", 1017);
+    EXPECT_EQ(eval.value(), 64 * 63 / 2 + 1000);
+    EXPECT_EQ(eval.lastRecomputed(), 0u);
+
+    // Two updates before reading share the upper part of their paths.
+    eval.set("x0", 100);
+    eval.set("x1", 101);
+    EXPECT_EQ(eval.value(), 64 * 63 / 2 + 1000 + 100 + 100);
+    EXPECT_EQ(eval.lastRecomputed(), 8u);
+}
+
+TEST(IncrementalTest, VariableReadTwice) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("x*x + (y - x)");
+    IncrementalEvaluator eval(parsed.get());
+    EXPECT_EQ(eval.value(), 0);
+    eval.set(table.find("x"), 3);
+    EXPECT_EQ(eval.value(), 9 + (0 - 3));
+    EXPECT_FALSE(eval.set("z", 1));
+}
+
+TEST(IncrementalTest, ErrorsClearWhenInputsChange) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("10 / d + sqrt(s)");
+    table.set("s", 16);
+    IncrementalEvaluator eval(parsed.get());
+    EXPECT_THROW(eval.value(), std::runtime_error);
+    EXPECT_EQ(eval.tryValue().error().code, ErrorCode::DIVIDE_BY_ZERO);
+    eval.set("d", 2);
+    EXPECT_EQ(eval.value(), 9);
+    eval.set("s", -1);
+    EXPECT_EQ(eval.tryValue().error().code, ErrorCode::DOMAIN_ERROR);
+    eval.set("s", 25);
+    EXPECT_EQ(eval.value(), 10);
+}
+
+TEST(IncrementalTest, DivisionOverflowIsAnError) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("x / y");
+    IncrementalEvaluator eval(parsed.get());
+    eval.set("x", INT64_MIN);
+    eval.set("y", -1);
+    EXPECT_EQ(eval.tryValue().error().code, ErrorCode::DIVIDE_OVERFLOW);
+    EXPECT_THROW(eval.value(), std::runtime_error);
+    eval.set("y", 1);
+    EXPECT_EQ(eval.value(), INT64_MIN);
+}
+
+TEST(IncrementalTest, ConstantExpression) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("6*7");
+    IncrementalEvaluator eval(parsed.get());
+    EXPECT_EQ(eval.value(), 42);
+    eval.set(0, 5);
+    EXPECT_EQ(eval.value(), 42);
+    EXPECT_EQ(eval.lastRecomputed(), 0u);
+}
+
+TEST(IncrementalTest, DeepTrees) {
+    const int depth = 200000;
+    std::string input;
+    for (int i = 0; i < depth; ++i) input += "1+(";
+    input += "x" + std::string(depth, ')');
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena(input);
+    ASSERT_TRUE(parsed);
+    IncrementalEvaluator eval(parsed.get());
+    EXPECT_EQ(eval.value(), depth);
+    eval.set("x", 5);
+    EXPECT_EQ(eval.value(), depth + 5);
+}
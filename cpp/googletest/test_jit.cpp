@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include "jit.h"
+#include "parser.h"
+
+TEST(JitTest, MatchesTreeEvaluation) {
+    const char *inputs[] = {
+        "42", "2+3", "2+3*4", "(2+3)*4", "10-6/2", "1+2*(3+4)-5/5", "1-2+3",
+        "100000*200000", "7/2-9/4", "0-7/2", "(1-100)/7", "2147483647*2147483647",
+    };
+    Parser parser;
+    for (const char *input : inputs) {
+        ParsedExpression parsed = parser.parseInArena(input);
+        ASSERT_TRUE(parsed) << input;
+        JitFunction jit(parsed.get());
+        EXPECT_EQ(jit.isNative(), JitFunction::supported());
+        EXPECT_EQ(jit(), parsed->getValue()) << input;
+    }
+}
+
+TEST(JitTest, ReadsVariables) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("x*3+y/2-(x-y)*7");
+    ASSERT_TRUE(parsed);
+    JitFunction jit(parsed.get());
+    for (int64_t x = -50; x <= 50; x += 7) {
+        for (int64_t y = -30; y <= 30; y += 11) {
+            table.set("x", x);
+            table.set("y", y);
+            EXPECT_EQ(jit(table.data()), parsed->getValue());
+        }
+    }
+}
+
+TEST(JitTest, DeepExpression) {
+    std::string input;
+    for (int i = 0; i < 300; ++i) input += std::to_string(i % 5 + 1) + "-(";
+    input += "1" + std::string(300, ')');
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    ASSERT_TRUE(parsed);
+    JitFunction jit(parsed.get());
+    EXPECT_EQ(jit(), parsed->getValue());
+}
+
+TEST(JitTest, VeryDeepExpressionFallsBack) {
+    // Too deep to keep on the machine stack; runs as bytecode instead.
+    const int depth = 200000;
+    std::string input;
+    for (int i = 0; i < depth; ++i) input += "1+(";
+    input += "1" + std::string(depth, ')');
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    ASSERT_TRUE(parsed);
+    JitFunction jit(parsed.get());
+    EXPECT_FALSE(jit.isNative());
+    EXPECT_EQ(jit(), depth + 1);
+}
+
+TEST(JitTest, DivideByZero) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("1 + (3 * 4) / d");
+    ASSERT_TRUE(parsed);
+    JitFunction jit(parsed.get());
+    int64_t d = 0;
+    EXPECT_THROW(jit(&d), std::runtime_error);
+    d = 4;
+    EXPECT_EQ(jit(&d), 4);
+
+    if (jit.isNative()) {
+        int error = 0;
+        d = 0;
+        EXPECT_EQ(jit.native()(&d, &error), 0);
+        EXPECT_EQ(error, 1);
+    }
+}
+
+TEST(JitTest, DivisionOverflow) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("n / d + 1");
+    ASSERT_TRUE(parsed);
+    JitFunction jit(parsed.get());
+    int64_t vars[2];
+    size_t n = table.find("n"), d = table.find("d");
+    vars[n] = INT64_MIN;
+    vars[d] = -1;
+    EXPECT_THROW(jit(vars), std::overflow_error);
+    vars[d] = 2;
+    EXPECT_EQ(jit(vars), INT64_MIN / 2 + 1);
+    vars[n] = 7;
+    vars[d] = -1;
+    EXPECT_EQ(jit(vars), -6);
+
+    if (jit.isNative()) {
+        int error = 0;
+        vars[n] = INT64_MIN;
+        EXPECT_EQ(jit.native()(vars, &error), 0);
+        EXPECT_EQ(error, JitFunction::kDivideOverflow);
+    }
+}
+
+TEST(JitTest, MoveKeepsCode) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("6*7");
+    JitFunction a(parsed.get());
+    JitFunction b(std::move(a));
+    EXPECT_FALSE(a.isNative());
+    EXPECT_EQ(b(), 42);
+}
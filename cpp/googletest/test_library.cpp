@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "library.h"
+#include "parser.h"
+
+namespace {
+
+// Library bytes in 8-byte aligned storage, as load() requires.
+struct Buffer {
+    std::vector<uint64_t> words;
+    size_t size;
+    explicit Buffer(const std::string &bytes) : words((bytes.size() + 7) / 8), size(bytes.size()) {
+        std::memcpy(words.data(), bytes.data(), bytes.size());
+    }
+    char *data() { return reinterpret_cast<char *>(words.data()); }
+};
+
+const char *kFormulas[] = {
+    "price * qty - discount",
+    "(price + 3) / (qty - 1)",
+    "sqrt(abs(discount - 100)) + 7",
+    "42",
+};
+
+std::string build() {
+    LibraryBuilder builder;
+    for (const char *f : kFormulas) EXPECT_TRUE(builder.add(f));
+    return builder.serialize();
+}
+
+}  // namespace
+
+TEST(LibraryTest, EvaluatesLikeTheTree) {
+    Buffer buffer(build());
+    ExpressionLibrary library;
+    ASSERT_EQ(library.load(buffer.data(), buffer.size), ExpressionLibrary::Status::OK);
+    ASSERT_EQ(library.size(), 4u);
+    ASSERT_EQ(library.variableCount(), 3u);
+    EXPECT_EQ(library.variableName(1), "qty");
+
+    int64_t vars[3];
+    vars[library.findVariable("price")] = 25;
+    vars[library.findVariable("qty")] = 4;
+    vars[library.findVariable("discount")] = 19;
+    EXPECT_EQ(library.findVariable("tax"), VariableTable::npos);
+
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    for (size_t i = 0; i < library.size(); ++i) {
+        ParsedExpression parsed = parser.parseInArena(kFormulas[i]);
+        for (size_t slot = 0; slot < table.size(); ++slot) {
+            table.set(slot, vars[library.findVariable(table.name(slot))]);
+        }
+        EXPECT_EQ(library.evaluate(i, vars), parsed->getValue()) << kFormulas[i];
+    }
+}
+
+TEST(LibraryTest, SerializationIsDeterministic) {
+    EXPECT_EQ(build(), build());
+}
+
+TEST(LibraryTest, MapsFiles) {
+    std::string path = testing::TempDir() + "test_library.exprlib";
+    LibraryBuilder builder;
+    ASSERT_TRUE(builder.add("a / b"));
+    ASSERT_TRUE(builder.save(path));
+
+    ExpressionLibrary library;
+    ASSERT_EQ(library.open(path), ExpressionLibrary::Status::OK);
+    ExpressionLibrary moved = std::move(library);
+    EXPECT_EQ(library.size(), 0u);
+    int64_t vars[] = {17, 5};
+    EXPECT_EQ(moved.evaluate(0, vars), 3);
+    vars[1] = 0;
+    EXPECT_THROW(moved.evaluate(0, vars), std::runtime_error);
+    std::remove(path.c_str());
+
+    EXPECT_EQ(library.open(path), ExpressionLibrary::Status::CANNOT_OPEN);
+}
+
+TEST(LibraryTest, ReportsParseErrors) {
+    LibraryBuilder builder;
+    Result<size_t> added = builder.add("1 + (2");
+    ASSERT_FALSE(added);
+    EXPECT_EQ(added.error().code, ErrorCode::EXPECTED_RPAREN);
+    EXPECT_EQ(builder.size(), 0u);
+    EXPECT_EQ(*builder.add("2*2"), 0u);
+}
+
+TEST(LibraryTest, DivisionErrors) {
+    LibraryBuilder builder;
+    ASSERT_TRUE(builder.add("a / b"));
+    Buffer buffer(builder.serialize());
+    ExpressionLibrary library;
+    ASSERT_EQ(library.load(buffer.data(), buffer.size), ExpressionLibrary::Status::OK);
+    int64_t vars[2];
+    vars[library.findVariable("a")] = INT64_MIN;
+    vars[library.findVariable("b")] = -1;
+    EXPECT_THROW(library.evaluate(0, vars), std::overflow_error);
+    EXPECT_EQ(library.tryEvaluate(0, vars).error().code, ErrorCode::DIVIDE_OVERFLOW);
+    vars[library.findVariable("b")] = 0;
+    EXPECT_EQ(library.tryEvaluate(0, vars).error().code, ErrorCode::DIVIDE_BY_ZERO);
+    vars[library.findVariable("b")] = 2;
+    EXPECT_EQ(*library.tryEvaluate(0, vars), INT64_MIN / 2);
+}
+
+TEST(LibraryTest, ChecksFormulaIndices) {
+    std::string bytes = build();
+    Buffer buffer(bytes);
+    ExpressionLibrary library;
+    ASSERT_EQ(library.load(buffer.data(), buffer.size), ExpressionLibrary::Status::OK);
+    size_t last = library.size() - 1;
+    EXPECT_EQ(library.evaluate(last), 42);
+    EXPECT_EQ(library.nodeCount(last), 1u);
+    EXPECT_THROW(library.evaluate(last + 1), std::out_of_range);
+    EXPECT_THROW(library.nodeCount(last + 1), std::out_of_range);
+    EXPECT_EQ(library.tryEvaluate(last + 1).error().code, ErrorCode::UNKNOWN_FORMULA);
+    ExpressionLibrary empty;
+    EXPECT_EQ(empty.tryEvaluate(0).error().code, ErrorCode::UNKNOWN_FORMULA);
+}
+
+TEST(LibraryTest, DeepFormulas) {
+    const int depth = 200000;
+    std::string input;
+    for (int i = 0; i < depth; ++i) input += "1+(";
+    input += "1" + std::string(depth, ')');
+    LibraryBuilder builder;
+    ASSERT_TRUE(builder.add(input));
+    Buffer buffer(builder.serialize());
+    ExpressionLibrary library;
+    ASSERT_EQ(library.load(buffer.data(), buffer.size), ExpressionLibrary::Status::OK);
+    EXPECT_EQ(library.evaluate(0), depth + 1);
+}
+
+TEST(LibraryTest, RejectsBadFiles) {
+    std::string bytes = build();
+    ExpressionLibrary library;
+
+    Buffer text(std::string("1+2\n") + std::string(100, ' '));
+    EXPECT_EQ(library.load(text.data(), text.size), ExpressionLibrary::Status::NOT_A_LIBRARY);
+
+    std::string newer = bytes;
+    newer[8] = 2;
+    Buffer newerBuffer(newer);
+    EXPECT_EQ(library.load(newerBuffer.data(), newerBuffer.size),
+              ExpressionLibrary::Status::UNSUPPORTED_VERSION);
+
+    Buffer truncated(bytes.substr(0, bytes.size() - 1));
+    EXPECT_EQ(library.load(truncated.data(), truncated.size), ExpressionLibrary::Status::CORRUPT);
+
+    // Turn the first formula's leading leaf into an operator: the stack
+    // underflows, which only the verifying load notices.
+    Buffer broken(bytes);
+    size_t firstNode = sizeof(LibraryHeader) + 4 * sizeof(LibraryFormula);
+    broken.data()[firstNode] = static_cast<char>(FlatOp::ADD);
+    EXPECT_EQ(library.load(broken.data(), broken.size), ExpressionLibrary::Status::CORRUPT);
+    EXPECT_EQ(library.load(broken.data(), broken.size, false), ExpressionLibrary::Status::OK);
+
+    // A variable slot past the name table.
+    Buffer badSlot(bytes);
+    FlatNode node;
+    std::memcpy(&node, badSlot.data() + firstNode, sizeof(node));
+    ASSERT_EQ(node.op, FlatOp::VARIABLE);
+    node.immediate = 3;
+    std::memcpy(badSlot.data() + firstNode, &node, sizeof(node));
+    EXPECT_EQ(library.load(badSlot.data(), badSlot.size), ExpressionLibrary::Status::CORRUPT);
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+#include "numeric.h"
+#include "optimizer.h"
+#include "parser.h"
+
+TEST(BigIntTest, ParseAndPrintRoundTrip) {
+    const char *values[] = {"0", "1", "-1", "4294967295", "4294967296", "-9223372036854775808",
+                            "123456789012345678901234567890", "-1000000000000000000000000000"};
+    for (const char *v : values) EXPECT_EQ(BigInt::parse(v).toString(), v);
+    EXPECT_EQ(BigInt::parse("-0").toString(), "0");
+    EXPECT_THROW(BigInt::parse("12a"), std::invalid_argument);
+    EXPECT_THROW(BigInt::parse("-"), std::invalid_argument);
+}
+
+TEST(BigIntTest, ArithmeticMatchesInt64InRange) {
+    const int64_t values[] = {0, 1, -1, 7, -7, 1000000007, -3000000000, INT32_MAX, INT32_MIN};
+    for (int64_t a : values) {
+        for (int64_t b : values) {
+            int64_t out;
+            EXPECT_TRUE((BigInt(a) + BigInt(b)).toInt64(out)); EXPECT_EQ(out, a + b);
+            EXPECT_TRUE((BigInt(a) - BigInt(b)).toInt64(out)); EXPECT_EQ(out, a - b);
+            EXPECT_TRUE((BigInt(a) * BigInt(b)).toInt64(out)); EXPECT_EQ(out, a * b);
+            if (b != 0) {
+                EXPECT_TRUE((BigInt(a) / BigInt(b)).toInt64(out)); EXPECT_EQ(out, a / b);
+                EXPECT_TRUE((BigInt(a) % BigInt(b)).toInt64(out)); EXPECT_EQ(out, a % b);
+            }
+            EXPECT_EQ(BigInt(a) < BigInt(b), a < b);
+        }
+    }
+    EXPECT_THROW(BigInt(1) / BigInt(0), std::runtime_error);
+}
+
+TEST(BigIntTest, LargeValues) {
+    BigInt a = BigInt::parse("123456789012345678901234567890");
+    BigInt b = BigInt::parse("987654321098765432109876543210");
+    EXPECT_EQ((a * b).toString(), "121932631137021795226185032733622923332237463801111263526900");
+    EXPECT_EQ(((a * b) / b).toString(), a.toString());
+    EXPECT_EQ((b / a).toString(), "8");
+    EXPECT_EQ((b % a).toString(), "9000000000900000000090");
+    EXPECT_EQ((-b / a).toString(), "-8");
+    EXPECT_EQ((a * a).sqrt().toString(), a.toString());
+    EXPECT_EQ((a * a - BigInt(1)).sqrt().toString(), (a - BigInt(1)).toString());
+    int64_t out;
+    EXPECT_FALSE(a.toInt64(out));
+    EXPECT_THROW(BigInt(-4).sqrt(), std::runtime_error);
+}
+
+namespace {
+struct Parsed {
+    VariableTable table;
+    ParsedExpression tree;
+    Program program;
+    explicit Parsed(const char *text) {
+        Parser parser;
+        parser.setVariables(&table);
+        tree = parser.parseInArena(text);
+        if (tree) program = BytecodeCompiler().compile(tree.get());
+    }
+};
+}
+
+TEST(NumericModeTest, ReadmeExampleInEveryMode) {
+    Parsed p("(3 + 4) * (2 - 1) / 5 + sqrt(16)");
+    ASSERT_TRUE(p.tree);
+    EXPECT_EQ(p.tree->getValue(), 5);
+    EXPECT_EQ(evaluateAs<CheckedInt64>(p.tree.get()), 5);
+    EXPECT_DOUBLE_EQ(evaluateAs<Float64>(p.tree.get()), 5.4);
+    EXPECT_EQ(evaluateAs<BigInteger>(p.tree.get()).toString(), "5");
+    EXPECT_DOUBLE_EQ(executeAs<Float64>(p.program), 5.4);
+    EXPECT_EQ(executeAs<BigInteger>(p.program).toString(), "5");
+}
+
+TEST(NumericModeTest, CheckedOverflowThrows) {
+    Parsed p("2000000000*2000000000*2000000000");
+    ASSERT_TRUE(p.tree);
+    EXPECT_THROW(evaluateAs<CheckedInt64>(p.tree.get()), std::overflow_error);
+    EXPECT_THROW(executeAs<CheckedInt64>(p.program), std::overflow_error);
+    EXPECT_EQ(evaluateAs<BigInteger>(p.tree.get()).toString(), "8000000000000000000000000000");
+    EXPECT_DOUBLE_EQ(evaluateAs<Float64>(p.tree.get()), 8e27);
+    EXPECT_THROW(CheckedInt64::apply(Operator::DIV, INT64_MIN, -1), std::overflow_error);
+    EXPECT_THROW(CheckedInt64::call(Operator::ABS, INT64_MIN), std::overflow_error);
+}
+
+TEST(NumericModeTest, LiteralsBeyondInt32) {
+    Parsed p("9223372036854775807 + 3000000000");
+    ASSERT_TRUE(p.tree);
+    EXPECT_EQ(p.tree->getValue(), INT64_MIN + 2999999999);
+    EXPECT_EQ(p.program.execute(), INT64_MIN + 2999999999);
+    EXPECT_THROW(evaluateAs<CheckedInt64>(p.tree.get()), std::overflow_error);
+    EXPECT_EQ(evaluateAs<BigInteger>(p.tree.get()).toString(), "9223372039854775807");
+    EXPECT_EQ(executeAs<BigInteger>(p.program).toString(), "9223372039854775807");
+}
+
+TEST(NumericModeTest, RealLiteralsAreExactInFloat64) {
+    Parser parser;
+    parser.setRealLiterals(true);
+    ParsedExpression tree = parser.parseInArena("1.5 * 4 + 0.25 / 0.5");
+    ASSERT_TRUE(tree);
+    EXPECT_DOUBLE_EQ(evaluateAs<Float64>(tree.get()), 6.5);
+    // The integer modes truncate each literal: 1*4 + 0/0.
+    EXPECT_THROW(tree->getValue(), std::runtime_error);
+    EXPECT_EQ(evaluateAs<CheckedInt64>(parser.parseInArena("2.75 * 4").get()), 8);
+    EXPECT_EQ(evaluateAs<BigInteger>(parser.parseInArena("2.75 * 4").get()).toString(), "8");
+
+    // Folding keeps the literal for Float64 and still folds around it.
+    Arena arena;
+    ParsedExpression mixed = parser.parseInArena("(2 + 3) * 0.1");
+    IExpression *folded = ConstantFolder(arena).fold(mixed.get());
+    std::ostringstream oss;
+    folded->print(oss);
+    EXPECT_EQ(oss.str(), "(5*0.1)");
+    EXPECT_DOUBLE_EQ(evaluateAs<Float64>(folded), 0.5);
+}
+
+TEST(NumericModeTest, BigLiteralsOnlyFitBigInteger) {
+    Parser parser;
+    parser.setBigLiterals(true);
+    ParsedExpression tree = parser.parseInArena("99999999999999999999 * 10");
+    ASSERT_TRUE(tree);
+    EXPECT_EQ(evaluateAs<BigInteger>(tree.get()).toString(), "999999999999999999990");
+    EXPECT_THROW(tree->getValue(), std::out_of_range);
+    EXPECT_EQ(tryEvaluate(tree.get()).error().code, ErrorCode::NUMBER_OUT_OF_RANGE);
+    EXPECT_THROW(evaluateAs<CheckedInt64>(tree.get()), std::out_of_range);
+    EXPECT_THROW(evaluateAs<Float64>(tree.get()), std::out_of_range);
+
+    // The folder keeps the literal for BigInteger.
+    Arena arena;
+    ParsedExpression mixed = parser.parseInArena("(2 + 3) * 1e20");
+    IExpression *folded = ConstantFolder(arena).fold(mixed.get());
+    EXPECT_EQ(evaluateAs<BigInteger>(folded).toString(), "500000000000000000000");
+}
+
+TEST(NumericModeTest, DivisionByZeroPerMode) {
+    Parsed p("1/(2-2)");
+    EXPECT_THROW(evaluateAs<CheckedInt64>(p.tree.get()), std::runtime_error);
+    EXPECT_THROW(evaluateAs<BigInteger>(p.tree.get()), std::runtime_error);
+    EXPECT_TRUE(std::isinf(evaluateAs<Float64>(p.tree.get())));
+    Parsed q("sqrt(0-1)");
+    EXPECT_TRUE(std::isnan(evaluateAs<Float64>(q.tree.get())));
+}
+
+TEST(NumericModeTest, TypedVariableBindings) {
+    Parsed p("x*x/y + abs(y)");
+    ASSERT_TRUE(p.tree);
+    size_t x = p.table.find("x"), y = p.table.find("y");
+    double doubles[2];
+    doubles[x] = 1.5;
+    doubles[y] = -0.5;
+    EXPECT_DOUBLE_EQ(evaluateAs<Float64>(p.tree.get(), doubles), -4.0);
+    EXPECT_DOUBLE_EQ(executeAs<Float64>(p.program, doubles), -4.0);
+
+    BigInt bigs[2];
+    bigs[x] = BigInt::parse("100000000000000000000");
+    bigs[y] = BigInt(-3);
+    EXPECT_EQ(evaluateAs<BigInteger>(p.tree.get(), bigs).toString(), "-3333333333333333333333333333333333333330");
+    EXPECT_EQ(executeAs<BigInteger>(p.program, bigs).toString(), "-3333333333333333333333333333333333333330");
+
+    // Without bindings, variables come from the table the tree was parsed with.
+    p.table.set(x, 6);
+    p.table.set(y, 4);
+    EXPECT_EQ(evaluateAs<CheckedInt64>(p.tree.get()), 13);
+    EXPECT_DOUBLE_EQ(evaluateAs<Float64>(p.tree.get()), 13.0);
+}
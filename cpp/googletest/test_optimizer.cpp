@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "optimizer.h"
+#include "parser.h"
+
+namespace {
+std::string printed(const IExpression *expr) {
+    std::ostringstream oss;
+    expr->print(oss);
+    return oss.str();
+}
+
+struct Folded {
+    VariableTable table;
+    Arena arena;
+    ParsedExpression original;
+    IExpression *optimized = nullptr;
+    size_t eliminated = 0;
+
+    explicit Folded(const std::string &input) {
+        Parser parser;
+        parser.setVariables(&table);
+        original = parser.parseInArena(input);
+        if (!original) throw std::invalid_argument(input);
+        ConstantFolder folder(arena);
+        optimized = folder.fold(original.get());
+        eliminated = folder.eliminated();
+    }
+};
+}
+
+TEST(ConstantFolderTest, FoldsConstantSubtrees) {
+    Folded f("(3 + 4) * (2 - 1)");
+    EXPECT_EQ(printed(f.optimized), "7");
+    EXPECT_EQ(f.eliminated, 6u);
+}
+
+TEST(ConstantFolderTest, FoldsAroundVariables) {
+    Folded f("x * (2 + 3) - 10 / 5");
+    EXPECT_EQ(printed(f.optimized), "((x*5)-2)");
+    EXPECT_EQ(f.eliminated, 4u);
+}
+
+TEST(ConstantFolderTest, AppliesIdentities) {
+    EXPECT_EQ(printed(Folded("x * 1").optimized), "x");
+    EXPECT_EQ(printed(Folded("1 * x").optimized), "x");
+    EXPECT_EQ(printed(Folded("x + 0").optimized), "x");
+    EXPECT_EQ(printed(Folded("0 + x").optimized), "x");
+    EXPECT_EQ(printed(Folded("x - 0").optimized), "x");
+    EXPECT_EQ(printed(Folded("x / 1").optimized), "x");
+    EXPECT_EQ(printed(Folded("x * (3 - 2) + (5 - 5)").optimized), "x");
+    EXPECT_EQ(printed(Folded("(x + y) * 0").optimized), "0");
+}
+
+TEST(ConstantFolderTest, KeepsDivisionHazards) {
+    // x*0 must still fail when the division does.
+    EXPECT_EQ(printed(Folded("(1 / x) * 0").optimized), "((1/x)*0)");
+    EXPECT_EQ(printed(Folded("0 * (y / x)").optimized), "(0*(y/x))");
+    // Constant divide by zero stays for the evaluator to report.
+    Folded f("(2 + 2) / (3 - 3)");
+    EXPECT_EQ(printed(f.optimized), "(4/0)");
+    EXPECT_THROW(f.optimized->getValue(), std::runtime_error);
+}
+
+TEST(ConstantFolderTest, DoesNotFoldOverflowingResults) {
+    EXPECT_EQ(printed(Folded("100000 * 200000").optimized), "20000000000");
+    Folded f("9223372036854775807 + 1");
+    EXPECT_EQ(printed(f.optimized), "(9223372036854775807+1)");
+    EXPECT_EQ(f.optimized->getValue(), INT64_MIN);
+    Folded g("(0 - 9223372036854775807 - 1) / (0 - 1)");
+    EXPECT_THROW(g.optimized->getValue(), std::overflow_error);
+}
+
+TEST(ConstantFolderTest, MatchesUnoptimizedTree) {
+    const char *inputs[] = {
+        "x * 3 + y / 2", "(x + 0) * (1 * y) - (4 - 4) * x", "(1 + 2) * x / (5 - 4)",
+        "x / (y - y) * 0", "((x * 0) + (y * 1)) / (2 * 1)", "x - (3 * (2 - 2))",
+        "(7 / 2) * x + (9 / 3) * y", "0 * (x * y) + 0 / (x + 1)",
+    };
+    for (const char *input : inputs) {
+        Folded f(input);
+        size_t x = f.table.declare("x"), y = f.table.declare("y");
+        for (int64_t xv = -3; xv <= 3; ++xv) {
+            for (int64_t yv = -3; yv <= 3; ++yv) {
+                f.table.set(x, xv);
+                f.table.set(y, yv);
+                bool threw = false, optimizedThrew = false;
+                int64_t expected = 0, actual = 0;
+                try { expected = f.original->getValue(); } catch (const std::runtime_error &) { threw = true; }
+                try { actual = f.optimized->getValue(); } catch (const std::runtime_error &) { optimizedThrew = true; }
+                ASSERT_EQ(threw, optimizedThrew) << input << " x=" << xv << " y=" << yv;
+                if (!threw) {
+                    ASSERT_EQ(expected, actual) << input << " x=" << xv << " y=" << yv;
+                }
+            }
+        }
+    }
+}
+
+TEST(ConstantFolderTest, CountNodes) {
+    Folded f("(1 + x) * 2");
+    EXPECT_EQ(countNodes(f.original.get()), 5u);
+    EXPECT_EQ(countNodes(nullptr), 0u);
+}
+
+TEST(ConstantFolderTest, DeepTrees) {
+    const int depth = 200000;
+    std::string mixed, constant;
+    for (int i = 0; i < depth; ++i) {
+        mixed += (i % 2 ? "1+(" : "x*(");
+        constant += "1+(";
+    }
+    mixed += "x" + std::string(depth, ')');
+    constant += "1" + std::string(depth, ')');
+
+    Folded f(mixed);
+    EXPECT_EQ(countNodes(f.original.get()), size_t(2 * depth + 1));
+    f.table.set("x", 1);
+    EXPECT_EQ(f.optimized->getValue(), f.original->getValue());
+
+    Folded folded(constant);
+    EXPECT_EQ(printed(folded.optimized), std::to_string(depth + 1));
+}
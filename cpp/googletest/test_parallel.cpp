@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include "parallel.h"
+#include "parser.h"
+
+TEST(ThreadPoolTest, CoversEveryIndexOnce) {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.size(), 4u);
+    std::vector<std::atomic<int>> hits(1001);
+    pool.parallelFor(hits.size(), 7, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) hits[i].fetch_add(1);
+    });
+    for (size_t i = 0; i < hits.size(); ++i) EXPECT_EQ(hits[i].load(), 1) << i;
+}
+
+TEST(ThreadPoolTest, PropagatesExceptions) {
+    ThreadPool pool(3);
+    EXPECT_THROW(pool.parallelFor(100, 1, [](size_t begin, size_t) {
+        if (begin == 42) throw std::runtime_error("boom");
+    }), std::runtime_error);
+    // The pool stays usable afterwards.
+    std::atomic<size_t> sum{0};
+    pool.parallelFor(10, 3, [&](size_t begin, size_t end) { sum += end - begin; });
+    EXPECT_EQ(sum.load(), 10u);
+}
+
+TEST(ThreadPoolTest, NestedCallsDoNotDeadlock) {
+    for (size_t threads : {1u, 2u}) {
+        ThreadPool pool(threads);
+        std::vector<std::atomic<int>> hits(64 * 50);
+        pool.parallelFor(64, 1, [&](size_t outer, size_t) {
+            pool.parallelFor(50, 3, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) hits[outer * 50 + i].fetch_add(1);
+            });
+        });
+        for (size_t i = 0; i < hits.size(); ++i) EXPECT_EQ(hits[i].load(), 1) << i;
+    }
+    // A body that itself evaluates expressions in parallel.
+    ThreadPool pool(1);
+    std::vector<int64_t> values(4);
+    pool.parallelFor(values.size(), 1, [&](size_t begin, size_t) {
+        auto results = parallelEvaluate(pool, {"6 * 7", "1 + " + std::to_string(begin)}, 1);
+        values[begin] = results[0].value + results[1].value;
+    });
+    EXPECT_EQ(values, (std::vector<int64_t>{43, 44, 45, 46}));
+}
+
+TEST(ParallelEvaluateTest, BatchMatchesSerial) {
+    ThreadPool pool(4);
+    CompiledExpression expr("x * 3 + y / 2");
+    const size_t rows = 100000;
+    std::vector<int64_t> x(rows), y(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        x[i] = int64_t(i) - 5000;
+        y[i] = int64_t(i % 97) + 1;
+    }
+    std::vector<ColumnView> columns(2);
+    columns[expr.slot("x")] = ColumnView{x.data(), rows};
+    columns[expr.slot("y")] = ColumnView{y.data(), rows};
+
+    std::vector<int64_t> serial(rows), parallel(rows);
+    evaluateBatch(expr.code(), columns, rows, serial.data());
+    parallelEvaluateBatch(pool, expr.code(), columns, rows, parallel.data(), 1000);
+    EXPECT_EQ(serial, parallel);
+}
+
+TEST(ParallelEvaluateTest, SharedTreeAcrossThreads) {
+    ThreadPool pool(4);
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("a - b * 2");
+    ASSERT_TRUE(parsed);
+    std::vector<int64_t> a(5000, 10), b(5000), out(5000);
+    for (size_t i = 0; i < b.size(); ++i) b[i] = int64_t(i);
+    std::vector<ColumnView> columns(2);
+    columns[table.find("a")] = ColumnView{a.data(), a.size()};
+    columns[table.find("b")] = ColumnView{b.data(), b.size()};
+    parallelEvaluateBatch(pool, parsed.get(), columns, a.size(), out.data(), 128);
+    for (size_t i = 0; i < out.size(); ++i) EXPECT_EQ(out[i], 10 - 2 * int64_t(i));
+}
+
+TEST(ParallelEvaluateTest, ReportsLowestFailingRow) {
+    ThreadPool pool(4);
+    CompiledExpression expr("1000 / d");
+    std::vector<int64_t> d(50000, 1), out(50000);
+    d[45000] = 0;
+    d[12345] = 0;
+    try {
+        parallelEvaluateBatch(pool, expr.code(), {ColumnView{d.data(), d.size()}},
+                              d.size(), out.data(), 1000);
+        FAIL() << "expected DivideByZeroError";
+    } catch (const DivideByZeroError &e) {
+        EXPECT_EQ(e.row(), 12345u);
+    }
+}
+
+TEST(ParallelEvaluateTest, ReportsDivisionOverflow) {
+    ThreadPool pool(4);
+    CompiledExpression expr("n / d");
+    std::vector<int64_t> n(20000, INT64_MIN), d(20000, 2), out(20000);
+    d[15000] = 0;
+    d[9000] = -1;
+    std::vector<ColumnView> columns(2);
+    columns[expr.slot("n")] = ColumnView{n.data(), n.size()};
+    columns[expr.slot("d")] = ColumnView{d.data(), d.size()};
+    try {
+        parallelEvaluateBatch(pool, expr.code(), columns, n.size(), out.data(), 1000);
+        FAIL() << "expected DivideOverflowError";
+    } catch (const DivideOverflowError &e) {
+        EXPECT_EQ(e.row(), 9000u);
+    }
+}
+
+TEST(ParallelEvaluateTest, RejectsMissingOrShortColumns) {
+    ThreadPool pool(4);
+    CompiledExpression expr("x + y");
+    std::vector<int64_t> x(4000), out(4000);
+    EXPECT_THROW(parallelEvaluateBatch(pool, expr.code(), {ColumnView{x.data(), x.size()}},
+                                       x.size(), out.data(), 1000),
+                 std::invalid_argument);
+    EXPECT_THROW(parallelEvaluateBatch(pool, expr.code(),
+                                       {ColumnView{x.data(), x.size()}, ColumnView{x.data(), 10}},
+                                       x.size(), out.data(), 1000),
+                 std::invalid_argument);
+}
+
+TEST(ParallelEvaluateTest, IndependentExpressions) {
+    ThreadPool pool(2);
+    std::vector<std::string> inputs;
+    for (int i = 0; i < 500; ++i) inputs.push_back(std::to_string(i) + "*2+1");
+    inputs.push_back("1/0");
+    inputs.push_back("2+*3");
+    auto results = parallelEvaluate(pool, inputs, 16);
+    ASSERT_EQ(results.size(), inputs.size());
+    for (int i = 0; i < 500; ++i) {
+        ASSERT_TRUE(results[i].ok);
+        EXPECT_EQ(results[i].value, i * 2 + 1);
+    }
+    EXPECT_FALSE(results[500].ok);
+    EXPECT_STREQ(results[500].error, "Divide by zero");
+    EXPECT_EQ(results[500].detail.code, ErrorCode::DIVIDE_BY_ZERO);
+    EXPECT_FALSE(results[501].ok);
+    EXPECT_EQ(results[501].detail.code, ErrorCode::EXPECTED_OPERAND);
+    EXPECT_EQ(results[501].detail.offset, 2u);
+}
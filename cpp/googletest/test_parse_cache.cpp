@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "parse_cache.h"
+
+namespace {
+std::string printed(const IExpression *expr) {
+    std::ostringstream oss;
+    expr->print(oss);
+    return oss.str();
+}
+}
+
+TEST(ParseCacheTest, NormalizeKeepsTokenBoundaries) {
+    std::string out;
+    ParseCache::normalize("  ( 3 +\t4 ) * x1  ", out);
+    EXPECT_EQ(out, "( 3 + 4 ) * x1");
+    ParseCache::normalize("(3+4)*x1", out);
+    EXPECT_EQ(out, "( 3 + 4 ) * x1");
+    ParseCache::normalize("1 2", out);
+    EXPECT_EQ(out, "1 2");
+    ParseCache::normalize("a  b+c", out);
+    EXPECT_EQ(out, "a b + c");
+    ParseCache::normalize("1e+ 3", out);
+    EXPECT_EQ(out, "1 e + 3");
+    ParseCache::normalize("2.5e1 $", out);
+    EXPECT_EQ(out, "2.5e1 $");
+}
+
+TEST(ParseCacheTest, SpacingInsideLiteralsIsNotDropped) {
+    ParseCache cache(8);
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    // Each agrees with a direct parse; "1e+ 3" is 1 then the identifier e.
+    for (const char *text : {"1e+ 3", "1e +3", "1e+3", "2 e-1", "x1 + 1", "x 1", "2.5 e1"}) {
+        auto cached = cache.get(text);
+        ParsedExpression direct = parser.parseInArena(text);
+        ASSERT_EQ(cached != nullptr, bool(direct)) << text;
+        if (direct) {
+            EXPECT_EQ(printed(cached->tree.get()), printed(direct.get())) << text;
+        }
+    }
+    EXPECT_EQ(cache.get("1e+ 3"), nullptr);
+    EXPECT_EQ(cache.get("1e+3")->tree->getValue(), 1000);
+    EXPECT_EQ(cache.get(" 1e+3 ")->program.execute(), 1000);
+}
+
+TEST(ParseCacheTest, HitsShareTheSameEntry) {
+    ParseCache cache(8);
+    auto a = cache.get("(3 + 4) * 2");
+    auto b = cache.get("(3+4)*2");
+    ASSERT_NE(a, nullptr);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a->tree->getValue(), 14);
+    EXPECT_EQ(a->program.execute(), 14);
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.size, 1u);
+}
+
+TEST(ParseCacheTest, EvictsLeastRecentlyUsed) {
+    ParseCache cache(2);
+    auto one = cache.get("1");
+    cache.get("2");
+    cache.get("1");  // "2" is now least recently used
+    cache.get("3");
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.size, 2u);
+    EXPECT_EQ(cache.get("1"), one);
+    cache.get("2");
+    EXPECT_EQ(cache.stats().misses, 4u);
+    // Evicted entries stay valid for holders.
+    EXPECT_EQ(one->program.execute(), 1);
+}
+
+TEST(ParseCacheTest, InvalidTextIsNotCached) {
+    ParseCache cache(4);
+    EXPECT_EQ(cache.get("2+*3"), nullptr);
+    EXPECT_EQ(cache.get("2+*3"), nullptr);
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.size, 0u);
+}
+
+TEST(ParseCacheTest, DeepExpressions) {
+    const int depth = 200000;
+    std::string input;
+    for (int i = 0; i < depth; ++i) input += "1+(";
+    input += "1" + std::string(depth, ')');
+    ParseCache cache(8);
+    auto entry = cache.get(input);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->program.execute(), depth + 1);
+}
+
+TEST(ParseCacheTest, EntriesCarryTheirOwnVariables) {
+    ParseCache cache(4);
+    auto entry = cache.get("x*3 + y");
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(entry->variables.size(), 2u);
+    int64_t values[2];
+    values[entry->variables.find("x")] = 5;
+    values[entry->variables.find("y")] = 1;
+    EXPECT_EQ(entry->program.execute(values), 16);
+}
+
+TEST(ParseCacheTest, ConcurrentLookups) {
+    ParseCache cache(16);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, t] {
+            for (int i = 0; i < 2000; ++i) {
+                int k = (i + t) % 32;
+                auto e = cache.get(std::to_string(k) + " * 2");
+                ASSERT_NE(e, nullptr);
+                ASSERT_EQ(e->program.execute(), k * 2);
+            }
+        });
+    }
+    for (auto &th : threads) th.join();
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.hits + stats.misses, 8000u);
+    EXPECT_LE(stats.size, 16u);
+}
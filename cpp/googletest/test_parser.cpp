@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <sstream>
+#include "ast.h"
 #include "parser.h"
 
 // Helper to evaluate and print expression tree as string
@@ -117,3 +118,213 @@ TEST(ParserTest, ParserTest_ComplexExpression_Test) {
     EXPECT_EQ(expr->getValue(), 5);
     delete expr;
 }
+
+TEST(ViewTokenizerTest, TokensReferToInput) {
+    std::string input = "12 + foo*(3)";
+    ViewTokenizer tokenizer(input);
+    TokenView t = tokenizer.next();
+    EXPECT_EQ(t.type, Token::Type::NUM);
+    EXPECT_EQ(t.number, 12);
+    EXPECT_EQ(tokenizer.text(t), "12");
+    EXPECT_EQ(tokenizer.next().type, Token::Type::PLUS);
+    t = tokenizer.next();
+    EXPECT_EQ(t.type, Token::Type::ID);
+    EXPECT_EQ(t.offset, 5u);
+    EXPECT_EQ(tokenizer.text(t), "foo");
+    EXPECT_EQ(tokenizer.next().type, Token::Type::MUL);
+    EXPECT_EQ(tokenizer.next().type, Token::Type::LPAREN);
+    EXPECT_EQ(tokenizer.next().number, 3);
+    EXPECT_EQ(tokenizer.next().type, Token::Type::RPAREN);
+    EXPECT_EQ(tokenizer.next().type, Token::Type::END);
+    EXPECT_EQ(tokenizer.next().type, Token::Type::END);
+}
+
+TEST(ViewTokenizerTest, PeekDoesNotConsume) {
+    ViewTokenizer tokenizer("7 - 8");
+    EXPECT_EQ(tokenizer.peek().type, Token::Type::NUM);
+    EXPECT_EQ(tokenizer.peek().number, 7);
+    EXPECT_EQ(tokenizer.next().number, 7);
+    EXPECT_EQ(tokenizer.peek().type, Token::Type::MINUS);
+    EXPECT_EQ(tokenizer.next().type, Token::Type::MINUS);
+    EXPECT_EQ(tokenizer.next().number, 8);
+}
+
+TEST(ViewTokenizerTest, InvalidCharacterIsSkipped) {
+    ViewTokenizer tokenizer("42$");
+    EXPECT_EQ(tokenizer.next().type, Token::Type::NUM);
+    EXPECT_EQ(tokenizer.next().type, Token::Type::END);
+}
+
+TEST(ViewTokenizerTest, HugeNumberIsOutOfRange) {
+    ViewTokenizer tokenizer("99999999999999999999999 9223372036854775807");
+    TokenView t = tokenizer.next();
+    EXPECT_EQ(t.numberForm, NumberForm::OUT_OF_RANGE);
+    EXPECT_EQ(t.length, 23u);
+    t = tokenizer.next();
+    EXPECT_EQ(t.numberForm, NumberForm::INTEGER);
+    EXPECT_EQ(t.number, INT64_MAX);
+}
+
+TEST(ViewTokenizerTest, DecimalAndExponentLiterals) {
+    ViewTokenizer tokenizer("1.5e3 2.50 1e-3 1200e-2 0.05E+2 7. 4e");
+    TokenView t = tokenizer.next();
+    EXPECT_EQ(tokenizer.text(t), "1.5e3");
+    EXPECT_EQ(t.numberForm, NumberForm::INTEGER);
+    EXPECT_EQ(t.number, 1500);
+    t = tokenizer.next();
+    EXPECT_EQ(t.numberForm, NumberForm::FRACTION);
+    EXPECT_DOUBLE_EQ(tokenizer.real(t), 2.5);
+    t = tokenizer.next();
+    EXPECT_EQ(t.numberForm, NumberForm::FRACTION);
+    EXPECT_DOUBLE_EQ(tokenizer.real(t), 0.001);
+    EXPECT_EQ(tokenizer.next().number, 12);
+    EXPECT_EQ(tokenizer.next().number, 5);
+    EXPECT_EQ(tokenizer.next().number, 7);
+    // An exponent marker without digits is not part of the number.
+    t = tokenizer.next();
+    EXPECT_EQ(tokenizer.text(t), "4");
+    EXPECT_EQ(tokenizer.text(tokenizer.next()), "e");
+}
+
+TEST(ViewTokenizerTest, LiteralsAreDecodedExactly) {
+    // Neither of these is an integer, although both round to one as a double.
+    EXPECT_EQ(lexNumber("2.0000000000000000001").form, NumberForm::FRACTION);
+    EXPECT_EQ(lexNumber("9007199254740993e-1").form, NumberForm::FRACTION);
+    EXPECT_EQ(lexNumber("100000000000000000000000e-10").value, 10000000000000);
+    EXPECT_EQ(lexNumber("9.223372036854775807e18").value, INT64_MAX);
+    EXPECT_EQ(lexNumber("9.223372036854775808e18").form, NumberForm::OUT_OF_RANGE);
+    EXPECT_EQ(lexNumber("1e99999999999999999999").form, NumberForm::OUT_OF_RANGE);
+    EXPECT_EQ(lexNumber("1e-99999999999999999999").form, NumberForm::FRACTION);
+    NumberLiteral zero = lexNumber("0.000e99999999999999999999");
+    EXPECT_EQ(zero.form, NumberForm::INTEGER);
+    EXPECT_EQ(zero.value, 0);
+    EXPECT_EQ(zero.length, 26u);
+}
+
+TEST(TokenizerTest, ParseDecimalNumber) {
+    Tokenizer tokenizer("2.5e-1*3");
+    Token token = tokenizer.next();
+    EXPECT_EQ(token.type, Token::Type::NUM);
+    EXPECT_EQ(token.value, "2.5e-1");
+    EXPECT_EQ(tokenizer.next().type, Token::Type::MUL);
+}
+
+TEST(ParserTest, ExponentLiterals) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("1.5e3 + 2E2/4");
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->getValue(), 1550);
+    EXPECT_FALSE(parser.parseInArena("1.5 + 1"));
+    EXPECT_EQ(parser.error().code, ErrorCode::NON_INTEGER_LITERAL);
+    EXPECT_EQ(parser.parseInArena("3e9")->getValue(), 3000000000LL);
+}
+
+TEST(ParserTest, RealLiterals) {
+    Parser parser;
+    parser.setRealLiterals(true);
+    ParsedExpression parsed = parser.parseInArena("1.5 + 2.5e-1 + 3e2");
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(printExpression(parsed.get()), "((1.5+0.25)+300)");
+    ParsedExpression literal = parser.parseInArena("1.5");
+    NumberNode *half = literal->to<NumberNode *>();
+    ASSERT_NE(half, nullptr);
+    EXPECT_FALSE(half->isInteger());
+    EXPECT_DOUBLE_EQ(half->getReal(), 1.5);
+    EXPECT_EQ(half->getValue(), 1);
+    EXPECT_FALSE(parser.parseInArena("9223372036854775808.5"));
+    EXPECT_EQ(parser.error().code, ErrorCode::NUMBER_OUT_OF_RANGE);
+}
+
+TEST(ParserTest, NumberOutOfRange) {
+    Parser parser;
+    EXPECT_EQ(parser.parseInArena("3000000000+1")->getValue(), 3000000001LL);
+    EXPECT_EQ(parser.parseInArena("9223372036854775807")->getValue(), INT64_MAX);
+    EXPECT_EQ(parser.parse("9223372036854775808"), nullptr);
+    EXPECT_EQ(parser.parse("1e19"), nullptr);
+}
+
+TEST(ParserTest, BigLiterals) {
+    Parser parser;
+    parser.setBigLiterals(true);
+    const char *inputs[][2] = {
+        {"9223372036854775808", "9223372036854775808"},
+        {"1.5e30", "1500000000000000000000000000000"},
+        {"00100000000000000000000000e-2", "1000000000000000000000"},
+        {"12.3400e20", "1234000000000000000000"},
+    };
+    for (const auto &input : inputs) {
+        ParsedExpression parsed = parser.parseInArena(input[0]);
+        ASSERT_TRUE(parsed) << input[0];
+        EXPECT_TRUE(parsed->isOutOfRange());
+        EXPECT_EQ(printExpression(parsed.get()), input[1]);
+        EXPECT_THROW(parsed->getValue(), std::out_of_range);
+    }
+    EXPECT_EQ(parser.parseInArena("1000")->getValue(), 1000);
+    EXPECT_FALSE(parser.parseInArena("1e999999"));
+    EXPECT_EQ(parser.error().code, ErrorCode::NUMBER_OUT_OF_RANGE);
+}
+
+TEST(ParserTest, UnbalancedParentheses) {
+    Parser parser;
+    EXPECT_EQ(parser.parse("(2+3"), nullptr);
+    EXPECT_EQ(parser.parse("((2+3)*4"), nullptr);
+    EXPECT_EQ(parser.parse("(2 3)"), nullptr);
+}
+
+TEST(ParserTest, ParserIsReusable) {
+    Parser parser;
+    EXPECT_EQ(parser.parse("(1+"), nullptr);
+    ParsedExpression parsed = parser.parseInArena("(1+2)*3");
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->getValue(), 9);
+}
+
+TEST(ParserTest, DeeplyNestedParentheses) {
+    const int depth = 200000;
+    std::string input(depth, '(');
+    input += "7";
+    input.append(depth, ')');
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->getValue(), 7);
+}
+
+TEST(ParserTest, DeepRightNestedExpression) {
+    // 1-(1-(1-(...))) builds a right spine as deep as the input is long.
+    const int depth = 100000;
+    std::string input;
+    for (int i = 0; i < depth; ++i) input += "1-(";
+    input += "1";
+    input.append(depth, ')');
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->getValue(), 1);
+    std::ostringstream oss;
+    parsed->print(oss);
+    EXPECT_EQ(oss.str().size(), input.size());
+}
+
+TEST(ParserTest, LongOperatorChain) {
+    const int length = 200000;
+    std::string input = "0";
+    for (int i = 0; i < length; ++i) input += (i % 2) ? "-1" : "+3";
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->getValue(), int64_t(length / 2) * 2);
+}
+
+TEST(ParserTest, ASTPrinterHandlesDeepTrees) {
+    const int length = 100000;
+    std::string input = "1";
+    for (int i = 0; i < length; ++i) input += "+1";
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena(input);
+    ASSERT_TRUE(parsed);
+    std::ostringstream oss;
+    ASTPrinter(oss).print(parsed.get());
+    // "(+ " + left + " 1)" per operator, plus the innermost leaf and newline.
+    EXPECT_EQ(oss.str().size(), size_t(length) * 6 + 2);
+}
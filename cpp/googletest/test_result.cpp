@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include "bytecode.h"
+#include "parser.h"
+
+namespace {
+
+Error parseError(const char *input) {
+    Parser parser;
+    Arena arena;
+    Result<IExpression *> result = parser.tryParse(input, arena);
+    EXPECT_FALSE(result.ok());
+    return result.error();
+}
+
+}  // namespace
+
+TEST(ResultTest, ParseSuccess) {
+    Parser parser;
+    Arena arena;
+    Result<IExpression *> result = parser.tryParse("(1+2)*3", arena);
+    ASSERT_TRUE(result);
+    EXPECT_EQ((*result)->getValue(), 9);
+    EXPECT_EQ(parser.error().code, ErrorCode::NONE);
+}
+
+TEST(ResultTest, ParseErrorsCarryCodeAndOffset) {
+    Error e = parseError("2+*3");
+    EXPECT_EQ(e.code, ErrorCode::EXPECTED_OPERAND);
+    EXPECT_EQ(e.offset, 2u);
+    EXPECT_EQ(e.length, 1u);
+
+    e = parseError("(2+3");
+    EXPECT_EQ(e.code, ErrorCode::EXPECTED_RPAREN);
+    EXPECT_EQ(e.offset, 4u);
+
+    e = parseError("1 + 2 $ 3");
+    EXPECT_EQ(e.code, ErrorCode::INVALID_CHARACTER);
+    EXPECT_EQ(e.offset, 6u);
+
+    e = parseError("4 * foo(2)");
+    EXPECT_EQ(e.code, ErrorCode::UNKNOWN_FUNCTION);
+    EXPECT_EQ(e.offset, 4u);
+    EXPECT_EQ(e.length, 3u);
+
+    // The whole input must be one expression.
+    e = parseError("1 2");
+    EXPECT_EQ(e.code, ErrorCode::UNEXPECTED_TOKEN);
+    EXPECT_EQ(e.offset, 2u);
+    e = parseError("(1+2) )");
+    EXPECT_EQ(e.code, ErrorCode::UNEXPECTED_TOKEN);
+    EXPECT_EQ(e.offset, 6u);
+    EXPECT_EQ(parseError("3 (4)").offset, 2u);
+
+    EXPECT_EQ(parseError("x+1").code, ErrorCode::IDENTIFIERS_DISABLED);
+    EXPECT_EQ(parseError("1.5").code, ErrorCode::NON_INTEGER_LITERAL);
+    EXPECT_EQ(parseError("1+9223372036854775808").offset, 2u);
+    EXPECT_EQ(parseError("").code, ErrorCode::EMPTY_INPUT);
+    EXPECT_EQ(parseError("7-").offset, 2u);
+}
+
+TEST(ResultTest, ParseDoesNotWriteToStderr) {
+    testing::internal::CaptureStderr();
+    Parser parser;
+    EXPECT_EQ(parser.parse("(1+$"), nullptr);
+    EXPECT_EQ(parser.parse("sinh(1)"), nullptr);
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "");
+    EXPECT_EQ(parser.error().code, ErrorCode::UNKNOWN_FUNCTION);
+}
+
+TEST(ResultTest, TokenizerReportsInvalidCharacters) {
+    ViewTokenizer tokenizer("1 # 2");
+    EXPECT_EQ(tokenizer.tryNext().value().number, 1);
+    Result<TokenView> bad = tokenizer.tryNext();
+    ASSERT_FALSE(bad);
+    EXPECT_EQ(bad.error().code, ErrorCode::INVALID_CHARACTER);
+    EXPECT_EQ(bad.error().offset, 2u);
+    EXPECT_EQ(tokenizer.tryNext().value().number, 2);
+    EXPECT_EQ(tokenizer.tryNext().value().type, Token::Type::END);
+}
+
+TEST(ResultTest, EvaluationErrors) {
+    Parser parser;
+    Arena arena;
+    Result<int64_t> value = tryEvaluate(*parser.tryParse("7*(3-3)+1", arena));
+    ASSERT_TRUE(value);
+    EXPECT_EQ(*value, 1);
+
+    value = tryEvaluate(*parser.tryParse("1+2/(3-3)", arena));
+    ASSERT_FALSE(value);
+    EXPECT_EQ(value.error().code, ErrorCode::DIVIDE_BY_ZERO);
+    EXPECT_EQ(value.error().offset, Error::kNoOffset);
+
+    value = tryEvaluate(*parser.tryParse("abs(sqrt(0-4))", arena));
+    ASSERT_FALSE(value);
+    EXPECT_EQ(value.error().code, ErrorCode::DOMAIN_ERROR);
+
+    VariableTable table;
+    parser.setVariables(&table);
+    IExpression *quotient = *parser.tryParse("x / y", arena);
+    table.set("x", INT64_MIN);
+    table.set("y", -1);
+    value = tryEvaluate(quotient);
+    ASSERT_FALSE(value);
+    EXPECT_EQ(value.error().code, ErrorCode::DIVIDE_OVERFLOW);
+    EXPECT_STREQ(value.error().message(), "Division overflow");
+    parser.setVariables(nullptr);
+
+    value = tryEvaluate(*parser.tryParse("42", arena));
+    ASSERT_TRUE(value);
+    EXPECT_EQ(*value, 42);
+}
+
+TEST(ResultTest, ProgramTryExecuteMatchesExecute) {
+    Parser parser;
+    Arena arena;
+    BytecodeCompiler compiler;
+    Program ok = compiler.compile(*parser.tryParse("sqrt(16)*(5-2)", arena));
+    EXPECT_EQ(*ok.tryExecute(), ok.execute());
+    Program divide = compiler.compile(*parser.tryParse("1/(2-2)", arena));
+    EXPECT_EQ(divide.tryExecute().error().code, ErrorCode::DIVIDE_BY_ZERO);
+    Program domain = compiler.compile(*parser.tryParse("sqrt(0-1)", arena));
+    EXPECT_EQ(domain.tryExecute().error().code, ErrorCode::DOMAIN_ERROR);
+    EXPECT_EQ(Program().tryExecute().error().code, ErrorCode::MALFORMED_PROGRAM);
+
+    VariableTable table;
+    parser.setVariables(&table);
+    Program overflow = compiler.compile(*parser.tryParse("x / y", arena));
+    int64_t vars[2];
+    vars[table.find("x")] = INT64_MIN;
+    vars[table.find("y")] = -1;
+    EXPECT_EQ(overflow.tryExecute(vars).error().code, ErrorCode::DIVIDE_OVERFLOW);
+}
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "eval_server.h"
+#include "parse_cache.h"
+#include "result_cache.h"
+
+namespace {
+
+ResultCache::Options oneShard(size_t budgetBytes, ResultCache::Eviction eviction) {
+    ResultCache::Options options;
+    options.budgetBytes = budgetBytes;
+    options.shards = 1;
+    options.eviction = eviction;
+    return options;
+}
+
+// Budget for exactly `entries` entries of one value each.
+size_t budgetFor(size_t entries) {
+    ResultCache probe;
+    int64_t value = 0;
+    probe.insert(1, &value, 1, int64_t(0));
+    return entries * probe.stats().bytes;
+}
+
+bool cached(ResultCache &cache, uint64_t id, int64_t value) {
+    Result<int64_t> result(int64_t(0));
+    return cache.lookup(id, &value, 1, result);
+}
+
+}  // namespace
+
+TEST(ResultCacheTest, KeysOnExpressionAndEveryValue) {
+    ResultCache cache;
+    uint64_t id = newExpressionIds(2);
+    int64_t values[] = {3, 4};
+    Result<int64_t> result(int64_t(0));
+    EXPECT_FALSE(cache.lookup(id, values, 2, result));
+    cache.insert(id, values, 2, int64_t(12));
+    ASSERT_TRUE(cache.lookup(id, values, 2, result));
+    EXPECT_EQ(*result, 12);
+
+    int64_t other[] = {3, 5};
+    EXPECT_FALSE(cache.lookup(id, other, 2, result));
+    EXPECT_FALSE(cache.lookup(id + 1, values, 2, result));
+    EXPECT_FALSE(cache.lookup(id, values, 1, result));
+
+    // Errors are results too.
+    cache.insert(id + 1, values, 2, Error{ErrorCode::DIVIDE_BY_ZERO});
+    ASSERT_TRUE(cache.lookup(id + 1, values, 2, result));
+    EXPECT_EQ(result.error().code, ErrorCode::DIVIDE_BY_ZERO);
+
+    ResultCache::Stats stats = cache.stats();
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 4u);
+    EXPECT_EQ(stats.entries, 2u);
+    EXPECT_DOUBLE_EQ(stats.hitRate(), 2.0 / 6.0);
+
+    cache.clear();
+    EXPECT_EQ(cache.stats().entries, 0u);
+    EXPECT_EQ(cache.stats().bytes, 0u);
+    EXPECT_FALSE(cache.lookup(id, values, 2, result));
+}
+
+TEST(ResultCacheTest, EvaluatesOnlyOnMiss) {
+    ResultCache cache;
+    uint64_t id = newExpressionIds();
+    int calls = 0;
+    auto compute = [&] {
+        ++calls;
+        return Result<int64_t>(int64_t(42));
+    };
+    int64_t x = 7;
+    EXPECT_EQ(*cache.evaluate(id, &x, 1, compute), 42);
+    EXPECT_EQ(*cache.evaluate(id, &x, 1, compute), 42);
+    EXPECT_EQ(calls, 1);
+    // No variables at all is a valid key.
+    EXPECT_EQ(*cache.evaluate(id, nullptr, 0, compute), 42);
+    EXPECT_EQ(*cache.evaluate(id, nullptr, 0, compute), 42);
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(ResultCacheTest, StaysWithinBudget) {
+    size_t budget = budgetFor(100);
+    ResultCache::Options options;
+    options.budgetBytes = budget;
+    options.shards = 4;
+    ResultCache cache(options);
+    uint64_t id = newExpressionIds();
+    for (int64_t v = 0; v < 1000; ++v) cache.insert(id, &v, 1, v);
+    ResultCache::Stats stats = cache.stats();
+    EXPECT_LE(stats.bytes, budget);
+    EXPECT_GT(stats.entries, 50u);
+    EXPECT_EQ(stats.insertions, 1000u);
+    EXPECT_EQ(stats.evictions, stats.insertions - stats.entries);
+
+    // Larger than a shard's budget: not stored.
+    std::vector<int64_t> wide(budget);
+    cache.insert(id, wide.data(), wide.size(), int64_t(1));
+    EXPECT_EQ(cache.stats().insertions, 1000u);
+}
+
+TEST(ResultCacheTest, LruEvictsTheLeastRecentlyUsed) {
+    ResultCache cache(oneShard(budgetFor(2), ResultCache::Eviction::LRU));
+    uint64_t id = newExpressionIds();
+    for (int64_t v : {1, 2}) cache.insert(id, &v, 1, v);
+    EXPECT_TRUE(cached(cache, id, 2));
+    EXPECT_TRUE(cached(cache, id, 1));
+    int64_t three = 3;
+    cache.insert(id, &three, 1, three);
+    EXPECT_TRUE(cached(cache, id, 1));
+    EXPECT_FALSE(cached(cache, id, 2));
+    EXPECT_TRUE(cached(cache, id, 3));
+}
+
+TEST(ResultCacheTest, ClockGivesReferencedEntriesASecondChance) {
+    ResultCache cache(oneShard(budgetFor(3), ResultCache::Eviction::CLOCK));
+    uint64_t id = newExpressionIds();
+    for (int64_t v : {1, 2, 3}) cache.insert(id, &v, 1, v);
+    EXPECT_TRUE(cached(cache, id, 1));
+    EXPECT_TRUE(cached(cache, id, 3));
+    // The sweep clears 1's bit and evicts 2, the first entry not
+    // referenced since the hand last passed.
+    int64_t four = 4;
+    cache.insert(id, &four, 1, four);
+    EXPECT_FALSE(cached(cache, id, 2));
+    EXPECT_TRUE(cached(cache, id, 1));
+    EXPECT_TRUE(cached(cache, id, 3));
+    EXPECT_TRUE(cached(cache, id, 4));
+    EXPECT_EQ(cache.stats().evictions, 1u);
+}
+
+TEST(ResultCacheTest, ConcurrentUseIsConsistent) {
+    ResultCache cache;
+    uint64_t id = newExpressionIds();
+    constexpr int kThreads = 4, kRounds = 2000, kKeys = 64;
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < kRounds; ++i) {
+                int64_t key = i % kKeys;
+                Result<int64_t> r = cache.evaluate(id, &key, 1, [&] { return Result<int64_t>(key * key); });
+                if (*r != key * key) ++wrong;
+            }
+        });
+    }
+    for (std::thread &t : threads) t.join();
+    EXPECT_EQ(wrong.load(), 0);
+    ResultCache::Stats stats = cache.stats();
+    EXPECT_EQ(stats.hits + stats.misses, uint64_t(kThreads * kRounds));
+    EXPECT_EQ(stats.entries, size_t(kKeys));
+}
+
+TEST(ResultCacheTest, CompiledExpressionsHaveDistinctIds) {
+    ParseCache parses(1);
+    auto first = parses.get("x + 1");
+    auto second = parses.get("x + 2");
+    auto again = parses.get("x + 1");  // evicted, so parsed afresh
+    EXPECT_NE(first->id, second->id);
+    EXPECT_NE(first->id, again->id);
+    uint64_t block = newExpressionIds(10);
+    EXPECT_EQ(newExpressionIds(), block + 10);
+}
+
+TEST(ResultCacheTest, BatchEvaluatorAnswersRepeatsFromTheCache) {
+    ResultCache results;
+    BatchEvaluator evaluator(16, nullptr, &results);
+    std::vector<std::string> lines = {"x * y; x=6; y=7", "x * y; x=2; y=2", "1 / x", "x*y; y=7; x=6"};
+    std::vector<std::string> responses;
+    for (int round = 0; round < 2; ++round) {
+        for (const std::string &line : lines) evaluator.add(line);
+        evaluator.evaluate();
+        std::string out;
+        for (const Result<int64_t> &r : evaluator.results()) formatResponse(r, out);
+        responses.push_back(out);
+    }
+    EXPECT_EQ(responses[0], "42\n4\nerror: Divide by zero\n42\n");
+    EXPECT_EQ(responses[1], responses[0]);
+    ResultCache::Stats stats = results.stats();
+    EXPECT_EQ(stats.entries, 3u);
+    EXPECT_EQ(stats.misses, 4u);
+    EXPECT_EQ(stats.hits, 4u);
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <iterator>
+#include <stdexcept>
+#include "parser.h"
+#include "static_expression.h"
+
+// Everything below the static_asserts is evaluated by the compiler.
+static_assert(evaluateStatic("(3 + 4) * (2 - 1) / 5 + sqrt(16)") == 5, "constant formula");
+static_assert(evaluateStatic("sqrt(9223372036854775807) + abs(3 - 10)") == 3037000506, "functions");
+static_assert(evaluateStatic("1.5e3 + 2.50e1 + 7. + 0.0 + 120e-1*5") == 1592, "literals");
+static_assert(evaluateStatic("1-2+3") == 2, "left associative");
+static_assert(evaluateStatic("2+3*4") == 14, "precedence");
+
+constexpr auto kTemplate = (num<3> + var<0>) * num<2> - var<1> / num<4>;
+constexpr int64_t kValues[] = {5, 20};
+static_assert(kTemplate(kValues) == 11, "expression template");
+static_assert(std::is_empty<decltype(kTemplate)>::value, "formula lives in the type");
+
+constexpr StaticProgram<> kProgram("x * 3 + y / 2");
+static_assert(kProgram.slot("x") == 0 && kProgram.slot("y") == 1, "slots by first use");
+static_assert(kProgram.evaluate(kValues) == 25, "compiled at build time");
+
+namespace {
+int64_t runtimeValue(const char *text, const int64_t *values, size_t count) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena(text);
+    if (!parsed) throw std::invalid_argument(text);
+    EXPECT_EQ(table.size(), count);
+    for (size_t i = 0; i < count; ++i) table.set(i, values[i]);
+    return parsed->getValue();
+}
+}
+
+TEST(StaticExpressionTest, AgreesWithRuntimeParser) {
+    constexpr StaticProgram<> formulas[] = {
+        StaticProgram<>("x * 3 + y / 2"),
+        StaticProgram<>("(a + b) * (a - b) / 7"),
+        StaticProgram<>("1 + 2 * (3 + 4) - 5 / 5"),
+        StaticProgram<>("((p))*q-p/q+100000*200000"),
+        StaticProgram<>("x1 - x2 - x3 * x1 + 9"),
+        StaticProgram<>("sqrt(x * x + y) - abs(x - 50) * 2e1"),
+        StaticProgram<>("cos(x) * 100 + sin(y * 1000) - abs(sin(x))"),
+    };
+    const char *texts[] = {
+        "x * 3 + y / 2", "(a + b) * (a - b) / 7", "1 + 2 * (3 + 4) - 5 / 5",
+        "((p))*q-p/q+100000*200000", "x1 - x2 - x3 * x1 + 9",
+        "sqrt(x * x + y) - abs(x - 50) * 2e1", "cos(x) * 100 + sin(y * 1000) - abs(sin(x))",
+    };
+    for (size_t f = 0; f < std::size(texts); ++f) {
+        for (int64_t seed = 1; seed < 20; ++seed) {
+            int64_t values[3] = {seed * 7 - 40, seed + 1, 13 - seed};
+            EXPECT_EQ(formulas[f].evaluate(values),
+                      runtimeValue(texts[f], values, formulas[f].variables()))
+                << texts[f];
+        }
+    }
+}
+
+TEST(StaticExpressionTest, TemplateAgreesWithRuntimeParser) {
+    constexpr auto f = (var<0> + var<1>) * (var<0> - var<1>) / num<7>;
+    for (int64_t a = -10; a <= 10; ++a) {
+        int64_t values[2] = {a, 3};
+        EXPECT_EQ(f(values), runtimeValue("(a + b) * (a - b) / 7", values, 2));
+    }
+}
+
+TEST(StaticExpressionTest, RuntimeDivideByZeroThrows) {
+    constexpr StaticProgram<> f("10 / d");
+    int64_t d = 0;
+    EXPECT_THROW(f.evaluate(&d), std::runtime_error);
+    constexpr auto g = num<10> / var<0>;
+    EXPECT_THROW(g(&d), std::runtime_error);
+    constexpr StaticProgram<> h("sqrt(d - 1)");
+    EXPECT_THROW(h.evaluate(&d), std::runtime_error);
+}
+
+TEST(StaticExpressionTest, InvalidTextThrowsWhenNotConstexpr) {
+    EXPECT_THROW(StaticProgram<>("2+*3"), std::invalid_argument);
+    EXPECT_THROW(StaticProgram<>("(1+2"), std::invalid_argument);
+    EXPECT_THROW(StaticProgram<>("9223372036854775808"), std::out_of_range);
+    EXPECT_THROW(StaticProgram<>("1e19"), std::out_of_range);
+    EXPECT_THROW(StaticProgram<>("1.25"), std::invalid_argument);
+    EXPECT_THROW(StaticProgram<>("2 * max(1)"), std::invalid_argument);
+    EXPECT_THROW(StaticProgram<>("2e"), std::invalid_argument);
+    EXPECT_THROW((StaticProgram<4>("1+2+3")), std::length_error);
+}
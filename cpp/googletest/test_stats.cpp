@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "parser.h"
+#include "stats.h"
+
+TEST(StatsHistogramTest, Buckets) {
+    EXPECT_EQ(stats::Histogram::bucketOf(0), 0);
+    EXPECT_EQ(stats::Histogram::bucketOf(1), 1);
+    EXPECT_EQ(stats::Histogram::bucketOf(2), 2);
+    EXPECT_EQ(stats::Histogram::bucketOf(3), 2);
+    EXPECT_EQ(stats::Histogram::bucketOf(1024), 11);
+    EXPECT_EQ(stats::Histogram::bucketOf(UINT64_MAX), 64);
+}
+
+TEST(StatsHistogramTest, Summary) {
+    stats::Histogram h;
+    EXPECT_EQ(h.percentile(0.5), 0u);
+    for (uint64_t v = 1; v <= 100; ++v) h.record(v);
+    EXPECT_EQ(h.count(), 100u);
+    EXPECT_EQ(h.max(), 100u);
+    EXPECT_DOUBLE_EQ(h.mean(), 50.5);
+    // 50 falls in [32, 64), 99 in [64, 128) capped by the maximum.
+    EXPECT_EQ(h.percentile(0.5), 63u);
+    EXPECT_EQ(h.percentile(0.99), 100u);
+    h.reset();
+    EXPECT_EQ(h.count(), 0u);
+}
+
+TEST(StatsTest, TreeDepth) {
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("1+2*(3-4)");
+    EXPECT_EQ(stats::treeDepth(parsed.get()), 4u);
+    EXPECT_EQ(stats::treeDepth(nullptr), 0u);
+}
+
+TEST(StatsTest, ParseAndEvaluateAreRecorded) {
+    if (!stats::kEnabled) GTEST_SKIP() << "built without STATS=1";
+    stats::reset();
+    Parser parser;
+    IExpression *expr = parser.parse("(1+2)*3");
+    ASSERT_NE(expr, nullptr);
+    EXPECT_EQ(expr->getValue(), 9);
+
+    EXPECT_EQ(stats::histogram(stats::Metric::PARSE_NS).count(), 1u);
+    EXPECT_EQ(stats::histogram(stats::Metric::TOKENIZE_NS).count(), 1u);
+    EXPECT_EQ(stats::histogram(stats::Metric::TOKENS).max(), 7u);
+    EXPECT_EQ(stats::histogram(stats::Metric::NODES).max(), 5u);
+    EXPECT_EQ(stats::histogram(stats::Metric::ALLOCATIONS).max(), 5u);
+    EXPECT_EQ(stats::histogram(stats::Metric::DEPTH).max(), 3u);
+    EXPECT_EQ(stats::histogram(stats::Metric::EVALUATE_NS).count(), 1u);
+
+    std::ostringstream oss;
+    stats::dump(oss);
+    EXPECT_NE(oss.str().find("parse_ns"), std::string::npos);
+}
+
+TEST(StatsTest, DisabledBuildRecordsNothing) {
+    if (stats::kEnabled) GTEST_SKIP() << "built with STATS=1";
+    stats::reset();
+    Parser parser;
+    ParsedExpression parsed = parser.parseInArena("1+2");
+    EXPECT_EQ(parsed->getValue(), 3);
+    EXPECT_EQ(stats::histogram(stats::Metric::PARSE_NS).count(), 0u);
+    std::ostringstream oss;
+    stats::dump(oss);
+    EXPECT_NE(oss.str().find("STATS=1"), std::string::npos);
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "ast.h"
+#include "bytecode.h"
+#include "parser.h"
+
+TEST(VariableTableTest, DeclareAssignsDenseSlots) {
+    VariableTable table;
+    EXPECT_EQ(table.declare("x"), 0u);
+    EXPECT_EQ(table.declare("y"), 1u);
+    EXPECT_EQ(table.declare("x"), 0u);
+    EXPECT_EQ(table.size(), 2u);
+    EXPECT_EQ(table.find("z"), VariableTable::npos);
+    EXPECT_EQ(table.name(1), "y");
+}
+
+TEST(VariableTableTest, SetByNameAndSlot) {
+    VariableTable table;
+    size_t x = table.declare("x");
+    EXPECT_EQ(table.get(x), 0);
+    table.set(x, 7);
+    EXPECT_EQ(table.get(x), 7);
+    EXPECT_TRUE(table.set("x", 9));
+    EXPECT_EQ(table.get(x), 9);
+    EXPECT_FALSE(table.set("missing", 1));
+}
+
+TEST(VariableParserTest, IdentifiersRejectedWithoutTable) {
+    Parser parser;
+    EXPECT_EQ(parser.parse("x+1"), nullptr);
+}
+
+TEST(VariableParserTest, TreeReevaluatesAfterRebinding) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("x*3+y/2");
+    ASSERT_TRUE(parsed);
+    ASSERT_EQ(table.size(), 2u);
+
+    std::ostringstream oss;
+    parsed->print(oss);
+    EXPECT_EQ(oss.str(), "((x*3)+(y/2))");
+
+    table.set("x", 2);
+    table.set("y", 10);
+    EXPECT_EQ(parsed->getValue(), 11);
+    table.set("x", -1);
+    EXPECT_EQ(parsed->getValue(), 2);
+}
+
+TEST(VariableParserTest, ASTPrinterPrintsNames) {
+    VariableTable table;
+    Parser parser;
+    parser.setVariables(&table);
+    ParsedExpression parsed = parser.parseInArena("rate*(qty-1)");
+    ASSERT_TRUE(parsed);
+    std::ostringstream oss;
+    ASTPrinter printer(oss);
+    printer.print(parsed.get());
+    EXPECT_EQ(oss.str(), "(* rate (- qty 1))\n");
+}
+
+TEST(CompiledExpressionTest, EvaluatesAgainstManyBindings) {
+    CompiledExpression expr("x*3+y/2");
+    ASSERT_TRUE(expr.ok());
+    size_t x = expr.slot("x");
+    size_t y = expr.slot("y");
+    ASSERT_NE(x, VariableTable::npos);
+    ASSERT_NE(y, VariableTable::npos);
+    EXPECT_EQ(expr.code().variableCount(), 2u);
+
+    int64_t values[2];
+    for (int64_t i = 0; i < 100; ++i) {
+        values[x] = i;
+        values[y] = 2 * i;
+        EXPECT_EQ(expr.evaluate(values), i * 3 + i);
+    }
+}
+
+TEST(CompiledExpressionTest, RepeatedVariableSharesSlot) {
+    CompiledExpression expr("a*a-a");
+    ASSERT_TRUE(expr.ok());
+    EXPECT_EQ(expr.variables().size(), 1u);
+    int64_t a = 5;
+    EXPECT_EQ(expr.evaluate(&a), 20);
+}
+
+TEST(CompiledExpressionTest, DivideByZeroFromBinding) {
+    CompiledExpression expr("10/d");
+    ASSERT_TRUE(expr.ok());
+    int64_t d = 0;
+    EXPECT_THROW(expr.evaluate(&d), std::runtime_error);
+    d = 5;
+    EXPECT_EQ(expr.evaluate(&d), 2);
+}
+
+TEST(CompiledExpressionTest, InvalidInput) {
+    CompiledExpression expr("x+*3");
+    EXPECT_FALSE(expr.ok());
+}
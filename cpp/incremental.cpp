@@ -0,0 +1,150 @@
+#include <stdexcept>
+
+#include "functions.h"
+#include "incremental.h"
+#include "stats.h"
+
+namespace {
+
+bool isOperator(FlatOp op) {
+    return op >= FlatOp::ADD && op <= FlatOp::DIV;
+}
+
+bool isFunction(FlatOp op) {
+    return op >= FlatOp::SQRT;
+}
+
+}  // namespace
+
+IncrementalEvaluator::IncrementalEvaluator(const IExpression *expr) : tree(expr) {
+    const std::vector<FlatNode> &nodes = tree.data();
+    const VariableTable *table = tree.variableTable();
+    if (table) bindings.assign(table->data(), table->data() + table->size());
+
+    // The flat tree copies shared subtrees, so every node has one parent.
+    parents.assign(nodes.size(), kNoParent);
+    readerStart.assign(bindings.size() + 1, 0);
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+        const FlatNode &node = nodes[i];
+        if (isOperator(node.op)) {
+            parents[node.left] = i;
+            parents[node.right] = i;
+        } else if (isFunction(node.op)) {
+            parents[node.left] = i;
+        } else if (node.op == FlatOp::VARIABLE) {
+            ++readerStart[node.immediate + 1];
+        }
+    }
+    for (size_t s = 1; s < readerStart.size(); ++s) readerStart[s] += readerStart[s - 1];
+    readers.resize(readerStart.back());
+    std::vector<uint32_t> fill(readerStart.begin(), readerStart.end() - 1);
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].op == FlatOp::VARIABLE) readers[fill[nodes[i].immediate]++] = i;
+    }
+
+    // Nothing is cached yet: the first value() computes every node.
+    cells.resize(nodes.size());
+    dirty.assign(nodes.size(), 1);
+}
+
+void IncrementalEvaluator::markDirty(uint32_t node) {
+    // Ancestors of a dirty node are already dirty, so stop at the first.
+    while (node != kNoParent && !dirty[node]) {
+        dirty[node] = 1;
+        node = parents[node];
+    }
+}
+
+void IncrementalEvaluator::set(size_t slot, int64_t value) {
+    if (slot >= bindings.size() || bindings[slot] == value) return;
+    bindings[slot] = value;
+    for (uint32_t i = readerStart[slot]; i < readerStart[slot + 1]; ++i) {
+        markDirty(readers[i]);
+    }
+}
+
+bool IncrementalEvaluator::set(std::string_view name, int64_t value) {
+    const VariableTable *table = tree.variableTable();
+    size_t slot = table ? table->find(name) : VariableTable::npos;
+    if (slot == VariableTable::npos || slot >= bindings.size()) return false;
+    set(slot, value);
+    return true;
+}
+
+IncrementalEvaluator::Cell IncrementalEvaluator::compute(const FlatNode &node) const {
+    switch (node.op) {
+    case FlatOp::NUMBER:
+        return {node.immediate};
+    case FlatOp::VARIABLE:
+        return {bindings[node.immediate]};
+    case FlatOp::ADD:
+    case FlatOp::SUB:
+    case FlatOp::MUL:
+    case FlatOp::DIV: {
+        const Cell &lhs = cells[node.left];
+        const Cell &rhs = cells[node.right];
+        if (lhs.error != ErrorCode::NONE) return lhs;
+        if (rhs.error != ErrorCode::NONE) return rhs;
+        if (node.op == FlatOp::DIV && rhs.value == 0) return {0, ErrorCode::DIVIDE_BY_ZERO};
+        if (node.op == FlatOp::DIV && rhs.value == -1 && lhs.value == INT64_MIN) {
+            return {0, ErrorCode::DIVIDE_OVERFLOW};
+        }
+        return {BinaryNode::apply(toOperator(node.op), lhs.value, rhs.value)};
+    }
+    default: {
+        const Cell &arg = cells[node.left];
+        if (arg.error != ErrorCode::NONE) return arg;
+        int64_t out;
+        if (functionInfo(toOperator(node.op)).batch(&arg.value, &out, 1) != 1) {
+            return {0, ErrorCode::DOMAIN_ERROR};
+        }
+        return {out};
+    }
+    }
+}
+
+// Dirty nodes form a connected region containing the root. Walk it from
+// the root with an explicit stack, computing a node once none of its
+// children is dirty; clean subtrees are never entered.
+void IncrementalEvaluator::recompute() {
+    recomputed = 0;
+    uint32_t root = tree.root();
+    if (!dirty[root]) return;
+    const std::vector<FlatNode> &nodes = tree.data();
+    pending.clear();
+    pending.push_back(root);
+    while (!pending.empty()) {
+        uint32_t index = pending.back();
+        const FlatNode &node = nodes[index];
+        bool waiting = false;
+        if (isOperator(node.op) && dirty[node.right]) {
+            pending.push_back(node.right);
+            waiting = true;
+        }
+        if ((isOperator(node.op) || isFunction(node.op)) && dirty[node.left]) {
+            pending.push_back(node.left);
+            waiting = true;
+        }
+        if (waiting) continue;
+        cells[index] = compute(node);
+        dirty[index] = 0;
+        ++recomputed;
+        pending.pop_back();
+    }
+}
+
+Result<int64_t> IncrementalEvaluator::tryValue() {
+    if (tree.empty()) return Error{ErrorCode::MALFORMED_PROGRAM};
+    EXPR_STATS_TIMER(timer, stats::Metric::EVALUATE_NS);
+    recompute();
+    const Cell &root = cells[tree.root()];
+    if (root.error != ErrorCode::NONE) return Error{root.error};
+    return root.value;
+}
+
+int64_t IncrementalEvaluator::value() {
+    if (tree.empty()) throw std::runtime_error("Empty expression");
+    Result<int64_t> result = tryValue();
+    if (!result) throw std::runtime_error(result.error().message());
+    return *result;
+}
@@ -0,0 +1,65 @@
+#ifndef INCREMENTAL_H_
+#define INCREMENTAL_H_
+
+#include<cstdint>
+#include<string_view>
+#include<vector>
+
+#include "expression.h"
+#include "flat_tree.h"
+#include "result.h"
+
+// Spreadsheet-style evaluation for a fixed expression whose variables
+// change a few at a time. Every node caches its last value; set() marks the
+// path from each leaf reading the variable up to the root as dirty, and
+// value() recomputes only the dirty nodes, so an update costs the depth of
+// the affected leaves instead of the size of the tree.
+//
+//   IncrementalEvaluator eval(tree);
+//   eval.set(slot, 42);
+//   int64_t v = eval.value();
+class IncrementalEvaluator {
+    struct Cell {
+        int64_t value = 0;
+        ErrorCode error = ErrorCode::NONE;
+    };
+    static constexpr uint32_t kNoParent = UINT32_MAX;
+
+    FlatTree tree;  // post-order: children come before their parent
+    std::vector<uint32_t> parents;
+    std::vector<Cell> cells;
+    std::vector<uint8_t> dirty;
+    std::vector<int64_t> bindings;
+    // Dependencies: the leaves reading slot s are
+    // readers[readerStart[s]] .. readers[readerStart[s + 1] - 1].
+    std::vector<uint32_t> readerStart;
+    std::vector<uint32_t> readers;
+    std::vector<uint32_t> pending;  // recompute stack, kept for its capacity
+    size_t recomputed = 0;
+
+    void markDirty(uint32_t node);
+    void recompute();
+    Cell compute(const FlatNode &node) const;
+public:
+    // Copies the shape of the tree and the current bindings of the table it
+    // was parsed with; the tree itself is not referenced afterwards.
+    explicit IncrementalEvaluator(const IExpression *expr);
+
+    // Rebinds a variable slot. Setting the value it already has, or a slot
+    // the expression does not read, invalidates nothing.
+    void set(size_t slot, int64_t value);
+    // Same, by name; false if the expression has no such variable.
+    bool set(std::string_view name, int64_t value);
+    int64_t get(size_t slot) const { return bindings[slot]; }
+
+    // Value for the current bindings; throws std::runtime_error on divide
+    // by zero or a function domain error, like BinaryNode::getValue().
+    int64_t value();
+    Result<int64_t> tryValue();
+
+    // Nodes recomputed by the last value() call.
+    size_t lastRecomputed() const { return recomputed; }
+    size_t size() const { return tree.size(); }
+};
+
+#endif  // INCREMENTAL_H_
@@ -0,0 +1,209 @@
+#include <stdexcept>
+#include <vector>
+
+#include "jit.h"
+
+#if defined(__x86_64__) && defined(__unix__)
+#define JIT_X86_64 1
+#include <cstring>
+#include <sys/mman.h>
+#endif
+
+#ifdef JIT_X86_64
+namespace {
+
+// Emits code for a postfix program keeping the top of the value stack in
+// rax and the rest on the machine stack. rdi holds the variables pointer,
+// rsi the error flag pointer, and rbp the entry stack pointer so every exit
+// can unwind whatever is still pushed.
+class Emitter {
+    static constexpr size_t kMaxStackDepth = 4096;  // 32 KiB of pushes
+
+    std::vector<uint8_t> out;
+    // Offsets of the rel32 fields of jumps to each error exit.
+    std::vector<size_t> zeroJumps;
+    std::vector<size_t> overflowJumps;
+
+    void bytes(std::initializer_list<uint8_t> b) { out.insert(out.end(), b); }
+    void imm32(int32_t v) {
+        uint8_t b[4];
+        std::memcpy(b, &v, 4);
+        out.insert(out.end(), b, b + 4);
+    }
+    void imm64(int64_t v) {
+        uint8_t b[8];
+        std::memcpy(b, &v, 8);
+        out.insert(out.end(), b, b + 8);
+    }
+    void epilogue() {
+        bytes({0x48, 0x89, 0xEC});  // mov rsp, rbp
+        bytes({0x5D});              // pop rbp
+        bytes({0xC3});              // ret
+    }
+    // Stores code to *error and returns 0; patches the jumps to it.
+    void errorExit(int32_t code, const std::vector<size_t> &jumps) {
+        size_t target = out.size();
+        bytes({0xC7, 0x06});        // mov dword [rsi], code
+        imm32(code);
+        bytes({0x31, 0xC0});        // xor eax, eax
+        epilogue();
+        for (size_t at : jumps) {
+            int32_t rel = static_cast<int32_t>(target - (at + 4));
+            std::memcpy(&out[at], &rel, 4);
+        }
+    }
+
+public:
+    // Returns false for programs this backend does not handle.
+    bool compile(const Program &program) {
+        // Operands live on the caller's machine stack; leave deeper
+        // programs to the interpreter, whose stack is on the heap.
+        if (program.stackDepth() > kMaxStackDepth) return false;
+        bytes({0x55});              // push rbp
+        bytes({0x48, 0x89, 0xE5});  // mov rbp, rsp
+        size_t depth = 0;
+        for (const Instruction &ins : program.instructions()) {
+            switch (ins.op) {
+            case OpCode::PUSH:
+                if (depth++) bytes({0x50});  // push rax
+                if (ins.operand >= INT32_MIN && ins.operand <= INT32_MAX) {
+                    bytes({0x48, 0xC7, 0xC0});  // mov rax, imm32 (sign-extended)
+                    imm32(static_cast<int32_t>(ins.operand));
+                } else {
+                    bytes({0x48, 0xB8});        // movabs rax, imm64
+                    imm64(ins.operand);
+                }
+                break;
+            case OpCode::LOAD:
+                if (ins.operand > INT32_MAX / 8) return false;
+                if (depth++) bytes({0x50});     // push rax
+                bytes({0x48, 0x8B, 0x87});      // mov rax, [rdi + disp32]
+                imm32(static_cast<int32_t>(ins.operand * 8));
+                break;
+            case OpCode::ADD:
+                bytes({0x59});                  // pop rcx
+                bytes({0x48, 0x01, 0xC8});      // add rax, rcx
+                --depth;
+                break;
+            case OpCode::SUB:
+                bytes({0x59});                  // pop rcx
+                bytes({0x48, 0x29, 0xC1});      // sub rcx, rax
+                bytes({0x48, 0x89, 0xC8});      // mov rax, rcx
+                --depth;
+                break;
+            case OpCode::MUL:
+                bytes({0x59});                  // pop rcx
+                bytes({0x48, 0x0F, 0xAF, 0xC1});  // imul rax, rcx
+                --depth;
+                break;
+            case OpCode::DIV: {
+                bytes({0x48, 0x85, 0xC0});      // test rax, rax
+                bytes({0x0F, 0x84});            // jz divide-by-zero exit
+                zeroJumps.push_back(out.size());
+                imm32(0);
+                // idiv traps on INT64_MIN / -1, so check for it first.
+                bytes({0x48, 0x83, 0xF8, 0xFF});  // cmp rax, -1
+                bytes({0x75, 0x00});            // jne divide
+                size_t skip = out.size();
+                bytes({0x48, 0x8B, 0x0C, 0x24});  // mov rcx, [rsp]
+                bytes({0x48, 0xBA});            // movabs rdx, INT64_MIN
+                imm64(INT64_MIN);
+                bytes({0x48, 0x39, 0xD1});      // cmp rcx, rdx
+                bytes({0x0F, 0x84});            // je overflow exit
+                overflowJumps.push_back(out.size());
+                imm32(0);
+                out[skip - 1] = static_cast<uint8_t>(out.size() - skip);
+                bytes({0x48, 0x89, 0xC1});      // divide: mov rcx, rax
+                bytes({0x58});                  // pop rax
+                bytes({0x48, 0x99});            // cqo
+                bytes({0x48, 0xF7, 0xF9});      // idiv rcx
+                --depth;
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        if (depth != 1) return false;
+        epilogue();
+        errorExit(JitFunction::kDivideByZero, zeroJumps);
+        errorExit(JitFunction::kDivideOverflow, overflowJumps);
+        return true;
+    }
+
+    const std::vector<uint8_t> &code() const { return out; }
+};
+
+}  // namespace
+#endif  // JIT_X86_64
+
+bool JitFunction::supported() {
+#ifdef JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+JitFunction::JitFunction(const IExpression *expr) {
+    BytecodeCompiler compiler;
+    program = compiler.compile(expr);
+#ifdef JIT_X86_64
+    Emitter emitter;
+    if (program.empty() || !emitter.compile(program)) return;
+    const auto &bytes = emitter.code();
+
+    // Write while the pages are writable, then flip them to executable so
+    // they are never both.
+    void *mem = ::mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return;
+    std::memcpy(mem, bytes.data(), bytes.size());
+    if (::mprotect(mem, bytes.size(), PROT_READ | PROT_EXEC) != 0) {
+        ::munmap(mem, bytes.size());
+        return;
+    }
+    code = mem;
+    size = bytes.size();
+    fn = reinterpret_cast<NativeFn>(mem);
+#endif
+}
+
+JitFunction::~JitFunction() {
+    release();
+}
+
+JitFunction::JitFunction(JitFunction &&other) noexcept
+    : program(std::move(other.program)), code(other.code), size(other.size), fn(other.fn) {
+    other.code = nullptr;
+    other.size = 0;
+    other.fn = nullptr;
+}
+
+JitFunction &JitFunction::operator=(JitFunction &&other) noexcept {
+    if (this != &other) {
+        release();
+        program = std::move(other.program);
+        code = other.code;
+        size = other.size;
+        fn = other.fn;
+        other.code = nullptr;
+        other.size = 0;
+        other.fn = nullptr;
+    }
+    return *this;
+}
+
+void JitFunction::release() {
+#ifdef JIT_X86_64
+    if (code) ::munmap(code, size);
+#endif
+    code = nullptr;
+    size = 0;
+    fn = nullptr;
+}
+
+void JitFunction::throwError(int error) {
+    if (error == kDivideOverflow) throw std::overflow_error("Division overflow");
+    throw std::runtime_error("Divide by zero");
+}
@@ -0,0 +1,56 @@
+#ifndef JIT_H_
+#define JIT_H_
+
+#include<cstdint>
+
+#include "bytecode.h"
+
+// Expression compiled to native x86-64 machine code in an executable
+// mmap'd region. Where code generation is not possible (other
+// architectures, or the mapping is refused) the same interface runs the
+// bytecode Program instead, so callers never need to check.
+class JitFunction {
+public:
+    // Signature of the generated code. Variable slot i reads variables[i];
+    // on an error it stores kDivideByZero or kDivideOverflow (INT64_MIN / -1)
+    // to *error and returns 0.
+    using NativeFn = int64_t (*)(const int64_t *variables, int *error);
+    static constexpr int kDivideByZero = 1;
+    static constexpr int kDivideOverflow = 2;
+
+    // True when this build can generate native code at all.
+    static bool supported();
+
+    explicit JitFunction(const IExpression *expr);
+    ~JitFunction();
+    JitFunction(const JitFunction &) = delete;
+    JitFunction &operator=(const JitFunction &) = delete;
+    JitFunction(JitFunction &&other) noexcept;
+    JitFunction &operator=(JitFunction &&other) noexcept;
+
+    // Throws std::runtime_error on divide by zero or INT64_MIN / -1, like
+    // BinaryNode::getValue().
+    int64_t operator()(const int64_t *variables = nullptr) const {
+        if (!fn) return program.execute(variables);
+        int error = 0;
+        int64_t value = fn(variables, &error);
+        if (error) throwError(error);
+        return value;
+    }
+
+    bool isNative() const { return fn != nullptr; }
+    // The generated code as a plain function pointer; nullptr on fallback.
+    NativeFn native() const { return fn; }
+    size_t codeSize() const { return size; }
+
+private:
+    Program program;
+    void *code = nullptr;
+    size_t size = 0;
+    NativeFn fn = nullptr;
+
+    void release();
+    [[noreturn]] static void throwError(int error);
+};
+
+#endif  // JIT_H_
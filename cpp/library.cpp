@@ -0,0 +1,242 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "library.h"
+
+Result<size_t> LibraryBuilder::add(std::string_view text) {
+    arena.reset();
+    Result<IExpression *> expr = parser.tryParse(text, arena);
+    if (!expr) return expr.error();
+    FlatTree flat(*expr);
+    LibraryFormula formula;
+    formula.firstNode = nodes.size();
+    formula.nodeCount = static_cast<uint32_t>(flat.size());
+    formula.stackDepth = static_cast<uint32_t>(flat.stackDepth());
+    for (const FlatNode &source : flat.data()) {
+        // Zero the padding so the same input always gives the same file.
+        FlatNode node;
+        std::memset(&node, 0, sizeof(node));
+        node.op = source.op;
+        node.left = source.left;
+        std::memcpy(&node.immediate, &source.immediate, sizeof(node.immediate));
+        nodes.push_back(node);
+    }
+    formulas.push_back(formula);
+    return formulas.size() - 1;
+}
+
+std::string LibraryBuilder::serialize() const {
+    std::vector<LibraryName> nameTable;
+    std::string nameBytes;
+    for (size_t slot = 0; slot < variables.size(); ++slot) {
+        const std::string &name = variables.name(slot);
+        nameTable.push_back({static_cast<uint32_t>(nameBytes.size()), static_cast<uint32_t>(name.size())});
+        nameBytes += name;
+    }
+
+    LibraryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kLibraryMagic, sizeof(header.magic));
+    header.version = kLibraryVersion;
+    header.byteOrder = kLibraryByteOrder;
+    header.formulaCount = formulas.size();
+    header.nodeCount = nodes.size();
+    header.variableCount = nameTable.size();
+    header.nameBytes = nameBytes.size();
+
+    std::string out;
+    out.reserve(sizeof(header) + formulas.size() * sizeof(LibraryFormula) +
+                nodes.size() * sizeof(FlatNode) + nameTable.size() * sizeof(LibraryName) +
+                nameBytes.size());
+    out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.append(reinterpret_cast<const char *>(formulas.data()), formulas.size() * sizeof(LibraryFormula));
+    out.append(reinterpret_cast<const char *>(nodes.data()), nodes.size() * sizeof(FlatNode));
+    out.append(reinterpret_cast<const char *>(nameTable.data()), nameTable.size() * sizeof(LibraryName));
+    out += nameBytes;
+    return out;
+}
+
+bool LibraryBuilder::save(const std::string &path) const {
+    std::string bytes = serialize();
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(out);
+}
+
+ExpressionLibrary::~ExpressionLibrary() {
+    release();
+}
+
+ExpressionLibrary::ExpressionLibrary(ExpressionLibrary &&other) noexcept {
+    *this = std::move(other);
+}
+
+ExpressionLibrary &ExpressionLibrary::operator=(ExpressionLibrary &&other) noexcept {
+    if (this != &other) {
+        release();
+        mapping = other.mapping;
+        mappedSize = other.mappedSize;
+        header = other.header;
+        formulas = other.formulas;
+        nodes = other.nodes;
+        names = other.names;
+        nameBytes = other.nameBytes;
+        firstId = other.firstId;
+        other.mapping = nullptr;
+        other.mappedSize = 0;
+        other.header = nullptr;
+    }
+    return *this;
+}
+
+void ExpressionLibrary::release() {
+    if (mapping) ::munmap(mapping, mappedSize);
+    mapping = nullptr;
+    mappedSize = 0;
+    header = nullptr;
+}
+
+ExpressionLibrary::Status ExpressionLibrary::open(const std::string &path, bool verify) {
+    release();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return Status::CANNOT_OPEN;
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return Status::CANNOT_OPEN;
+    }
+    if (st.st_size < static_cast<off_t>(sizeof(LibraryHeader))) {
+        ::close(fd);
+        return Status::NOT_A_LIBRARY;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void *map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return Status::CANNOT_OPEN;
+    Status status = load(map, size, verify);
+    if (status != Status::OK) {
+        ::munmap(map, size);
+        return status;
+    }
+    mapping = map;
+    mappedSize = size;
+    return Status::OK;
+}
+
+ExpressionLibrary::Status ExpressionLibrary::load(const void *data, size_t size, bool verify) {
+    release();
+    const char *bytes = static_cast<const char *>(data);
+    if (size < sizeof(LibraryHeader)) return Status::NOT_A_LIBRARY;
+    const LibraryHeader *h = reinterpret_cast<const LibraryHeader *>(bytes);
+    if (std::memcmp(h->magic, kLibraryMagic, sizeof(kLibraryMagic)) != 0) return Status::NOT_A_LIBRARY;
+    if (h->version != kLibraryVersion || h->byteOrder != kLibraryByteOrder) {
+        return Status::UNSUPPORTED_VERSION;
+    }
+    if (reinterpret_cast<uintptr_t>(data) % alignof(LibraryFormula) != 0) return Status::CORRUPT;
+
+    // Each count is bounded by the size first, so the sum cannot overflow.
+    size_t rest = size - sizeof(LibraryHeader);
+    if (h->formulaCount > rest / sizeof(LibraryFormula) ||
+        h->nodeCount > rest / sizeof(FlatNode) ||
+        h->variableCount > rest / sizeof(LibraryName) ||
+        h->nameBytes > rest) {
+        return Status::CORRUPT;
+    }
+    size_t formulaBytes = h->formulaCount * sizeof(LibraryFormula);
+    size_t nodeBytes = h->nodeCount * sizeof(FlatNode);
+    size_t nameTableBytes = h->variableCount * sizeof(LibraryName);
+    if (formulaBytes + nodeBytes + nameTableBytes + h->nameBytes != rest) return Status::CORRUPT;
+
+    const char *at = bytes + sizeof(LibraryHeader);
+    formulas = reinterpret_cast<const LibraryFormula *>(at);
+    nodes = reinterpret_cast<const FlatNode *>(at + formulaBytes);
+    names = reinterpret_cast<const LibraryName *>(at + formulaBytes + nodeBytes);
+    nameBytes = at + formulaBytes + nodeBytes + nameTableBytes;
+    header = h;
+    if (verify && !verifyFormulas()) {
+        header = nullptr;
+        return Status::CORRUPT;
+    }
+    firstId = newExpressionIds(h->formulaCount);
+    return Status::OK;
+}
+
+// Replays each formula's value stack, so that evaluating a verified
+// library never reads outside its nodes, its stack or the variables.
+bool ExpressionLibrary::verifyFormulas() const {
+    for (size_t v = 0; v < header->variableCount; ++v) {
+        if (names[v].offset > header->nameBytes ||
+            names[v].length > header->nameBytes - names[v].offset) {
+            return false;
+        }
+    }
+    for (size_t f = 0; f < header->formulaCount; ++f) {
+        const LibraryFormula &formula = formulas[f];
+        if (formula.nodeCount == 0 || formula.firstNode > header->nodeCount ||
+            formula.nodeCount > header->nodeCount - formula.firstNode) {
+            return false;
+        }
+        const FlatNode *node = nodes + formula.firstNode;
+        size_t depth = 0, deepest = 0;
+        for (uint32_t i = 0; i < formula.nodeCount; ++i, ++node) {
+            switch (node->op) {
+            case FlatOp::VARIABLE:
+                if (node->immediate < 0 || uint64_t(node->immediate) >= header->variableCount) return false;
+                // fall through
+            case FlatOp::NUMBER:
+                if (++depth > deepest) deepest = depth;
+                break;
+            case FlatOp::ADD:
+            case FlatOp::SUB:
+            case FlatOp::MUL:
+            case FlatOp::DIV:
+                if (depth < 2) return false;
+                --depth;
+                break;
+            case FlatOp::SQRT:
+            case FlatOp::ABS:
+            case FlatOp::SIN:
+            case FlatOp::COS:
+                if (depth < 1) return false;
+                break;
+            default:
+                return false;
+            }
+        }
+        if (depth != 1 || deepest > formula.stackDepth) return false;
+    }
+    return true;
+}
+
+std::string_view ExpressionLibrary::variableName(size_t slot) const {
+    return std::string_view(nameBytes + names[slot].offset, names[slot].length);
+}
+
+size_t ExpressionLibrary::findVariable(std::string_view name) const {
+    for (size_t slot = 0; slot < variableCount(); ++slot) {
+        if (variableName(slot) == name) return slot;
+    }
+    return VariableTable::npos;
+}
+
+const LibraryFormula &ExpressionLibrary::at(size_t formula) const {
+    if (formula >= size()) throw std::out_of_range("No such formula");
+    return formulas[formula];
+}
+
+int64_t ExpressionLibrary::evaluate(size_t formula, const int64_t *vars) const {
+    const LibraryFormula &f = at(formula);
+    return evaluateFlat(nodes + f.firstNode, f.nodeCount, vars, f.stackDepth);
+}
+
+Result<int64_t> ExpressionLibrary::tryEvaluate(size_t formula, const int64_t *vars) const {
+    if (formula >= size()) return Error{ErrorCode::UNKNOWN_FORMULA};
+    const LibraryFormula &f = formulas[formula];
+    return tryEvaluateFlat(nodes + f.firstNode, f.nodeCount, vars, f.stackDepth);
+}
@@ -0,0 +1,136 @@
+#ifndef LIBRARY_H_
+#define LIBRARY_H_
+
+#include<cstdint>
+#include<string>
+#include<string_view>
+#include<vector>
+
+#include "expression_id.h"
+#include "flat_tree.h"
+#include "parser.h"
+#include "result.h"
+#include "variables.h"
+
+// Precompiled expression library: formulas flattened to FlatNodes and
+// stored in one file that is mapped, checked and evaluated in place, with
+// no parsing and no per-node allocation at load time.
+//
+// File layout, host byte order, every section 8-byte aligned:
+//   LibraryHeader
+//   LibraryFormula[formulaCount]   where each formula's nodes start
+//   FlatNode[nodeCount]            post-order, child indices per formula
+//   LibraryName[variableCount]     slot -> name, into the bytes below
+//   char[nameBytes]
+// All formulas share one variable numbering; evaluate() reads slot i from
+// vars[i].
+
+constexpr char kLibraryMagic[8] = {'E', 'X', 'P', 'R', 'L', 'I', 'B', '\0'};
+// Bumped whenever the layout or the meaning of a FlatOp changes.
+constexpr uint32_t kLibraryVersion = 1;
+// Written as is; reads back differently on a host of the other byte order.
+constexpr uint32_t kLibraryByteOrder = 0x01020304;
+
+struct LibraryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t formulaCount;
+    uint64_t nodeCount;
+    uint64_t variableCount;
+    uint64_t nameBytes;
+    uint64_t reserved[2];
+};
+
+struct LibraryFormula {
+    uint64_t firstNode;
+    uint32_t nodeCount;
+    uint32_t stackDepth;  // deepest value stack during evaluation
+};
+
+struct LibraryName {
+    uint32_t offset;
+    uint32_t length;
+};
+
+static_assert(sizeof(LibraryHeader) == 64, "library header layout");
+static_assert(sizeof(LibraryFormula) == 16, "library index layout");
+static_assert(sizeof(FlatNode) == 16, "library node layout");
+
+// Compiles formulas text into the library format.
+class LibraryBuilder {
+    VariableTable variables;
+    Parser parser;
+    Arena arena;
+    std::vector<LibraryFormula> formulas;
+    std::vector<FlatNode> nodes;
+public:
+    LibraryBuilder() { parser.setVariables(&variables); }
+    LibraryBuilder(const LibraryBuilder &) = delete;
+    LibraryBuilder &operator=(const LibraryBuilder &) = delete;
+
+    // Parses one formula and appends it; returns its index in the library.
+    Result<size_t> add(std::string_view text);
+    size_t size() const { return formulas.size(); }
+
+    // The library file contents.
+    std::string serialize() const;
+    // Writes serialize() to path; false if the file could not be written.
+    bool save(const std::string &path) const;
+};
+
+// Read-only view of a library, either mapped from a file it owns or over
+// a caller's buffer. Move-only.
+class ExpressionLibrary {
+public:
+    enum class Status { OK, CANNOT_OPEN, NOT_A_LIBRARY, UNSUPPORTED_VERSION, CORRUPT };
+
+    ExpressionLibrary() = default;
+    ~ExpressionLibrary();
+    ExpressionLibrary(ExpressionLibrary &&other) noexcept;
+    ExpressionLibrary &operator=(ExpressionLibrary &&other) noexcept;
+    ExpressionLibrary(const ExpressionLibrary &) = delete;
+    ExpressionLibrary &operator=(const ExpressionLibrary &) = delete;
+
+    // Maps the file read-only. With verify, every formula is checked to be
+    // well formed, which reads every node once; without it only the header
+    // and section sizes are, so the file must come from LibraryBuilder.
+    Status open(const std::string &path, bool verify = true);
+    // Same over memory that must stay valid and 8-byte aligned while the
+    // library is in use.
+    Status load(const void *data, size_t size, bool verify = true);
+
+    size_t size() const { return header ? header->formulaCount : 0; }
+    size_t variableCount() const { return header ? header->variableCount : 0; }
+    std::string_view variableName(size_t slot) const;
+    // Slot of the variable, or VariableTable::npos.
+    size_t findVariable(std::string_view name) const;
+    // Throws std::out_of_range unless formula < size().
+    size_t nodeCount(size_t formula) const { return at(formula).nodeCount; }
+    // ResultCache key of a formula; fresh for every load.
+    uint64_t formulaId(size_t formula) const { return firstId + formula; }
+
+    // Evaluates formula i reading slot s from vars[s]; throws
+    // std::runtime_error on divide by zero like FlatTree::evaluate(), and
+    // std::out_of_range when there is no formula i.
+    int64_t evaluate(size_t formula, const int64_t *vars = nullptr) const;
+    // Same, with evaluation errors returned as for tryEvaluateFlat() and a
+    // missing formula as UNKNOWN_FORMULA.
+    Result<int64_t> tryEvaluate(size_t formula, const int64_t *vars = nullptr) const;
+
+private:
+    void *mapping = nullptr;
+    size_t mappedSize = 0;
+    const LibraryHeader *header = nullptr;
+    const LibraryFormula *formulas = nullptr;
+    const FlatNode *nodes = nullptr;
+    const LibraryName *names = nullptr;
+    const char *nameBytes = nullptr;
+    uint64_t firstId = 0;
+
+    const LibraryFormula &at(size_t formula) const;
+    bool verifyFormulas() const;
+    void release();
+};
+
+#endif  // LIBRARY_H_
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "load_generator.h"
+
+namespace {
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+std::vector<std::string> defaultRequests() {
+    std::vector<std::string> requests;
+    for (int i = 0; i < 64; ++i) {
+        std::string n = std::to_string(i);
+        requests.push_back("price * qty - discount; price=" + n + "; qty=" +
+                           std::to_string(i % 9 + 1) + "; discount=" + std::to_string(i / 2));
+        requests.push_back("(a + b) / (c + 1); a=" + n + "; b=7; c=" + std::to_string(i % 5));
+        requests.push_back("sqrt(abs(x)) * 3 + 1; x=-" + n);
+    }
+    return requests;
+}
+
+struct Client {
+    int fd = -1;
+    std::string out;
+    size_t sent = 0;
+    std::string in;
+    std::deque<uint64_t> started;  // write times of the requests in flight
+    size_t issued = 0;
+    size_t quota = 0;
+    uint32_t events = EPOLLIN;
+
+    Client() = default;
+    Client(const Client &) = delete;
+    Client &operator=(const Client &) = delete;
+    ~Client() {
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+struct EpollFd {
+    int fd = ::epoll_create1(EPOLL_CLOEXEC);
+    ~EpollFd() {
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+int connectTo(const std::string &path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        ::fcntl(fd, F_SETFL, O_NONBLOCK) < 0) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+// Writes what the socket takes; false if the server is gone.
+bool send(Client &client) {
+    while (client.sent < client.out.size()) {
+        ssize_t n = ::send(client.fd, client.out.data() + client.sent,
+                           client.out.size() - client.sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            client.sent += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+    client.out.clear();
+    client.sent = 0;
+    return true;
+}
+
+}  // namespace
+
+void LoadReport::print(std::ostream &os) const {
+    os << "responses: " << responses << ", errors: " << errors
+       << ", time: " << seconds << " s, throughput: " << throughput() << " req/s"
+       << ", p50: " << p50Ns / 1000.0 << " us, p99: " << p99Ns / 1000.0
+       << " us, max: " << maxNs / 1000.0 << " us\n";
+}
+
+bool runLoad(const LoadOptions &options, LoadReport &report) {
+    report = LoadReport();
+    const std::vector<std::string> requests =
+        options.requests.empty() ? defaultRequests() : options.requests;
+    size_t connections = std::max<size_t>(options.connections, 1);
+    size_t depth = std::max<size_t>(options.depth, 1);
+
+    EpollFd epoll;
+    int epollFd = epoll.fd;
+    if (epollFd < 0) return false;
+
+    std::vector<Client> clients(connections);
+    for (size_t c = 0; c < connections; ++c) {
+        Client &client = clients[c];
+        client.quota = options.total / connections + (c < options.total % connections ? 1 : 0);
+        client.fd = connectTo(options.socketPath);
+        if (client.fd < 0) return false;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = c;
+        if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, client.fd, &event) < 0) return false;
+    }
+
+    std::vector<uint64_t> latencies;
+    latencies.reserve(options.total);
+    size_t next = 0;
+    uint64_t startNs = nowNs();
+
+    // Tops the client up to `depth` requests in flight and writes them.
+    auto issue = [&](size_t c) {
+        Client &client = clients[c];
+        uint64_t now = nowNs();
+        while (client.started.size() < depth && client.issued < client.quota) {
+            client.out += requests[next];
+            client.out += '\n';
+            next = next + 1 == requests.size() ? 0 : next + 1;
+            client.started.push_back(now);
+            ++client.issued;
+        }
+        if (!send(client)) return false;
+        uint32_t wanted = client.out.empty() ? EPOLLIN : EPOLLIN | EPOLLOUT;
+        if (wanted != client.events) {
+            epoll_event event{};
+            event.events = wanted;
+            event.data.u64 = c;
+            ::epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &event);
+            client.events = wanted;
+        }
+        return true;
+    };
+    for (size_t c = 0; c < connections; ++c) {
+        if (!issue(c)) return false;
+    }
+
+    constexpr int kMaxEvents = 64;
+    epoll_event events[kMaxEvents];
+    char buffer[1 << 16];
+    while (report.responses < options.total) {
+        int n = ::epoll_wait(epollFd, events, kMaxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        for (int i = 0; i < n; ++i) {
+            size_t c = events[i].data.u64;
+            Client &client = clients[c];
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                while (true) {
+                    ssize_t got = ::read(client.fd, buffer, sizeof(buffer));
+                    if (got > 0) {
+                        client.in.append(buffer, got);
+                        continue;
+                    }
+                    if (got < 0 && errno == EINTR) continue;
+                    if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                    if (got == 0) errno = ECONNRESET;
+                    return false;
+                }
+                uint64_t now = nowNs();
+                size_t pos = 0;
+                for (size_t nl; (nl = client.in.find('\n', pos)) != std::string::npos; pos = nl + 1) {
+                    if (client.started.empty()) {
+                        errno = EPROTO;
+                        return false;
+                    }
+                    latencies.push_back(now - client.started.front());
+                    client.started.pop_front();
+                    if (client.in.compare(pos, 7, "error: ") == 0) ++report.errors;
+                    ++report.responses;
+                }
+                client.in.erase(0, pos);
+            }
+            if (!issue(c)) return false;
+        }
+    }
+    report.seconds = (nowNs() - startNs) / 1e9;
+
+    if (!latencies.empty()) {
+        auto at = [&](double q) {
+            auto nth = latencies.begin() + static_cast<size_t>(q * double(latencies.size() - 1));
+            std::nth_element(latencies.begin(), nth, latencies.end());
+            return *nth;
+        };
+        report.p50Ns = at(0.5);
+        report.p99Ns = at(0.99);
+        report.maxNs = *std::max_element(latencies.begin(), latencies.end());
+    }
+    return true;
+}
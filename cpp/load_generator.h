@@ -0,0 +1,38 @@
+#ifndef LOAD_GENERATOR_H_
+#define LOAD_GENERATOR_H_
+
+#include<cstdint>
+#include<iostream>
+#include<string>
+#include<vector>
+
+// Client side of the evaluation server for local load testing: opens
+// several connections and keeps a fixed number of requests in flight on
+// each, measuring every request from its write to its response.
+struct LoadOptions {
+    std::string socketPath;
+    // Request lines without newlines, sent round-robin; a built-in mix of
+    // expressions with bindings when empty.
+    std::vector<std::string> requests;
+    size_t connections = 4;
+    size_t depth = 32;          // requests in flight per connection
+    size_t total = 100000;      // across all connections
+};
+
+struct LoadReport {
+    size_t responses = 0;
+    size_t errors = 0;          // "error: ..." responses
+    double seconds = 0;
+    uint64_t p50Ns = 0;
+    uint64_t p99Ns = 0;
+    uint64_t maxNs = 0;
+
+    double throughput() const { return seconds > 0 ? responses / seconds : 0; }
+    void print(std::ostream &os) const;
+};
+
+// Runs the load to completion. Returns false with errno set if a
+// connection cannot be made or the server closes one early.
+bool runLoad(const LoadOptions &options, LoadReport &report);
+
+#endif  // LOAD_GENERATOR_H_
@@ -1,24 +1,193 @@
+#include<cerrno>
+#include<charconv>
+#include<cstdint>
+#include<csignal>
+#include<cstring>
+#include<fstream>
 #include<iostream>
+#include<memory>
 #include<string>
 
 #include "parser.h"
 #include "ast.h"
+#include "batch_mode.h"
+#include "eval_server.h"
+#include "library.h"
+#include "load_generator.h"
+#include "result_cache.h"
+#include "stats.h"
 
 using namespace std;
 
+// A whole non-negative decimal count; false for anything else.
+static bool parseCount(const char *text, size_t &value) {
+    const char *end = text + strlen(text);
+    auto res = from_chars(text, end, value);
+    return text != end && res.ec == errc() && res.ptr == end;
+}
+
+static int batchMain(const char *path) {
+    BatchSummary summary;
+    if (!runBatch(path, 1, summary)) {
+        cerr << "Cannot read " << (path ? path : "stdin") << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+    double seconds = summary.seconds > 0 ? summary.seconds : 1e-9;
+    cerr << "lines: " << summary.lines
+         << ", ok: " << summary.evaluated
+         << ", parse errors: " << summary.parseErrors
+         << ", eval errors: " << summary.evalErrors << "\n";
+    cerr << "time: " << summary.seconds << " s, "
+         << summary.lines / seconds << " lines/s, "
+         << summary.bytes / seconds / (1024 * 1024) << " MB/s\n";
+    return (summary.parseErrors || summary.evalErrors) ? 2 : 0;
+}
+
+// Compiles one formula per line into a library file; writes nothing if any
+// line fails to parse, so formula i is always line i of the non-blank input.
+static int compileMain(const char *input, const char *output) {
+    ifstream in(input);
+    if (!in) {
+        cerr << "Cannot open " << input << "\n";
+        return 1;
+    }
+    LibraryBuilder builder;
+    size_t lineNumber = 0, errors = 0;
+    string line;
+    while (getline(in, line)) {
+        ++lineNumber;
+        if (line.find_first_not_of(" \t\r") == string::npos) continue;
+        Result<size_t> added = builder.add(line);
+        if (!added) {
+            const Error &error = added.error();
+            cerr << input << ":" << lineNumber << ":" << error.offset + 1 << ": "
+                 << error.message() << "\n";
+            ++errors;
+        }
+    }
+    if (errors) return 2;
+    if (!builder.save(output)) {
+        cerr << "Cannot write " << output << "\n";
+        return 1;
+    }
+    cerr << "formulas: " << builder.size() << "\n";
+    return 0;
+}
+
+static EvalServer *runningServer = nullptr;
+
+static void stopServer(int) {
+    if (runningServer) runningServer->stop();
+}
+
+// Serves until SIGINT or SIGTERM, then prints the server's counters.
+static int serverMain(const char *socketPath, const char *libraryPath, ResultCache *results) {
+    ExpressionLibrary library;
+    if (libraryPath && library.open(libraryPath) != ExpressionLibrary::Status::OK) {
+        cerr << "Cannot load library " << libraryPath << "\n";
+        return 1;
+    }
+    EvalServer server(socketPath, libraryPath ? &library : nullptr, results);
+    if (!server.listen()) {
+        cerr << "Cannot listen on " << socketPath << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+    runningServer = &server;
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    cerr << "listening on " << socketPath << "\n";
+    bool ok = server.run();
+    runningServer = nullptr;
+    server.stats().print(cerr);
+    cerr << "\n";
+    if (results) {
+        results->stats().print(cerr);
+        cerr << "\n";
+    }
+    return ok ? 0 : 1;
+}
+
+static int loadMain(LoadOptions &options, const char *requestsPath) {
+    if (requestsPath) {
+        ifstream in(requestsPath);
+        if (!in) {
+            cerr << "Cannot open " << requestsPath << "\n";
+            return 1;
+        }
+        for (string line; getline(in, line);) {
+            if (!line.empty()) options.requests.push_back(line);
+        }
+    }
+    LoadReport report;
+    if (!runLoad(options, report)) {
+        cerr << "Load against " << options.socketPath << " failed: " << strerror(errno) << "\n";
+        return 1;
+    }
+    report.print(cerr);
+    return report.errors ? 2 : 0;
+}
+
 int main(int argc, char *argv[]) {
+    bool showStats = false;
+    LoadOptions load;
+    ResultCache::Options cacheOptions;
+    bool cacheResults = false;
+    size_t cacheMb = 0;
     for (int idx = 1; idx < argc; ++idx) {
         string opt(argv[idx]);
-        if (opt == "-v") {
+        if (opt == "--stats") {
+            showStats = true;
+        } else if (opt == "--connections" && idx + 1 < argc && parseCount(argv[idx + 1], load.connections)) {
+            ++idx;
+        } else if (opt == "--depth" && idx + 1 < argc && parseCount(argv[idx + 1], load.depth)) {
+            ++idx;
+        } else if (opt == "--requests" && idx + 1 < argc && parseCount(argv[idx + 1], load.total)) {
+            ++idx;
+        } else if (opt == "--result-cache" && idx + 1 < argc && parseCount(argv[idx + 1], cacheMb) &&
+                   cacheMb <= (SIZE_MAX >> 20)) {
+            ++idx;
+            cacheResults = true;
+            cacheOptions.budgetBytes = cacheMb << 20;
+        } else if (opt == "--clock") {
+            cacheOptions.eviction = ResultCache::Eviction::CLOCK;
+        } else if (opt == "-b") {
+            // Optional input file; stdin when omitted or "-".
+            int status = batchMain(idx + 1 < argc ? argv[idx + 1] : nullptr);
+            if (showStats) stats::dump(cerr);
+            return status;
+        } else if (opt == "-c" && idx + 2 < argc) {
+            return compileMain(argv[idx + 1], argv[idx + 2]);
+        } else if (opt == "-s" && idx + 1 < argc) {
+            unique_ptr<ResultCache> results;
+            if (cacheResults) results = make_unique<ResultCache>(cacheOptions);
+            return serverMain(argv[idx + 1], idx + 2 < argc ? argv[idx + 2] : nullptr, results.get());
+        } else if (opt == "-g" && idx + 1 < argc) {
+            load.socketPath = argv[idx + 1];
+            return loadMain(load, idx + 2 < argc ? argv[idx + 2] : nullptr);
+        } else if (opt == "-v") {
             cout << "Expression Evaluator 0.0\n";
             exit(0);
         } else if (opt == "-h") {
             cout << "Expression Evaluator\n";
             cout << ">> Type one-line expressions to evaluate.\n";
             cout << ">> Type quit to exit.\n";
+            cout << ">> Use -b [file] to evaluate one expression per line from a file or stdin.\n";
+            cout << ">> Use -c in out to compile one formula per line into a library file.\n";
+            cout << ">> Use -s socket [library] to serve evaluation requests on a Unix socket.\n";
+            cout << ">> Use -g socket [file] to send load to a server; --connections, --depth\n";
+            cout << ">> and --requests N before -g shape it.\n";
+            cout << ">> Use --result-cache MB [--clock] before -s to memoize results.\n";
+            cout << ">> Use --stats to print parse and evaluation statistics on exit.\n";
             exit(0);
         } else {
-            cout << "Usage: " << argv[0] << "[-v|-h]" << endl;
+            cout << "Usage: " << argv[0] << "[--stats] [-v|-h|-b [file]|-c in out|-s socket [library]|-g socket [file]]" << endl;
+            cout << "  --stats: dump parse/evaluation histograms to stderr on exit (needs make STATS=1)" << endl;
+            cout << "  -b: batch mode, one expression per line from file or stdin" << endl;
+            cout << "  -c: compile one formula per line of in into the library file out" << endl;
+            cout << "  -s: evaluation server on a Unix socket, one request per line (see eval_server.h)" << endl;
+            cout << "  -g: load generator for -s; sends the lines of file, or a built-in mix" << endl;
+            cout << "      --connections N, --depth N (requests in flight each), --requests N (total)" << endl;
+            cout << "  --result-cache MB: memoize -s results by expression and bindings, LRU or --clock" << endl;
             cout << "  -h: help message" << endl;
             cout << "  -v: version info" << endl;
             exit(1);
@@ -33,22 +202,25 @@ int main(int argc, char *argv[]) {
     string input;
     while(true) {
         cout << ">> ";
-        std::getline(cin, input);
+        if (!std::getline(cin, input)) break;
         if (input.empty()) continue;
 
         if ((input.size() == 4) && (input == "quit"))
             break;
         IExpression *expr = parser.parse(input);
         if (!expr) {
-            cout << "Error in parsing the input.\n";
-        } else if (!expr->evaluate()) {
-            cout << "Error in evaluating expression!\n";
-        } else {
-            cout << ">> = " << expr->getValue() << endl;
+            const Error &error = parser.error();
+            cout << "Error in parsing the input: " << error.message()
+                 << " at column " << error.offset + 1 << ".\n";
+        } else if (Result<int64_t> value = tryEvaluate(expr)) {
+            cout << ">> = " << *value << endl;
             ASTPrinter aprinter(cout);
             aprinter.print(expr);
+        } else {
+            cout << "Error in evaluating expression: " << value.error().message() << ".\n";
         }
     }
+    if (showStats) stats::dump(cerr);
     return 0;
 }
 
@@ -0,0 +1,192 @@
+#ifndef NUMERIC_H_
+#define NUMERIC_H_
+
+#include<cmath>
+#include<cstdint>
+#include<stdexcept>
+
+#include "bigint.h"
+#include "bytecode.h"
+#include "expression.h"
+#include "functions.h"
+#include "small_stack.h"
+#include "stats.h"
+#include "tree_eval.h"
+
+// Numeric modes for evaluating a parsed expression. The tree and bytecode
+// are shared; each mode is a traits class, and evaluateAs/executeAs are
+// templates over it, so every mode compiles to its own loop with plain
+// values and no per-operation type tag. getValue() remains the wrapping
+// int64 mode.
+//
+//   double v = evaluateAs<Float64>(tree);
+//   BigInt b = executeAs<BigInteger>(program);
+
+// int64 that throws std::overflow_error instead of wrapping.
+struct CheckedInt64 {
+    using Value = int64_t;
+    static Value fromInt(int64_t v) { return v; }
+    static Value fromLiteral(const NumberNode &n) { return n.getValue(); }
+    static Value apply(Operator op, Value lhs, Value rhs) {
+        Value out;
+        bool overflow;
+        switch (op) {
+        case Operator::ADD: overflow = __builtin_add_overflow(lhs, rhs, &out); break;
+        case Operator::SUB: overflow = __builtin_sub_overflow(lhs, rhs, &out); break;
+        case Operator::MUL: overflow = __builtin_mul_overflow(lhs, rhs, &out); break;
+        case Operator::DIV:
+            if (rhs == 0) throw std::runtime_error("Divide by zero");
+            overflow = lhs == INT64_MIN && rhs == -1;
+            out = overflow ? 0 : lhs / rhs;
+            break;
+        default:
+            throw std::runtime_error("Unknown operator");
+        }
+        if (overflow) throw std::overflow_error("Integer overflow");
+        return out;
+    }
+    static Value call(Operator fn, Value x) {
+        if (fn == Operator::ABS && x == INT64_MIN) throw std::overflow_error("Integer overflow");
+        return applyFunction(fn, x);
+    }
+};
+
+// IEEE double: division by zero and sqrt of a negative number give
+// infinities and NaN rather than throwing. A literal beyond int64_t is
+// std::out_of_range, as in the int64 modes.
+struct Float64 {
+    using Value = double;
+    static Value fromInt(int64_t v) { return static_cast<double>(v); }
+    static Value fromLiteral(const NumberNode &n) {
+        if (n.isOutOfRange()) throw std::out_of_range("Number out of range");
+        return n.getReal();
+    }
+    static Value apply(Operator op, Value lhs, Value rhs) {
+        switch (op) {
+        case Operator::ADD: return lhs + rhs;
+        case Operator::SUB: return lhs - rhs;
+        case Operator::MUL: return lhs * rhs;
+        case Operator::DIV: return lhs / rhs;
+        default:
+            throw std::runtime_error("Unknown operator");
+        }
+    }
+    static Value call(Operator fn, Value x) {
+        switch (fn) {
+        case Operator::SQRT: return std::sqrt(x);
+        case Operator::ABS: return std::fabs(x);
+        case Operator::SIN: return std::sin(x);
+        case Operator::COS: return std::cos(x);
+        default:
+            throw std::runtime_error("Unknown function");
+        }
+    }
+};
+
+// Arbitrary precision; never overflows, and reads literals beyond int64_t
+// from their digits. sqrt is the exact floor of the root, sin and cos
+// truncate like the int64 modes.
+struct BigInteger {
+    using Value = BigInt;
+    static Value fromInt(int64_t v) { return BigInt(v); }
+    static Value fromLiteral(const NumberNode &n) {
+        return n.isOutOfRange() ? BigInt::parse(n.getDigits()) : BigInt(n.getValue());
+    }
+    static Value apply(Operator op, const Value &lhs, const Value &rhs) {
+        switch (op) {
+        case Operator::ADD: return lhs + rhs;
+        case Operator::SUB: return lhs - rhs;
+        case Operator::MUL: return lhs * rhs;
+        case Operator::DIV: return lhs / rhs;
+        default:
+            throw std::runtime_error("Unknown operator");
+        }
+    }
+    static Value call(Operator fn, const Value &x) {
+        switch (fn) {
+        case Operator::SQRT: return x.sqrt();
+        case Operator::ABS: return x.abs();
+        case Operator::SIN: return BigInt(static_cast<int64_t>(std::sin(x.toDouble())));
+        case Operator::COS: return BigInt(static_cast<int64_t>(std::cos(x.toDouble())));
+        default:
+            throw std::runtime_error("Unknown function");
+        }
+    }
+};
+
+namespace numeric_detail {
+
+// Converts a leaf to the mode's value; variables come from the given array
+// when there is one, else from the node's VariableTable.
+template<typename Mode>
+class LeafReader : public IVisitor {
+    const typename Mode::Value *variables;
+public:
+    typename Mode::Value value;
+    explicit LeafReader(const typename Mode::Value *variables) : variables(variables) {}
+    void visitNumberNode(const NumberNode *expr) override {
+        value = Mode::fromLiteral(*expr);
+    }
+    void visitVariableNode(const VariableNode *expr) override {
+        value = variables ? variables[expr->getSlot()] : Mode::fromInt(expr->getValue());
+    }
+    void visitBinaryNode(const BinaryNode *) override {}
+    void visitUnaryFunctionNode(const UnaryFunctionNode *) override {}
+};
+
+}  // namespace numeric_detail
+
+// Evaluates a tree in the given mode, iteratively like getValue(). Variable
+// slot i reads variables[i] when variables is given.
+template<typename Mode>
+typename Mode::Value evaluateAs(const IExpression *expr,
+                                const typename Mode::Value *variables = nullptr) {
+    EXPR_STATS_TIMER(timer, stats::Metric::EVALUATE_NS);
+    if (!expr) throw std::runtime_error("Empty expression");
+    numeric_detail::LeafReader<Mode> reader(variables);
+    return evaluateIteratively<Mode>(expr, [&reader](const IExpression *leaf) {
+        leaf->accept(&reader);
+        return std::move(reader.value);
+    });
+}
+
+// Runs a compiled program in the given mode. Variable slot i reads
+// variables[i]; unlike Program::execute the bindings are of the mode's type.
+template<typename Mode>
+typename Mode::Value executeAs(const Program &program,
+                               const typename Mode::Value *variables = nullptr) {
+    EXPR_STATS_TIMER(timer, stats::Metric::EVALUATE_NS);
+    if (program.empty()) throw std::runtime_error("Malformed program");
+    using Value = typename Mode::Value;
+    SmallStack<Value, 64> stack;
+    for (const Instruction &ins : program.instructions()) {
+        switch (ins.op) {
+        case OpCode::PUSH:
+            stack.push(Mode::fromInt(ins.operand));
+            break;
+        case OpCode::LOAD:
+            if (!variables) throw std::invalid_argument("Missing variable bindings");
+            stack.push(variables[ins.operand]);
+            break;
+        case OpCode::ADD:
+        case OpCode::SUB:
+        case OpCode::MUL:
+        case OpCode::DIV: {
+            Value rhs = std::move(stack.top());
+            stack.pop();
+            Operator op = ins.op == OpCode::ADD ? Operator::ADD
+                        : ins.op == OpCode::SUB ? Operator::SUB
+                        : ins.op == OpCode::MUL ? Operator::MUL : Operator::DIV;
+            stack.top() = Mode::apply(op, stack.top(), rhs);
+            break;
+        }
+        case OpCode::CALL:
+            stack.top() = Mode::call(static_cast<Operator>(ins.operand), stack.top());
+            break;
+        }
+    }
+    if (stack.size() != 1) throw std::runtime_error("Malformed program");
+    return stack.top();
+}
+
+#endif  // NUMERIC_H_
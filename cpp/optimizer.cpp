@@ -0,0 +1,120 @@
+#include "optimizer.h"
+#include "functions.h"
+#include "tree_eval.h"
+
+size_t countNodes(const IExpression *expr) {
+    size_t count = 0;
+    walkPostOrder(expr, [](const IExpression *) { return true; },
+                  [&count](const IExpression *) { ++count; });
+    return count;
+}
+
+void ConstantFolder::setConstant(int64_t v) {
+    operands.push({ExpressionFactory::createNumber(arena, v), true, v, false});
+}
+
+void ConstantFolder::keep(IExpression *expr, bool divides) {
+    operands.push({expr, false, 0, divides});
+}
+
+ConstantFolder::Folded ConstantFolder::pop() {
+    Folded folded = operands.top();
+    operands.pop();
+    return folded;
+}
+
+void ConstantFolder::visitNumberNode(const NumberNode *expr) {
+    // Folding a non-integer or out-of-range literal would lose what the
+    // Float64 and BigInteger modes see.
+    if (expr->isOutOfRange()) {
+        keep(ExpressionFactory::createBigNumber(arena, expr->getDigits()), false);
+    } else if (expr->isInteger()) {
+        setConstant(expr->getValue());
+    } else {
+        keep(ExpressionFactory::createReal(arena, expr->getReal()), false);
+    }
+}
+
+void ConstantFolder::visitVariableNode(const VariableNode *expr) {
+    keep(ExpressionFactory::createVariable(arena, expr->getTable(), expr->getSlot()), false);
+}
+
+void ConstantFolder::visitBinaryNode(const BinaryNode *expr) {
+    Folded r = pop();
+    Folded l = pop();
+    IExpression *left = l.expr, *right = r.expr;
+    bool leftConst = l.constant, leftDiv = l.hasDivision;
+    bool rightConst = r.constant, rightDiv = r.hasDivision;
+    int64_t lv = l.value, rv = r.value;
+
+    if (leftConst && rightConst) {
+        int64_t folded = 0;
+        bool ok = true;
+        switch (expr->op) {
+        case Operator::ADD: ok = !__builtin_add_overflow(lv, rv, &folded); break;
+        case Operator::SUB: ok = !__builtin_sub_overflow(lv, rv, &folded); break;
+        case Operator::MUL: ok = !__builtin_mul_overflow(lv, rv, &folded); break;
+        case Operator::DIV:
+            ok = rv != 0 && !(lv == INT64_MIN && rv == -1);
+            if (ok) folded = lv / rv;
+            break;
+        default:
+            ok = false;
+        }
+        if (ok) {
+            setConstant(folded);
+            return;
+        }
+    }
+
+    switch (expr->op) {
+    case Operator::ADD:
+        if (rightConst && rv == 0) return keep(left, leftDiv);
+        if (leftConst && lv == 0) return keep(right, rightDiv);
+        break;
+    case Operator::SUB:
+        if (rightConst && rv == 0) return keep(left, leftDiv);
+        break;
+    case Operator::MUL:
+        if (rightConst && rv == 1) return keep(left, leftDiv);
+        if (leftConst && lv == 1) return keep(right, rightDiv);
+        if ((rightConst && rv == 0 && !leftDiv) || (leftConst && lv == 0 && !rightDiv)) {
+            return setConstant(0);
+        }
+        break;
+    case Operator::DIV:
+        if (rightConst && rv == 1) return keep(left, leftDiv);
+        break;
+    default:
+        break;
+    }
+    keep(ExpressionFactory::createBinary(arena, expr->op, left, right),
+         leftDiv || rightDiv || expr->op == Operator::DIV);
+}
+
+void ConstantFolder::visitUnaryFunctionNode(const UnaryFunctionNode *expr) {
+    Folded arg = pop();
+    if (arg.constant) {
+        // A domain error stays unfolded so evaluation still reports it.
+        try {
+            int64_t folded = applyFunction(expr->op, arg.value);
+            return setConstant(folded);
+        } catch (const std::runtime_error &) {
+        }
+    }
+    // sqrt can fail at run time, which x*0 must not hide any more than a division.
+    keep(ExpressionFactory::createUnary(arena, expr->op, arg.expr),
+         arg.hasDivision || expr->op == Operator::SQRT);
+}
+
+IExpression *ConstantFolder::fold(const IExpression *expr) {
+    while (!operands.empty()) operands.pop();  // left over if a fold threw
+    IExpression *result = nullptr;
+    if (expr) {
+        acceptPostOrder(expr, this);
+        result = pop().expr;
+    }
+    before = countNodes(expr);
+    after = countNodes(result);
+    return result;
+}
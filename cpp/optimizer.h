@@ -0,0 +1,53 @@
+#ifndef OPTIMIZER_H_
+#define OPTIMIZER_H_
+
+#include<cstdint>
+
+#include "visitor.h"
+#include "expression.h"
+#include "small_stack.h"
+
+// Builds a simplified copy of a tree: constant subtrees become single
+// NumberNodes and the identities x*1, 1*x, x+0, 0+x, x-0 and x/1 collapse
+// to x. x*0 and 0*x become 0 only when x contains no division or failing
+// function call, so the error inside x is still reported. A constant
+// division that would fail, a function argument outside its domain, or a
+// result that overflows int64, is left unfolded.
+class ConstantFolder : public IVisitor {
+    // Simplified form of a visited subtree.
+    struct Folded {
+        IExpression *expr;
+        bool constant;
+        int64_t value;
+        bool hasDivision;
+    };
+    Arena &arena;
+    // Subtrees still waiting for their parent; fold() visits in
+    // post-order, so a node's operands are on top when it is visited.
+    SmallStack<Folded, 32> operands;
+    size_t before = 0;
+    size_t after = 0;
+
+    void setConstant(int64_t v);
+    void keep(IExpression *expr, bool divides);
+    Folded pop();
+public:
+    explicit ConstantFolder(Arena &arena) : arena(arena) {}
+    void visitNumberNode(const NumberNode *expr) override;
+    void visitBinaryNode(const BinaryNode *expr) override;
+    void visitVariableNode(const VariableNode *expr) override;
+    void visitUnaryFunctionNode(const UnaryFunctionNode *expr) override;
+
+    // Returns the simplified tree, allocated in the arena given at
+    // construction; the input tree is not modified.
+    IExpression *fold(const IExpression *expr);
+    // Node counts of the last folded input and output.
+    size_t nodesBefore() const { return before; }
+    size_t nodesAfter() const { return after; }
+    size_t eliminated() const { return before - after; }
+};
+
+// Number of nodes in a tree.
+size_t countNodes(const IExpression *expr);
+
+#endif  // OPTIMIZER_H_
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#include "parallel.h"
+#include "parser.h"
+
+void parallelEvaluateBatch(ThreadPool &pool, const Program &program,
+                           const std::vector<ColumnView> &columns,
+                           size_t rows, int64_t *out, size_t grain) {
+    constexpr size_t kNoFailure = static_cast<size_t>(-1);
+    std::atomic<size_t> firstFailure{kNoFailure};
+    // Kind of the failure at firstFailure; only written on the error path.
+    std::mutex failureMutex;
+    ErrorCode kind = ErrorCode::DIVIDE_BY_ZERO;
+    std::string reason;
+    // Once up front: the slices below trust these sizes.
+    checkBatchColumns(program, columns, rows);
+
+    pool.parallelFor(rows, grain, [&](size_t begin, size_t end) {
+        // Nothing after a known failure can become the reported row.
+        if (begin > firstFailure.load(std::memory_order_relaxed)) return;
+        std::vector<ColumnView> slice(columns.size());
+        for (size_t i = 0; i < columns.size(); ++i) {
+            slice[i] = ColumnView{columns[i].data + begin, end - begin};
+        }
+        try {
+            evaluateBatch(program, slice, end - begin, out + begin);
+        } catch (const RowError &e) {
+            size_t row = begin + e.row();
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (row < firstFailure.load(std::memory_order_relaxed)) {
+                firstFailure.store(row, std::memory_order_relaxed);
+                if (dynamic_cast<const DivideByZeroError *>(&e)) kind = ErrorCode::DIVIDE_BY_ZERO;
+                else if (dynamic_cast<const DivideOverflowError *>(&e)) kind = ErrorCode::DIVIDE_OVERFLOW;
+                else kind = ErrorCode::DOMAIN_ERROR;
+                reason = e.reason();
+            }
+        }
+    });
+
+    size_t failed = firstFailure.load();
+    if (failed != kNoFailure) {
+        if (kind == ErrorCode::DIVIDE_BY_ZERO) throw DivideByZeroError(failed);
+        if (kind == ErrorCode::DIVIDE_OVERFLOW) throw DivideOverflowError(failed);
+        throw DomainError(reason, failed);
+    }
+}
+
+void parallelEvaluateBatch(ThreadPool &pool, const IExpression *expr,
+                           const std::vector<ColumnView> &columns,
+                           size_t rows, int64_t *out, size_t grain) {
+    BytecodeCompiler compiler;
+    Program program = compiler.compile(expr);
+    parallelEvaluateBatch(pool, program, columns, rows, out, grain);
+}
+
+std::vector<EvaluationResult> parallelEvaluate(ThreadPool &pool,
+                                               const std::vector<std::string> &expressions,
+                                               size_t grain) {
+    std::vector<EvaluationResult> results(expressions.size());
+    pool.parallelFor(expressions.size(), grain, [&](size_t begin, size_t end) {
+        Parser parser;
+        Arena arena;
+        for (size_t i = begin; i < end; ++i) {
+            Result<IExpression *> expr = parser.tryParse(expressions[i], arena);
+            Result<int64_t> value = expr ? tryEvaluate(*expr) : Result<int64_t>(expr.error());
+            if (value) {
+                results[i] = EvaluationResult{true, *value, nullptr, Error()};
+            } else {
+                results[i] = EvaluationResult{false, 0, value.error().message(), value.error()};
+            }
+            arena.reset();
+        }
+    });
+    return results;
+}
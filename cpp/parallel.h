@@ -0,0 +1,44 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include<cstdint>
+#include<string>
+#include<vector>
+
+#include "batch.h"
+#include "result.h"
+#include "thread_pool.h"
+
+// Rows per task when splitting a batch across the pool.
+constexpr size_t kDefaultParallelGrain = 1 << 14;
+
+// Evaluates a program over all rows like evaluateBatch, with chunks of
+// `grain` rows scheduled on the pool. The program and the input columns
+// are only read, so they are shared by all workers. Throws the same
+// RowError as evaluateBatch, with the lowest failing row.
+void parallelEvaluateBatch(ThreadPool &pool, const Program &program,
+                           const std::vector<ColumnView> &columns,
+                           size_t rows, int64_t *out,
+                           size_t grain = kDefaultParallelGrain);
+
+// Tree variant: compiles the tree once, then shares the program. Column i
+// feeds the variable in slot i of the table the tree was parsed with.
+void parallelEvaluateBatch(ThreadPool &pool, const IExpression *expr,
+                           const std::vector<ColumnView> &columns,
+                           size_t rows, int64_t *out,
+                           size_t grain = kDefaultParallelGrain);
+
+struct EvaluationResult {
+    bool ok;
+    int64_t value;
+    const char *error;  // static message when !ok
+    Error detail;       // code and, for parse errors, offset when !ok
+};
+
+// Parses and evaluates independent expressions on the pool, one parser
+// and arena per task.
+std::vector<EvaluationResult> parallelEvaluate(ThreadPool &pool,
+                                               const std::vector<std::string> &expressions,
+                                               size_t grain = 64);
+
+#endif  // PARALLEL_H_
@@ -0,0 +1,78 @@
+#include "parse_cache.h"
+
+ParseCache::ParseCache(size_t capacity) : maxEntries(capacity ? capacity : 1) {}
+
+void ParseCache::normalize(std::string_view text, std::string &out) {
+    out.clear();
+    ViewTokenizer tokenizer(text);
+    while (true) {
+        Result<TokenView> token = tokenizer.tryNext();
+        if (token && (*token).type == Token::Type::END) break;
+        // Invalid characters stay in the key so that it fails to parse too.
+        uint32_t offset = token ? (*token).offset : token.error().offset;
+        uint32_t length = token ? (*token).length : token.error().length;
+        if (!out.empty()) out.push_back(' ');
+        out.append(text.substr(offset, length));
+    }
+}
+
+std::shared_ptr<const CachedExpression> ParseCache::build(std::string_view text) {
+    auto entry = std::make_shared<CachedExpression>();
+    Parser parser;
+    parser.setVariables(&entry->variables);
+    entry->tree = parser.parseInArena(text);
+    if (!entry->tree) return nullptr;
+    BytecodeCompiler compiler;
+    entry->program = compiler.compile(entry->tree.get());
+    return entry;
+}
+
+std::shared_ptr<const CachedExpression> ParseCache::get(std::string_view text) {
+    // Reused per thread so a hit does not allocate for the key.
+    thread_local std::string key;
+    normalize(text, key);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            ++counters.hits;
+            lru.splice(lru.begin(), lru, it->second);
+            return it->second->second;
+        }
+        ++counters.misses;
+    }
+
+    // Parse outside the lock; other threads keep hitting meanwhile.
+    auto entry = build(key);
+    if (!entry) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        // Another thread inserted the same text first; keep its entry.
+        lru.splice(lru.begin(), lru, it->second);
+        return it->second->second;
+    }
+    lru.emplace_front(key, entry);
+    index.emplace(key, lru.begin());
+    if (lru.size() > maxEntries) {
+        index.erase(lru.back().first);
+        lru.pop_back();
+        ++counters.evictions;
+    }
+    return entry;
+}
+
+ParseCache::Stats ParseCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats s = counters;
+    s.size = lru.size();
+    return s;
+}
+
+void ParseCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    index.clear();
+    lru.clear();
+}
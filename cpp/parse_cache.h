@@ -0,0 +1,67 @@
+#ifndef PARSE_CACHE_H_
+#define PARSE_CACHE_H_
+
+#include<list>
+#include<memory>
+#include<mutex>
+#include<string>
+#include<string_view>
+#include<unordered_map>
+
+#include "bytecode.h"
+#include "parser.h"
+#include "expression_id.h"
+
+// Everything produced by parsing one expression text. Never modified after
+// construction, so it can be shared freely between threads; the tree's
+// variable nodes point into `variables`, so entries are never moved.
+struct CachedExpression {
+    const uint64_t id = newExpressionIds();  // ResultCache key
+    VariableTable variables;
+    ParsedExpression tree;
+    Program program;
+
+    CachedExpression() = default;
+    CachedExpression(const CachedExpression &) = delete;
+    CachedExpression &operator=(const CachedExpression &) = delete;
+};
+
+// Bounded, thread-safe LRU cache in front of Parser::parse keyed by the
+// whitespace-normalized expression text.
+class ParseCache {
+public:
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t size = 0;
+    };
+
+    explicit ParseCache(size_t capacity);
+
+    // Returns the cached entry for the text, parsing it on a miss, or
+    // nullptr if the text does not parse. Failures are not cached.
+    std::shared_ptr<const CachedExpression> get(std::string_view text);
+
+    Stats stats() const;
+    void clear();
+    size_t capacity() const { return maxEntries; }
+
+    // The tokens of text joined by single spaces, so any spacing of the
+    // same tokens gives one key and the key lexes exactly like the text
+    // ("1e+ 3" is four tokens, not the literal 1e+3).
+    static void normalize(std::string_view text, std::string &out);
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const CachedExpression>>;
+
+    size_t maxEntries;
+    mutable std::mutex mutex;
+    std::list<Entry> lru;  // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    Stats counters;
+
+    static std::shared_ptr<const CachedExpression> build(std::string_view text);
+};
+
+#endif  // PARSE_CACHE_H_
@@ -1,22 +1,24 @@
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <string>
+
 #include "parser.h"
+#include "charclass.h"
+#include "dag.h"
+#include "functions.h"
 
 void Tokenizer::skipWhitespace() {
-    while (position < input.size() && std::isspace(input[position])) {
-        ++position;
-    }
+    position = charclass::skip(input.data(), position, input.size(), charclass::SPACE);
 }
 Token Tokenizer::parseNumber() {
     size_t start = position;
-    while (position < input.size() && std::isdigit(input[position])) {
-        ++position;
-    }
+    position += lexNumber(std::string_view(input).substr(start)).length;
     return Token(input.substr(start, position - start), Token::Type::NUM);
 }
 Token Tokenizer::parseString() {
     size_t start = position;
-    while (position < input.size() && std::isalnum(input[position])) {
-        ++position;
-    }
+    position = charclass::skip(input.data(), position, input.size(), charclass::ALNUM);
     return Token(input.substr(start, position - start), Token::Type::ID);
 }
 
@@ -28,7 +30,6 @@ Token Tokenizer::parseOperator() {
         case '*': return Token("*", Token::Type::MUL);
         case '/': return Token("/", Token::Type::DIV);
         default:
-            cerr << "Invalid operator '" << op << "' at position " << position - 1 << "\n";
             return Token("", Token::Type::END); // Return a default token
     }
 }
@@ -39,7 +40,6 @@ Token Tokenizer::parseParentheses() {
     } else if (paren == ')') {
         return Token(")", Token::Type::RPAREN);
     } else {
-        cerr << "Invalid parentheses '" << paren << "' at position " << position - 1 << "\n";
         return Token("", Token::Type::END); // Return a default token
     }
 }
@@ -61,27 +61,281 @@ Token Tokenizer::next() {
     if (position >= input.size()) {
         return Token("", Token::Type::END); // Return a default token
     }
-    if (std::isdigit(input[position])) {
+    if (charclass::isDigit(input[position])) {
         return parseNumber();
     } else if (input[position] == '+' || input[position] == '-' ||
                input[position] == '*' || input[position] == '/') {
         return parseOperator();
     } else if (input[position] == '(' || input[position] == ')') {
         return parseParentheses();
-    } else if (std::isalpha(input[position])) {
+    } else if (charclass::isAlpha(input[position])) {
         // TODO: Handle identifiers or keywords if needed
         auto id = parseString();
         // For now, treat identifiers as NUM for simplicity
         //cerr << "Identifiers are not supported yet: " << id.value << "\n";
         return Token(id.value, Token::Type::ID);
     } else {
-        cerr << "Invalid character '" << input[position] << "' at position " << position << "\n";
         advance(); // Skip invalid character
         return next(); // Try to get the next token
     }
 }
 
-int Parser::getPrecedence(const Token &token) {
+namespace {
+
+using charclass::isDigit;
+
+const char *skipDigits(const char *p, const char *last) {
+    return p + charclass::skip(p, 0, static_cast<size_t>(last - p), charclass::DIGIT);
+}
+
+// Appends the digits of [first, last) to value; false on overflow.
+bool accumulate(int64_t &value, const char *first, const char *last) {
+    for (const char *p = first; p != last; ++p) {
+        if (__builtin_mul_overflow(value, 10, &value) ||
+            __builtin_add_overflow(value, *p - '0', &value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Longest literal, in digits, that setBigLiterals keeps; "1e999999999"
+// is not worth a gigabyte of zeros.
+constexpr size_t kMaxBigDigits = 4096;
+
+// Plain decimal digits of a literal lexNumber found OUT_OF_RANGE, which is
+// always an integer: "1.5e30" gives 15 followed by 29 zeros.
+bool integerDigits(std::string_view text, std::string &out) {
+    const char *first = text.data();
+    const char *last = first + text.size();
+    const char *intEnd = skipDigits(first, last);
+    const char *fracBegin = intEnd, *fracEnd = intEnd;
+    if (intEnd != last && *intEnd == '.') {
+        fracBegin = intEnd + 1;
+        fracEnd = skipDigits(fracBegin, last);
+    }
+    int64_t exponent = 0;
+    if (fracEnd != last) {  // what remains is the exponent
+        const char *q = fracEnd + 1;
+        if (*q == '+') ++q;
+        auto [expEnd, ec] = std::from_chars(q, last, exponent);
+        if (ec != std::errc() || exponent > int64_t(kMaxBigDigits)) return false;
+    }
+    while (first != intEnd && *first == '0') ++first;
+    out.assign(first, intEnd);
+    out.append(fracBegin, fracEnd);
+    // A negative scale can only cancel trailing zeros.
+    int64_t scale = exponent - (fracEnd - fracBegin);
+    for (; scale < 0 && !out.empty() && out.back() == '0'; ++scale) out.pop_back();
+    if (scale < 0 || out.size() + size_t(scale) > kMaxBigDigits) return false;
+    out.append(size_t(scale), '0');
+    return true;
+}
+
+}  // namespace
+
+NumberLiteral lexNumber(std::string_view text) {
+    const char *first = text.data();
+    const char *last = first + text.size();
+    NumberLiteral literal;
+
+    // Plain integers, by far the common case, are decoded by from_chars
+    // alone.
+    int64_t value = 0;
+    auto [intEnd, ec] = std::from_chars(first, last, value);
+    const char *p = intEnd;
+    bool hasFraction = p != last && *p == '.';
+    const char *fracBegin = hasFraction ? p + 1 : p;
+    const char *fracEnd = hasFraction ? skipDigits(fracBegin, last) : p;
+    p = fracEnd;
+
+    // The exponent only belongs to the literal when digits follow it, so
+    // "2e" stays the number 2 followed by the identifier e.
+    int64_t exponent = 0;
+    if (p != last && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool negative = q != last && *q == '-';
+        if (q != last && (*q == '-' || *q == '+')) ++q;
+        if (q != last && isDigit(*q)) {
+            int magnitude = 0;
+            auto [expEnd, expEc] = std::from_chars(q, last, magnitude);
+            // Any exponent this large overflows or leaves a fraction.
+            if (expEc == std::errc::result_out_of_range) magnitude = INT_MAX;
+            exponent = negative ? -int64_t(magnitude) : int64_t(magnitude);
+            p = expEnd;
+        }
+    }
+    literal.length = static_cast<size_t>(p - first);
+
+    if (!hasFraction && exponent == 0) {
+        if (ec == std::errc::result_out_of_range) {
+            literal.form = NumberForm::OUT_OF_RANGE;
+        } else {
+            literal.value = value;
+        }
+        return literal;
+    }
+
+    // Split the significant digits from the power of ten they are scaled
+    // by, dropping trailing zeros so that only a non-zero last digit can
+    // fall after the decimal point.
+    while (fracEnd != fracBegin && fracEnd[-1] == '0') --fracEnd;
+    const char *digitsEnd = intEnd;
+    int64_t scale = exponent;
+    if (fracEnd != fracBegin) {
+        scale -= fracEnd - fracBegin;
+    } else {
+        while (digitsEnd != first && digitsEnd[-1] == '0') --digitsEnd;
+        scale += intEnd - digitsEnd;
+    }
+    const char *digitsBegin = first;
+    while (digitsBegin != digitsEnd && *digitsBegin == '0') ++digitsBegin;
+    if (digitsBegin == digitsEnd && fracEnd == fracBegin) {
+        return literal;  // all zeros
+    }
+    if (scale < 0) {
+        literal.form = NumberForm::FRACTION;
+        return literal;
+    }
+    value = 0;
+    bool fits = accumulate(value, digitsBegin, digitsEnd) &&
+                accumulate(value, fracBegin, fracEnd);
+    for (int64_t i = 0; fits && i < scale; ++i) {
+        fits = !__builtin_mul_overflow(value, 10, &value);
+    }
+    if (fits) {
+        literal.value = value;
+    } else {
+        literal.form = NumberForm::OUT_OF_RANGE;
+    }
+    return literal;
+}
+
+TokenView ViewTokenizer::make(Token::Type type, size_t start) const {
+    TokenView token;
+    token.type = type;
+    token.offset = static_cast<uint32_t>(start);
+    token.length = static_cast<uint32_t>(position - start);
+    return token;
+}
+
+TokenView ViewTokenizer::lex() {
+    position = charclass::skip(input.data(), position, input.size(), charclass::SPACE);
+    if (position >= input.size()) {
+        return make(Token::Type::END, position);
+    }
+    size_t start = position;
+    unsigned char c = input[position];
+    uint8_t cls = charclass::classify(c);
+    if (cls & charclass::DIGIT) {
+        NumberLiteral literal = lexNumber(input.substr(start));
+        position += literal.length;
+        TokenView token = make(Token::Type::NUM, start);
+        token.numberForm = literal.form;
+        token.number = literal.value;
+        return token;
+    }
+    if (cls & charclass::ALPHA) {
+        position = charclass::skip(input.data(), position + 1, input.size(), charclass::ALNUM);
+        return make(Token::Type::ID, start);
+    }
+    ++position;
+    switch (c) {
+        case '+': return make(Token::Type::PLUS, start);
+        case '-': return make(Token::Type::MINUS, start);
+        case '*': return make(Token::Type::MUL, start);
+        case '/': return make(Token::Type::DIV, start);
+        case '(': return make(Token::Type::LPAREN, start);
+        case ')': return make(Token::Type::RPAREN, start);
+        default: return make(Token::Type::INVALID, start);
+    }
+}
+
+TokenView ViewTokenizer::scan() {
+    if (hasLookahead) {
+        hasLookahead = false;
+        return lookahead;
+    }
+    return lex();
+}
+
+TokenView ViewTokenizer::next() {
+    TokenView token = scan();
+    while (token.type == Token::Type::INVALID) token = scan();
+    return token;
+}
+
+Result<TokenView> ViewTokenizer::tryNext() {
+    TokenView token = scan();
+    if (token.type == Token::Type::INVALID) {
+        return Error{ErrorCode::INVALID_CHARACTER, token.offset, token.length};
+    }
+    return token;
+}
+
+double ViewTokenizer::real(const TokenView &token) const {
+    if (token.numberForm == NumberForm::INTEGER) return double(token.number);
+    double value = 0;
+    std::string_view digits = text(token);
+    auto [end, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    if (ec == std::errc::result_out_of_range) {
+        // Too large for an int64_t and a double, or a fraction too small.
+        return token.numberForm == NumberForm::OUT_OF_RANGE ? HUGE_VAL : 0.0;
+    }
+    return value;
+}
+
+const TokenView &ViewTokenizer::peek() {
+    if (!hasLookahead) {
+        lookahead = lex();
+        hasLookahead = true;
+    }
+    return lookahead;
+}
+
+IExpression *Parser::makeNumber(int64_t value) {
+    EXPR_STATS_ONLY(++counters.nodes; counters.allocations += !dagFactory && !arena;)
+    if (dagFactory) return dagFactory->createNumber(value);
+    return arena ? ExpressionFactory::createNumber(*arena, value)
+                 : ExpressionFactory::createNumber(value);
+}
+
+IExpression *Parser::makeReal(double value) {
+    EXPR_STATS_ONLY(++counters.nodes; counters.allocations += !dagFactory && !arena;)
+    if (dagFactory) return dagFactory->createReal(value);
+    return arena ? ExpressionFactory::createReal(*arena, value)
+                 : ExpressionFactory::createReal(value);
+}
+
+IExpression *Parser::makeBigNumber(std::string_view digits) {
+    EXPR_STATS_ONLY(++counters.nodes; counters.allocations += !dagFactory && !arena;)
+    if (dagFactory) return dagFactory->createBigNumber(digits);
+    return arena ? ExpressionFactory::createBigNumber(*arena, digits)
+                 : ExpressionFactory::createBigNumber(digits);
+}
+
+IExpression *Parser::makeVariable(size_t slot) {
+    EXPR_STATS_ONLY(++counters.nodes; counters.allocations += !dagFactory && !arena;)
+    if (dagFactory) return dagFactory->createVariable(variables, slot);
+    return arena ? ExpressionFactory::createVariable(*arena, variables, slot)
+                 : ExpressionFactory::createVariable(variables, slot);
+}
+
+IExpression *Parser::makeBinary(Operator op, IExpression *left, IExpression *right) {
+    EXPR_STATS_ONLY(++counters.nodes; counters.allocations += !dagFactory && !arena;)
+    if (dagFactory) return dagFactory->createBinary(op, left, right);
+    return arena ? ExpressionFactory::createBinary(*arena, op, left, right)
+                 : ExpressionFactory::createBinary(op, left, right);
+}
+
+IExpression *Parser::makeUnary(Operator op, IExpression *arg) {
+    EXPR_STATS_ONLY(++counters.nodes; counters.allocations += !dagFactory && !arena;)
+    if (dagFactory) return dagFactory->createUnary(op, arg);
+    return arena ? ExpressionFactory::createUnary(*arena, op, arg)
+                 : ExpressionFactory::createUnary(op, arg);
+}
+
+int Parser::getPrecedence(const TokenView &token) {
     switch (token.type) {
         case Token::Type::PLUS:
         case Token::Type::MINUS:
@@ -94,118 +348,213 @@ int Parser::getPrecedence(const Token &token) {
     }
 }
 
-IExpression *Parser::parseNumber(const Token &token) {
-    try {
-        return ExpressionFactory::createNumber(std::stoi(token.value));
-    } catch (const std::invalid_argument &e) {
-        cerr << "Invalid number: " << token.value << "\n";
-        return nullptr;
-    }
+IExpression *Parser::fail(ErrorCode code, const TokenView &token) {
+    lastError = Error{code, token.offset, token.length};
+    return nullptr;
 }
 
-IExpression *Parser::parseParentheses() {
-    if (currentToken.type != Token::Type::LPAREN) {
-        cerr << "Expected '(', but found '" << currentToken.value << "'\n";
-        return nullptr;
+IExpression *Parser::parseNumber(const TokenView &token) {
+    if (token.numberForm == NumberForm::FRACTION) {
+        if (!realLiterals) return fail(ErrorCode::NON_INTEGER_LITERAL, token);
+        // Its truncation has to fit an int64_t as well.
+        double value = tokenizer->real(token);
+        if (value >= 0x1p63) return fail(ErrorCode::NUMBER_OUT_OF_RANGE, token);
+        return makeReal(value);
     }
-    advance(); // Skip the '('
-
-    auto expr = parseExpression(0); // Parse the expression inside parentheses
-    if (!expr) {
-        return nullptr; // Error already reported in parseExpression
+    if (token.numberForm == NumberForm::OUT_OF_RANGE) {
+        std::string digits;
+        if (!bigLiterals || !integerDigits(text(token), digits)) {
+            return fail(ErrorCode::NUMBER_OUT_OF_RANGE, token);
+        }
+        return makeBigNumber(digits);
     }
+    return makeNumber(token.number);
+}
 
-    if (currentToken.type != Token::Type::RPAREN) {
-        cerr << "Expected ')', but found '" << currentToken.value << "'\n";
-        return nullptr;
+IExpression *Parser::parseVariable(const TokenView &token) {
+    if (!variables) {
+        return fail(ErrorCode::IDENTIFIERS_DISABLED, token);
     }
-    return expr;
+    size_t slot = variables->declare(text(token));
+    return makeVariable(slot);
 }
 
 IExpression *Parser::parsePrimary() {
-    //cout << "Parsing primary expression: " << endl;
-    //cout << "Current token: " << currentToken.value << endl;    
     if (currentToken.type == Token::Type::NUM) {
         return parseNumber(currentToken);
-    } else if (currentToken.type == Token::Type::LPAREN) {
-        return parseParentheses();
     } else if (currentToken.type == Token::Type::ID) {
-        cerr << "Identifiers are not supported yet: " << currentToken.value << "\n";
-        advance(); // Skip the identifier
-        return nullptr; // Return nullptr for unsupported identifiers
-    } else if (currentToken.type == Token::Type::END) {
-        return nullptr; // No more tokens to parse
+        return parseVariable(currentToken);
+    } else if (currentToken.type == Token::Type::INVALID) {
+        return fail(ErrorCode::INVALID_CHARACTER, currentToken);
     } else {
-        cerr << "Unexpected token '" << currentToken.value << "' while parsing primary expression.\n";
-        return nullptr;
+        return fail(ErrorCode::EXPECTED_OPERAND, currentToken);
     }
 }
 
 void Parser::advance() {
-    if (tokenizer->hasNext()) {
-        currentToken = tokenizer->next();
-    } else {
-        currentToken = Token("", Token::Type::END); // Set to END if no more tokens
-    }
+#ifdef EXPR_STATS
+    auto start = std::chrono::steady_clock::now();
+    currentToken = tokenizer->scan();
+    counters.tokenizeNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    counters.tokens += currentToken.type != Token::Type::END;
+#else
+    currentToken = tokenizer->scan();
+#endif
 }
 
-IExpression *Parser::parseOperator(const Token &opToken, IExpression *left, IExpression *right) {
+IExpression *Parser::parseOperator(const TokenView &opToken, IExpression *left, IExpression *right) {
     if (!left || !right) {
-        cerr << "Invalid operands for operator '" << opToken.value << "'.\n";
-        return nullptr;
+        return fail(ErrorCode::EXPECTED_OPERAND, opToken);
+    }
+    auto op = BinaryNode::get(text(opToken)[0]);
+    return makeBinary(op, left, right);
+}
+
+// Pops one operator and its two operands and pushes the combined node.
+bool Parser::reduce() {
+    TokenView opToken = operators.back();
+    operators.pop_back();
+    IExpression *right = operands.back();
+    operands.pop_back();
+    IExpression *left = operands.back();
+    operands.pop_back();
+    IExpression *node = parseOperator(opToken, left, right);
+    if (!node) {
+        return false;
     }
-    auto op = BinaryNode::get(opToken.value[0]);
-    return ExpressionFactory::createBinary(op, left, right);
+    operands.push_back(node);
+    return true;
 }
 
-IExpression *Parser::parseExpression(int precedence) {
-    auto left = parsePrimary();
-    if (!left) return nullptr;
+// Shunting-yard over explicit stacks: nesting depth and chain length are
+// bounded by memory, not by the native call stack. Operators are
+// left-associative. The expression must span the whole input: a token
+// that cannot continue it, such as "2" in "1 2" or an unmatched ')', is
+// an UNEXPECTED_TOKEN error.
+IExpression *Parser::parseExpression() {
+    operands.clear();
+    operators.clear();
+    size_t openGroups = 0;
+    bool expectOperand = true;
 
-    // fetch the next token
-    advance();
     while (true) {
-        int currentPrecedence = getPrecedence(currentToken);
-        // if the current token is of lower or equal precedence, we stop parsing
-        // evaluate left-associativity by using the same precedence for the right operand
-        if (currentPrecedence <= 0 || currentPrecedence <= precedence) {
-            break;
+        if (expectOperand) {
+            if (currentToken.type == Token::Type::LPAREN) {
+                operators.push_back(currentToken);
+                ++openGroups;
+                advance();
+                continue;
+            }
+            if (currentToken.type == Token::Type::ID &&
+                tokenizer->peek().type == Token::Type::LPAREN) {
+                // Function call: resolved here, once, to its operator.
+                const FunctionInfo *function = lookupFunction(text(currentToken));
+                if (!function) {
+                    return fail(ErrorCode::UNKNOWN_FUNCTION, currentToken);
+                }
+                TokenView call = currentToken;
+                call.number = static_cast<int64_t>(function->op);
+                operators.push_back(call);
+                advance();
+                continue;
+            }
+            IExpression *operand = parsePrimary();
+            if (!operand) {
+                return nullptr;
+            }
+            operands.push_back(operand);
+            expectOperand = false;
+            advance();
+            continue;
         }
 
-        Token opToken = currentToken;
-        advance(); // consume operator
-
-        auto right = parseExpression(currentPrecedence);
-        if (!right) {
-            cerr << "Error parsing right operand after operator '" << opToken.value << "'.\n";
-            return nullptr;
+        int precedence = getPrecedence(currentToken);
+        if (precedence > 0) {
+            while (!operators.empty() && operators.back().type != Token::Type::LPAREN &&
+                   getPrecedence(operators.back()) >= precedence) {
+                if (!reduce()) return nullptr;
+            }
+            operators.push_back(currentToken);
+            expectOperand = true;
+            advance(); // consume operator
+        } else if (currentToken.type == Token::Type::INVALID) {
+            return fail(ErrorCode::INVALID_CHARACTER, currentToken);
+        } else if (openGroups > 0) {
+            if (currentToken.type != Token::Type::RPAREN) {
+                return fail(ErrorCode::EXPECTED_RPAREN, currentToken);
+            }
+            while (operators.back().type != Token::Type::LPAREN) {
+                if (!reduce()) return nullptr;
+            }
+            operators.pop_back();
+            --openGroups;
+            if (!operators.empty() && operators.back().type == Token::Type::ID) {
+                Operator function = static_cast<Operator>(operators.back().number);
+                operators.pop_back();
+                operands.back() = makeUnary(function, operands.back());
+            }
+            advance(); // skip the ')'
+        } else if (currentToken.type != Token::Type::END) {
+            return fail(ErrorCode::UNEXPECTED_TOKEN, currentToken);
+        } else {
+            break;
         }
+    }
 
-        left = parseOperator(opToken, left, right);
-        if (!left) {
-            cerr << "Error creating binary expression for operator '" << opToken.value << "'.\n";
-            return nullptr;
-        }
+    while (!operators.empty()) {
+        if (!reduce()) return nullptr;
     }
+    return operands.back();
+}
 
-    return left;
+IExpression *Parser::parse(std::string_view input) {
+    arena = nullptr;
+    return parseInput(input);
 }
 
-IExpression *Parser::parse(std::string input) {
+IExpression *Parser::parseInput(std::string_view input) {
+    lastError = Error();
     if (input.empty()) {
-        cerr << "Input is empty.\n";
+        lastError = Error{ErrorCode::EMPTY_INPUT, 0, 0};
         return nullptr;
     }
-    tokenizer = new Tokenizer(std::move(input));
+    EXPR_STATS_TIMER(timer, stats::Metric::PARSE_NS);
+    EXPR_STATS_ONLY(
+        counters = stats::ParseCounters();
+        size_t blocksBefore = arena ? arena->blockCount() : 0;
+    )
+    ViewTokenizer tok(input);
+    tokenizer = &tok;
     advance(); // Initialize the first token
-    //cout << "first token: " << currentToken.value << endl;
-    auto res = parseExpression(0);
-    /*
-    if (res) {
-        res->print(cout);
-        cout << endl;
-    }
-    */
-    delete tokenizer;
+    auto res = parseExpression();
+    tokenizer = nullptr;
+#ifdef EXPR_STATS
+    if (arena && arena->blockCount() > blocksBefore) {
+        counters.allocations += arena->blockCount() - blocksBefore;
+    }
+    stats::histogram(stats::Metric::TOKENIZE_NS).record(counters.tokenizeNs);
+    stats::histogram(stats::Metric::TOKENS).record(counters.tokens);
+    stats::histogram(stats::Metric::NODES).record(counters.nodes);
+    stats::histogram(stats::Metric::ALLOCATIONS).record(counters.allocations);
+    if (res) stats::histogram(stats::Metric::DEPTH).record(stats::treeDepth(res));
+#endif
     return res;
 }
+
+IExpression *Parser::parse(std::string_view input, Arena &arena) {
+    this->arena = &arena;
+    return parseInput(input);
+}
+
+Result<IExpression *> Parser::tryParse(std::string_view input, Arena &arena) {
+    IExpression *expr = parse(input, arena);
+    if (!expr) return lastError;
+    return expr;
+}
+
+ParsedExpression Parser::parseInArena(std::string_view input) {
+    ParsedExpression result;
+    result.root = parse(input, result.arena);
+    return result;
+}
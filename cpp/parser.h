@@ -2,17 +2,22 @@
 #define PARSER_H_
 
 #include<string>
+#include<string_view>
 #include<sstream>
 #include<iostream>
 #include<vector>
 #include<cctype>
+#include<cstdint>
 
 #include "expression.h"
+#include "result.h"
+#include "stats.h"
 using namespace std;
 
 struct Token {
     string value;
-    enum class Type { NUM, PLUS, MINUS, MUL, DIV, LPAREN, RPAREN, ID,END };
+    // INVALID is a character that starts no token.
+    enum class Type { NUM, PLUS, MINUS, MUL, DIV, LPAREN, RPAREN, ID,END, INVALID };
     Type type;
     Token() : value(""), type(Type::NUM) {}
     Token(string s, Type t) : value(s), type(t) {}
@@ -37,22 +42,150 @@ private:
     Token parseString();
 };
 
+// What a number literal decodes to: an exact integer, a value with a
+// non-zero fractional part, or an integer too large for int64_t.
+enum class NumberForm : uint8_t { INTEGER, FRACTION, OUT_OF_RANGE };
+
+struct NumberLiteral {
+    NumberForm form = NumberForm::INTEGER;
+    size_t length = 0;  // characters consumed
+    int64_t value = 0;  // set for INTEGER only
+};
+
+// Decodes the literal at the start of text, which must begin with a digit:
+// digits, then an optional '.' and fraction digits, then an optional
+// exponent (e or E, an optional sign and digits). Works on the characters
+// in place and reports overflow through form rather than by throwing, so
+// "1.5e3" is the integer 1500 and "1.25" a FRACTION, exactly.
+NumberLiteral lexNumber(std::string_view text);
+
+// Token that refers back into the input instead of owning its text.
+// Numbers come pre-decoded: number holds the value when numberForm is
+// INTEGER and is 0 otherwise.
+struct TokenView {
+    Token::Type type = Token::Type::END;
+    uint32_t offset = 0;
+    uint32_t length = 0;
+    NumberForm numberForm = NumberForm::INTEGER;
+    int64_t number = 0;
+};
+
+// Zero-copy counterpart of Tokenizer: lexes over a string_view that must
+// outlive it, never allocates, and keeps one token of lookahead so peek()
+// does not re-scan the input.
+class ViewTokenizer {
+    std::string_view input;
+    size_t position = 0;
+    TokenView lookahead;
+    bool hasLookahead = false;
+    TokenView lex();
+    TokenView make(Token::Type type, size_t start) const;
+    // Next token, INVALID ones included.
+    TokenView scan();
+    friend class Parser;
+public:
+    explicit ViewTokenizer(std::string_view input) : input(input) {}
+    // Skips invalid characters, like Tokenizer::next.
+    TokenView next();
+    // Reports an invalid character as INVALID_CHARACTER instead; the
+    // character is consumed either way.
+    Result<TokenView> tryNext();
+    const TokenView &peek();
+    std::string_view text(const TokenView &token) const {
+        return input.substr(token.offset, token.length);
+    }
+    // Nearest double to a NUM token, for literals that are not integers.
+    double real(const TokenView &token) const;
+};
+
+// Owns a parsed tree together with the arena its nodes were allocated in;
+// the whole tree is released in one go when the handle is destroyed.
+class ParsedExpression {
+    Arena arena;
+    IExpression *root = nullptr;
+    friend class Parser;
+public:
+    ParsedExpression() = default;
+    ParsedExpression(ParsedExpression &&other) noexcept
+        : arena(std::move(other.arena)), root(other.root) {
+        other.root = nullptr;
+    }
+    ParsedExpression &operator=(ParsedExpression &&other) noexcept {
+        arena = std::move(other.arena);
+        root = other.root;
+        other.root = nullptr;
+        return *this;
+    }
+    IExpression *get() const { return root; }
+    IExpression *operator->() const { return root; }
+    explicit operator bool() const { return root != nullptr; }
+    const Arena &memory() const { return arena; }
+};
+
+class HashConsingFactory;
+
 class Parser {
-    Tokenizer *tokenizer;
-    Token currentToken;
-    int getPrecedence(const Token &token);
-    IExpression *parseExpression(int precedence = 0);
+    ViewTokenizer *tokenizer = nullptr;
+    TokenView currentToken;
+    Arena *arena = nullptr;  // nodes go to the heap when not set
+    VariableTable *variables = nullptr;  // identifiers are rejected when not set
+    HashConsingFactory *dagFactory = nullptr;  // overrides arena when set
+    bool realLiterals = false;
+    bool bigLiterals = false;
+    Error lastError;
+    EXPR_STATS_ONLY(stats::ParseCounters counters;)
+    // Shunting-yard stacks, kept across parses so their capacity is reused.
+    std::vector<IExpression *> operands;
+    // LPAREN entries mark open groups; an ID entry right below one is the
+    // function applied to the group, its Operator stored in number.
+    std::vector<TokenView> operators;
+    int getPrecedence(const TokenView &token);
+    IExpression *parseExpression();
+    bool reduce();
     IExpression *parsePrimary();
-    IExpression *parseParentheses();
-    IExpression *parseNumber(const Token &token);
-    IExpression *parseOperator(const Token &opToken, IExpression *left, IExpression *right);
+    IExpression *parseNumber(const TokenView &token);
+    IExpression *parseVariable(const TokenView &token);
+    IExpression *parseOperator(const TokenView &opToken, IExpression *left, IExpression *right);
     void advance();
+    IExpression *fail(ErrorCode code, const TokenView &token);
+    IExpression *makeNumber(int64_t value);
+    IExpression *makeReal(double value);
+    IExpression *makeBigNumber(std::string_view digits);
+    IExpression *makeVariable(size_t slot);
+    IExpression *makeBinary(Operator op, IExpression *left, IExpression *right);
+    IExpression *makeUnary(Operator op, IExpression *arg);
+    std::string_view text(const TokenView &token) const { return tokenizer->text(token); }
+    IExpression *parseInput(std::string_view input);
 public:
-    Parser() {
-        currentToken = Token("", Token::Type::END);
-    }
+    Parser() = default;
+
+    // Identifiers parse to VariableNodes bound to slots of this table.
+    void setVariables(VariableTable *table) { variables = table; }
+    // Builds nodes through the factory, so repeated subexpressions are
+    // shared; the factory's arena owns them.
+    void setFactory(HashConsingFactory *factory) { dagFactory = factory; }
+    // Accepts literals with a fractional part, such as 1.5, instead of
+    // failing with NON_INTEGER_LITERAL. Only evaluateAs<Float64> sees their
+    // exact value; getValue(), compiled programs and the other backends
+    // truncate them toward zero.
+    void setRealLiterals(bool enabled) { realLiterals = enabled; }
+    // Accepts integer literals beyond int64_t, such as 1e30, instead of
+    // failing with NUMBER_OUT_OF_RANGE. They become BigNumberNodes: exact
+    // in evaluateAs<BigInteger>, out of range in every other mode.
+    void setBigLiterals(bool enabled) { bigLiterals = enabled; }
 
-    IExpression *parse(std::string input);
+    // The parse functions return nullptr on failure; error() says why.
+    // They never write to stderr.
+    IExpression *parse(std::string_view input);
+    // Allocates every node of the tree in the given arena.
+    IExpression *parse(std::string_view input, Arena &arena);
+    // Same as above, with the arena owned by the returned handle.
+    ParsedExpression parseInArena(std::string_view input);
+    // Arena parse returning the error, with its offset in input, in place
+    // of nullptr.
+    Result<IExpression *> tryParse(std::string_view input, Arena &arena);
+    // Why the last parse failed; code is NONE after a successful one.
+    const Error &error() const { return lastError; }
 };
 
 #endif  //  PARSER_H_
@@ -0,0 +1,23 @@
+#include "result.h"
+
+const char *errorMessage(ErrorCode code) {
+    switch (code) {
+    case ErrorCode::NONE: return "No error";
+    case ErrorCode::EMPTY_INPUT: return "Input is empty";
+    case ErrorCode::INVALID_CHARACTER: return "Invalid character";
+    case ErrorCode::EXPECTED_OPERAND: return "Expected a number, name or '('";
+    case ErrorCode::EXPECTED_RPAREN: return "Expected ')'";
+    case ErrorCode::UNEXPECTED_TOKEN: return "Unexpected token";
+    case ErrorCode::UNKNOWN_FUNCTION: return "Unknown function";
+    case ErrorCode::IDENTIFIERS_DISABLED: return "Identifiers are not supported";
+    case ErrorCode::NON_INTEGER_LITERAL: return "Non-integer literal";
+    case ErrorCode::NUMBER_OUT_OF_RANGE: return "Number out of range";
+    case ErrorCode::DIVIDE_BY_ZERO: return "Divide by zero";
+    case ErrorCode::DIVIDE_OVERFLOW: return "Division overflow";
+    case ErrorCode::DOMAIN_ERROR: return "Invalid function argument";
+    case ErrorCode::MALFORMED_PROGRAM: return "Malformed program";
+    case ErrorCode::MALFORMED_REQUEST: return "Malformed request";
+    case ErrorCode::UNKNOWN_FORMULA: return "Unknown formula";
+    }
+    return "Unknown error";
+}
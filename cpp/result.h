@@ -0,0 +1,64 @@
+#ifndef RESULT_H_
+#define RESULT_H_
+
+#include<cstdint>
+
+// Exception-free error reporting. The try* entry points (tokenizing,
+// parsing, evaluation) return a Result instead of printing or throwing, so
+// a batch with many bad rows pays for a branch per row, not for an unwind
+// and an iostream write.
+enum class ErrorCode : uint8_t {
+    NONE,
+    // Tokenizing and parsing.
+    EMPTY_INPUT,
+    INVALID_CHARACTER,
+    EXPECTED_OPERAND,
+    EXPECTED_RPAREN,
+    UNEXPECTED_TOKEN,
+    UNKNOWN_FUNCTION,
+    IDENTIFIERS_DISABLED,
+    NON_INTEGER_LITERAL,
+    NUMBER_OUT_OF_RANGE,
+    // Evaluation.
+    DIVIDE_BY_ZERO,
+    DIVIDE_OVERFLOW,
+    DOMAIN_ERROR,
+    MALFORMED_PROGRAM,
+    // Evaluation server requests.
+    MALFORMED_REQUEST,
+    UNKNOWN_FORMULA,
+};
+
+// Static, human readable text for a code.
+const char *errorMessage(ErrorCode code);
+
+struct Error {
+    static constexpr uint32_t kNoOffset = UINT32_MAX;
+    ErrorCode code = ErrorCode::NONE;
+    // Span of the offending text in the input. Evaluation errors have no
+    // source position, since trees do not keep one: offset is kNoOffset.
+    uint32_t offset = kNoOffset;
+    uint32_t length = 0;
+
+    const char *message() const { return errorMessage(code); }
+};
+
+// Either a value or an Error, in the spirit of std::expected. T must be
+// cheap to default construct and copy.
+template<typename T>
+class Result {
+    T val{};
+    Error err;
+public:
+    Result(T value) : val(value) {}
+    Result(Error error) : err(error) {}
+
+    bool ok() const { return err.code == ErrorCode::NONE; }
+    explicit operator bool() const { return ok(); }
+    // Meaningful only when ok().
+    const T &value() const { return val; }
+    const T &operator*() const { return val; }
+    const Error &error() const { return err; }
+};
+
+#endif  // RESULT_H_
@@ -0,0 +1,148 @@
+#include <cstring>
+#include <iterator>
+
+#include "result_cache.h"
+
+namespace {
+
+// Estimated allocator and container overhead per entry: the list node
+// links and the hash map node and bucket.
+constexpr size_t kNodeOverhead = 64;
+
+uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+}  // namespace
+
+bool ResultCache::Key::operator==(const Key &other) const {
+    // values may be null when count is 0, which memcmp does not allow.
+    return hash == other.hash && expression == other.expression && count == other.count &&
+           (count == 0 || std::memcmp(values, other.values, count * sizeof(int64_t)) == 0);
+}
+
+void ResultCache::Stats::print(std::ostream &os) const {
+    os << "result cache: entries: " << entries << ", bytes: " << bytes
+       << ", hits: " << hits << ", misses: " << misses
+       << ", hit rate: " << hitRate() << ", evictions: " << evictions;
+}
+
+ResultCache::ResultCache(const Options &options) : policy(options.eviction) {
+    shardCount = 1;
+    while (shardCount < options.shards) shardCount <<= 1;
+    shardBudget = options.budgetBytes / shardCount;
+    shards.reset(new Shard[shardCount]);
+    for (size_t i = 0; i < shardCount; ++i) shards[i].hand = shards[i].entries.end();
+}
+
+ResultCache::Key ResultCache::makeKey(uint64_t expression, const int64_t *values, size_t count) {
+    uint64_t h = mix(expression ^ (uint64_t(count) << 48));
+    for (size_t i = 0; i < count; ++i) {
+        h = (h ^ static_cast<uint64_t>(values[i])) * 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 29;
+    }
+    return {mix(h), expression, values, count};
+}
+
+bool ResultCache::lookup(uint64_t expression, const int64_t *values, size_t count, Result<int64_t> &result) {
+    return find(makeKey(expression, values, count), result);
+}
+
+void ResultCache::insert(uint64_t expression, const int64_t *values, size_t count,
+                         const Result<int64_t> &result) {
+    store(makeKey(expression, values, count), result);
+}
+
+bool ResultCache::find(const Key &key, Result<int64_t> &result) {
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        ++shard.counters.misses;
+        return false;
+    }
+    ++shard.counters.hits;
+    result = it->second->result;
+    if (policy == Eviction::LRU) {
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    } else {
+        it->second->referenced = true;
+    }
+    return true;
+}
+
+void ResultCache::store(const Key &key, const Result<int64_t> &result) {
+    size_t bytes = sizeof(Entry) + key.count * sizeof(int64_t) + kNodeOverhead;
+    if (bytes > shardBudget) return;
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) {
+        // Another thread evaluated the same key first.
+        found->second->result = result;
+        return;
+    }
+    while (shard.bytes + bytes > shardBudget) evictOne(shard);
+
+    // LRU inserts at the front; CLOCK just behind the hand, so a new entry
+    // is the last one the sweep reaches.
+    std::unique_ptr<int64_t[]> values(new int64_t[key.count ? key.count : 1]);
+    if (key.count) std::memcpy(values.get(), key.values, key.count * sizeof(int64_t));
+    Key stored = key;
+    stored.values = values.get();
+    auto it = shard.entries.insert(policy == Eviction::LRU ? shard.entries.begin() : shard.hand,
+                                   Entry{stored, std::move(values), result, bytes});
+    shard.index.emplace(stored, it);
+    shard.bytes += bytes;
+    ++shard.counters.insertions;
+}
+
+void ResultCache::evictOne(Shard &shard) {
+    auto victim = std::prev(shard.entries.end());
+    if (policy == Eviction::CLOCK) {
+        // Give every referenced entry a second chance; ends within one
+        // full turn since each visit clears a bit.
+        if (shard.hand == shard.entries.end()) shard.hand = shard.entries.begin();
+        while (shard.hand->referenced) {
+            shard.hand->referenced = false;
+            if (++shard.hand == shard.entries.end()) shard.hand = shard.entries.begin();
+        }
+        victim = shard.hand;
+    }
+    shard.index.erase(victim->key);
+    shard.bytes -= victim->bytes;
+    auto next = shard.entries.erase(victim);
+    if (policy == Eviction::CLOCK) shard.hand = next;
+    ++shard.counters.evictions;
+}
+
+ResultCache::Stats ResultCache::stats() const {
+    Stats total;
+    for (size_t i = 0; i < shardCount; ++i) {
+        const Shard &shard = shards[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total.hits += shard.counters.hits;
+        total.misses += shard.counters.misses;
+        total.insertions += shard.counters.insertions;
+        total.evictions += shard.counters.evictions;
+        total.entries += shard.index.size();
+        total.bytes += shard.bytes;
+    }
+    return total;
+}
+
+void ResultCache::clear() {
+    for (size_t i = 0; i < shardCount; ++i) {
+        Shard &shard = shards[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.index.clear();
+        shard.entries.clear();
+        shard.hand = shard.entries.end();
+        shard.bytes = 0;
+    }
+}
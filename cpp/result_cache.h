@@ -0,0 +1,121 @@
+#ifndef RESULT_CACHE_H_
+#define RESULT_CACHE_H_
+
+#include<cstdint>
+#include<iostream>
+#include<list>
+#include<memory>
+#include<mutex>
+#include<unordered_map>
+
+#include "expression_id.h"
+#include "result.h"
+
+// Bounded, thread-safe memo of evaluation results keyed by an expression
+// id (see newExpressionIds) and the values bound to its variable slots.
+// A hit costs one hash of the values and a lookup in one shard; no tree
+// or program is run. Errors are cached like values, since evaluation is
+// deterministic.
+//
+// The key set is split over independently locked shards by hash, and each
+// shard evicts within its share of the memory budget. Lookups compare the
+// full binding values, so hash collisions cannot return a wrong result.
+class ResultCache {
+public:
+    enum class Eviction {
+        LRU,    // a hit moves the entry to the front
+        CLOCK,  // a hit only sets a reference bit; cheaper under hot keys
+    };
+
+    struct Options {
+        size_t budgetBytes = 64 << 20;
+        size_t shards = 16;         // rounded up to a power of two
+        Eviction eviction = Eviction::LRU;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        size_t bytes = 0;           // charged against the budget
+
+        double hitRate() const { return hits + misses ? double(hits) / double(hits + misses) : 0; }
+        void print(std::ostream &os) const;
+    };
+
+    ResultCache() : ResultCache(Options()) {}
+    explicit ResultCache(const Options &options);
+    ResultCache(const ResultCache &) = delete;
+    ResultCache &operator=(const ResultCache &) = delete;
+
+    // The cached result for the expression with slot i bound to values[i],
+    // or false. Counts a hit or a miss.
+    bool lookup(uint64_t expression, const int64_t *values, size_t count, Result<int64_t> &result);
+    // Stores a result, evicting as needed; entries larger than a shard's
+    // budget are not stored.
+    void insert(uint64_t expression, const int64_t *values, size_t count, const Result<int64_t> &result);
+    // lookup(), falling back to compute() and inserting what it returns.
+    template<typename Compute>
+    Result<int64_t> evaluate(uint64_t expression, const int64_t *values, size_t count, Compute &&compute);
+
+    Stats stats() const;
+    void clear();
+    size_t budget() const { return shardBudget * shardCount; }
+    Eviction eviction() const { return policy; }
+
+private:
+    // Points at the caller's values for lookups and at the entry's own
+    // copy once stored.
+    struct Key {
+        uint64_t hash;
+        uint64_t expression;
+        const int64_t *values;
+        size_t count;
+        bool operator==(const Key &other) const;
+    };
+    struct KeyHash {
+        size_t operator()(const Key &key) const { return key.hash; }
+    };
+    struct Entry {
+        Key key;
+        std::unique_ptr<int64_t[]> values;
+        Result<int64_t> result;
+        size_t bytes;
+        bool referenced = false;
+    };
+    // Padded so that two shards' locks never share a cache line.
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> entries;   // LRU: most recent first; CLOCK: ring
+        std::list<Entry>::iterator hand;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+        size_t bytes = 0;
+        Stats counters;
+    };
+
+    Eviction policy;
+    size_t shardCount;
+    size_t shardBudget;
+    std::unique_ptr<Shard[]> shards;
+
+    static Key makeKey(uint64_t expression, const int64_t *values, size_t count);
+    Shard &shardFor(const Key &key) { return shards[key.hash >> 32 & (shardCount - 1)]; }
+    bool find(const Key &key, Result<int64_t> &result);
+    void store(const Key &key, const Result<int64_t> &result);
+    void evictOne(Shard &shard);
+};
+
+template<typename Compute>
+Result<int64_t> ResultCache::evaluate(uint64_t expression, const int64_t *values, size_t count,
+                                      Compute &&compute) {
+    Key key = makeKey(expression, values, count);
+    Result<int64_t> result(int64_t(0));
+    if (find(key, result)) return result;
+    result = compute();
+    store(key, result);
+    return result;
+}
+
+#endif  // RESULT_CACHE_H_
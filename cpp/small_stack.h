@@ -0,0 +1,30 @@
+#ifndef SMALL_STACK_H_
+#define SMALL_STACK_H_
+
+#include<cstddef>
+#include<vector>
+
+// LIFO with N inline slots that spills to the heap once they run out, so
+// shallow traversals stay allocation-free while deep ones are bounded by
+// memory instead of by the native stack.
+template<typename T, size_t N>
+class SmallStack {
+    T slots[N];
+    std::vector<T> spill;
+    size_t count = 0;
+public:
+    void push(const T &value) {
+        if (count < N) slots[count] = value;
+        else spill.push_back(value);
+        ++count;
+    }
+    T &top() { return count <= N ? slots[count - 1] : spill.back(); }
+    void pop() {
+        if (count > N) spill.pop_back();
+        --count;
+    }
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+};
+
+#endif  // SMALL_STACK_H_
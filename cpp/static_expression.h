@@ -0,0 +1,321 @@
+#ifndef STATIC_EXPRESSION_H_
+#define STATIC_EXPRESSION_H_
+
+#include<algorithm>
+#include<cstdint>
+#include<stdexcept>
+#include<string_view>
+#include<type_traits>
+
+#include "expression.h"
+#include "bytecode.h"
+#include "functions.h"
+
+// Compile-time front ends for formulas that are fixed in source. Neither
+// parses at runtime nor touches the heap, and both can be evaluated in
+// constexpr contexts; a divide by zero or INT64_MIN / -1 there is a
+// compile error, at runtime it throws like BinaryNode::getValue().
+
+constexpr int64_t applyStatic(Operator op, int64_t left, int64_t right) {
+    switch (op) {
+    case Operator::ADD: return wrappingAdd(left, right);
+    case Operator::SUB: return wrappingSub(left, right);
+    case Operator::MUL: return wrappingMul(left, right);
+    case Operator::DIV:
+        if (right == 0) throw std::runtime_error("Divide by zero");
+        if (left == INT64_MIN && right == -1) throw std::overflow_error("Division overflow");
+        return left / right;
+    default:
+        throw std::runtime_error("Unknown operator");
+    }
+}
+
+// Built-in functions with the semantics of applyFunction(). sqrt and abs
+// are computed here so they fold at compile time; sin and cos go through
+// std::sin and std::cos, which are not constexpr, so they only evaluate at
+// runtime.
+constexpr int64_t callStatic(Operator fn, int64_t x) {
+    switch (fn) {
+    case Operator::SQRT: {
+        if (x < 0) throw std::runtime_error("Invalid argument to sqrt");
+        // Digit-by-digit integer square root, exact for every int64.
+        uint64_t v = static_cast<uint64_t>(x), root = 0, bit = uint64_t(1) << 62;
+        while (bit > v) bit >>= 2;
+        for (; bit; bit >>= 2) {
+            if (v >= root + bit) {
+                v -= root + bit;
+                root = (root >> 1) + bit;
+            } else {
+                root >>= 1;
+            }
+        }
+        return static_cast<int64_t>(root);
+    }
+    case Operator::ABS:
+        return x < 0 ? static_cast<int64_t>(0 - static_cast<uint64_t>(x)) : x;
+    default:
+        return applyFunction(fn, x);
+    }
+}
+
+// Expression templates: the whole formula is encoded in the type, so
+// evaluate() inlines to straight-line arithmetic.
+//
+//   constexpr auto f = (num<3> + var<0>) * num<2>;
+//   int64_t v = f(values);   // values[0] bound to var<0>
+
+template<int64_t Value>
+struct StaticNumber {
+    static constexpr int64_t evaluate(const int64_t * = nullptr) { return Value; }
+    constexpr int64_t operator()(const int64_t *vars = nullptr) const { return evaluate(vars); }
+};
+
+template<size_t Slot>
+struct StaticVariable {
+    static constexpr int64_t evaluate(const int64_t *vars) { return vars[Slot]; }
+    constexpr int64_t operator()(const int64_t *vars) const { return evaluate(vars); }
+};
+
+template<Operator Op, typename Left, typename Right>
+struct StaticBinary {
+    static constexpr int64_t evaluate(const int64_t *vars = nullptr) {
+        return applyStatic(Op, Left::evaluate(vars), Right::evaluate(vars));
+    }
+    constexpr int64_t operator()(const int64_t *vars = nullptr) const { return evaluate(vars); }
+};
+
+template<int64_t Value> constexpr StaticNumber<Value> num{};
+template<size_t Slot> constexpr StaticVariable<Slot> var{};
+
+template<typename T> struct IsStaticExpression : std::false_type {};
+template<int64_t V> struct IsStaticExpression<StaticNumber<V>> : std::true_type {};
+template<size_t S> struct IsStaticExpression<StaticVariable<S>> : std::true_type {};
+template<Operator Op, typename L, typename R>
+struct IsStaticExpression<StaticBinary<Op, L, R>> : std::true_type {};
+
+template<typename L, typename R>
+using EnableStatic = std::enable_if_t<IsStaticExpression<L>::value && IsStaticExpression<R>::value>;
+
+template<typename L, typename R, typename = EnableStatic<L, R>>
+constexpr StaticBinary<Operator::ADD, L, R> operator+(L, R) { return {}; }
+template<typename L, typename R, typename = EnableStatic<L, R>>
+constexpr StaticBinary<Operator::SUB, L, R> operator-(L, R) { return {}; }
+template<typename L, typename R, typename = EnableStatic<L, R>>
+constexpr StaticBinary<Operator::MUL, L, R> operator*(L, R) { return {}; }
+template<typename L, typename R, typename = EnableStatic<L, R>>
+constexpr StaticBinary<Operator::DIV, L, R> operator/(L, R) { return {}; }
+
+// constexpr parser over a string literal. Accepts the same grammar as
+// Parser (integer, decimal and exponent literals with an integer value,
+// identifiers, + - * /, parentheses, left associative, and calls of the
+// built-in functions) and compiles it into a fixed-capacity postfix
+// program. Variables get slots in order of first appearance, exactly as a
+// VariableTable handed to Parser would assign them.
+//
+//   constexpr StaticProgram<> f("x * 3 + y / 2");
+//   static_assert(f.slot("y") == 1);
+//   int64_t v = f.evaluate(values);
+template<size_t MaxInstructions = 64, size_t MaxVariables = 8>
+class StaticProgram {
+    Instruction code[MaxInstructions] = {};
+    size_t length = 0;
+    size_t depth = 0;
+    size_t maxDepth = 0;
+    std::string_view names[MaxVariables] = {};
+    size_t variableCount = 0;
+
+    // Parsing state, only meaningful inside the constructor.
+    std::string_view text;
+    size_t pos = 0;
+
+    static constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+    static constexpr bool isAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+    static constexpr bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+    constexpr void skipSpace() {
+        while (pos < text.size() && isSpace(text[pos])) ++pos;
+    }
+    constexpr char peek() {
+        skipSpace();
+        return pos < text.size() ? text[pos] : '\0';
+    }
+    constexpr void emit(OpCode op, int64_t operand = 0) {
+        if (length == MaxInstructions) throw std::length_error("Expression too long");
+        code[length++] = Instruction{op, operand};
+        if (op == OpCode::PUSH || op == OpCode::LOAD) {
+            if (++depth > maxDepth) maxDepth = depth;
+        } else if (op != OpCode::CALL) {
+            --depth;
+        }
+    }
+    constexpr size_t declare(std::string_view name) {
+        for (size_t i = 0; i < variableCount; ++i) {
+            if (names[i] == name) return i;
+        }
+        if (variableCount == MaxVariables) throw std::length_error("Too many variables");
+        names[variableCount] = name;
+        return variableCount++;
+    }
+    static constexpr int precedence(char c) {
+        return (c == '+' || c == '-') ? 1 : (c == '*' || c == '/') ? 2 : 0;
+    }
+    static constexpr OpCode opcode(char c) {
+        return c == '+' ? OpCode::ADD : c == '-' ? OpCode::SUB : c == '*' ? OpCode::MUL : OpCode::DIV;
+    }
+
+    constexpr size_t skipDigits(size_t from) const {
+        while (from < text.size() && isDigit(text[from])) ++from;
+        return from;
+    }
+    static constexpr int64_t accumulate(int64_t value, std::string_view digits) {
+        for (char d : digits) {
+            int digit = d - '0';
+            if (value > (INT64_MAX - digit) / 10) throw std::out_of_range("Number out of range");
+            value = value * 10 + digit;
+        }
+        return value;
+    }
+
+    // Same literal syntax and exactness rules as lexNumber: "1.5e3" is
+    // 1500, "1.25" is rejected.
+    constexpr int64_t number() {
+        size_t intEnd = skipDigits(pos);
+        size_t fracBegin = intEnd, fracEnd = intEnd;
+        if (intEnd < text.size() && text[intEnd] == '.') {
+            fracBegin = intEnd + 1;
+            fracEnd = skipDigits(fracBegin);
+        }
+        size_t end = fracEnd;
+        int64_t exponent = 0;
+        if (end < text.size() && (text[end] == 'e' || text[end] == 'E')) {
+            size_t q = end + 1;
+            bool negative = q < text.size() && text[q] == '-';
+            if (q < text.size() && (text[q] == '-' || text[q] == '+')) ++q;
+            if (q < text.size() && isDigit(text[q])) {
+                end = skipDigits(q);
+                // Saturated: any larger exponent overflows or leaves a fraction.
+                for (; q < end; ++q) exponent = std::min<int64_t>(exponent * 10 + (text[q] - '0'), 100000);
+                if (negative) exponent = -exponent;
+            }
+        }
+        std::string_view intDigits = text.substr(pos, intEnd - pos);
+        std::string_view fracDigits = text.substr(fracBegin, fracEnd - fracBegin);
+        pos = end;
+
+        while (!fracDigits.empty() && fracDigits.back() == '0') fracDigits.remove_suffix(1);
+        int64_t scale = exponent - static_cast<int64_t>(fracDigits.size());
+        if (fracDigits.empty()) {
+            while (!intDigits.empty() && intDigits.back() == '0') {
+                intDigits.remove_suffix(1);
+                ++scale;
+            }
+        }
+        while (!intDigits.empty() && intDigits.front() == '0') intDigits.remove_prefix(1);
+        if (intDigits.empty() && fracDigits.empty()) return 0;
+        if (scale < 0) throw std::invalid_argument("Non-integer literal");
+        int64_t value = accumulate(accumulate(0, intDigits), fracDigits);
+        for (int64_t i = 0; i < scale; ++i) {
+            if (value > INT64_MAX / 10) throw std::out_of_range("Number out of range");
+            value *= 10;
+        }
+        return value;
+    }
+
+    static constexpr Operator function(std::string_view name) {
+        if (name == "sqrt") return Operator::SQRT;
+        if (name == "abs") return Operator::ABS;
+        if (name == "sin") return Operator::SIN;
+        if (name == "cos") return Operator::COS;
+        throw std::invalid_argument("Unknown function");
+    }
+
+    constexpr void group() {
+        ++pos;
+        expression(0);
+        if (peek() != ')') throw std::invalid_argument("Expected ')'");
+        ++pos;
+    }
+
+    constexpr void primary() {
+        char c = peek();
+        if (isDigit(c)) {
+            emit(OpCode::PUSH, number());
+        } else if (isAlpha(c)) {
+            size_t start = pos;
+            while (pos < text.size() && (isAlpha(text[pos]) || isDigit(text[pos]))) ++pos;
+            std::string_view name = text.substr(start, pos - start);
+            if (peek() == '(') {
+                // Like Parser, a name followed by '(' is always a call.
+                Operator fn = function(name);
+                group();
+                emit(OpCode::CALL, static_cast<int64_t>(fn));
+            } else {
+                emit(OpCode::LOAD, static_cast<int64_t>(declare(name)));
+            }
+        } else if (c == '(') {
+            group();
+        } else {
+            throw std::invalid_argument("Unexpected token");
+        }
+    }
+
+    // Precedence climbing, mirroring Parser::parseExpression.
+    constexpr void expression(int minPrecedence) {
+        primary();
+        while (true) {
+            char c = peek();
+            int p = precedence(c);
+            if (p <= minPrecedence) break;
+            ++pos;
+            expression(p);
+            emit(opcode(c));
+        }
+    }
+
+public:
+    constexpr explicit StaticProgram(std::string_view source) : text(source) {
+        expression(0);
+        if (peek() != '\0') throw std::invalid_argument("Unexpected trailing input");
+        text = std::string_view();
+    }
+
+    constexpr int64_t evaluate(const int64_t *vars = nullptr) const {
+        int64_t stack[MaxInstructions] = {};
+        size_t sp = 0;
+        for (size_t i = 0; i < length; ++i) {
+            const Instruction &ins = code[i];
+            switch (ins.op) {
+            case OpCode::PUSH: stack[sp++] = ins.operand; break;
+            case OpCode::LOAD: stack[sp++] = vars[ins.operand]; break;
+            case OpCode::ADD: --sp; stack[sp - 1] = applyStatic(Operator::ADD, stack[sp - 1], stack[sp]); break;
+            case OpCode::SUB: --sp; stack[sp - 1] = applyStatic(Operator::SUB, stack[sp - 1], stack[sp]); break;
+            case OpCode::MUL: --sp; stack[sp - 1] = applyStatic(Operator::MUL, stack[sp - 1], stack[sp]); break;
+            case OpCode::DIV: --sp; stack[sp - 1] = applyStatic(Operator::DIV, stack[sp - 1], stack[sp]); break;
+            case OpCode::CALL:
+                stack[sp - 1] = callStatic(static_cast<Operator>(ins.operand), stack[sp - 1]);
+                break;
+            }
+        }
+        return stack[0];
+    }
+    constexpr int64_t operator()(const int64_t *vars = nullptr) const { return evaluate(vars); }
+
+    // Slot of a variable, or VariableTable::npos if not used.
+    constexpr size_t slot(std::string_view name) const {
+        for (size_t i = 0; i < variableCount; ++i) {
+            if (names[i] == name) return i;
+        }
+        return VariableTable::npos;
+    }
+    constexpr size_t variables() const { return variableCount; }
+    constexpr size_t size() const { return length; }
+    constexpr size_t stackDepth() const { return maxDepth; }
+};
+
+// Evaluates a constant formula; use in a constexpr context to fold it at
+// compile time: constexpr int64_t v = evaluateStatic("(3+4)*(2-1)");
+constexpr int64_t evaluateStatic(std::string_view text) {
+    return StaticProgram<>(text).evaluate();
+}
+
+#endif  // STATIC_EXPRESSION_H_
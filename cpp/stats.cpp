@@ -0,0 +1,117 @@
+#include <iomanip>
+
+#include "stats.h"
+#include "expression.h"
+#include "small_stack.h"
+
+namespace stats {
+
+namespace {
+Histogram histograms[static_cast<int>(Metric::METRIC_COUNT)];
+}
+
+const char *name(Metric metric) {
+    switch (metric) {
+    case Metric::TOKENIZE_NS: return "tokenize_ns";
+    case Metric::PARSE_NS: return "parse_ns";
+    case Metric::EVALUATE_NS: return "evaluate_ns";
+    case Metric::TOKENS: return "tokens";
+    case Metric::NODES: return "nodes";
+    case Metric::ALLOCATIONS: return "allocations";
+    case Metric::DEPTH: return "depth";
+    default: return "?";
+    }
+}
+
+void Histogram::record(uint64_t value) {
+    buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t seen = largest.load(std::memory_order_relaxed);
+    while (value > seen &&
+           !largest.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::reset() {
+    for (auto &b : buckets) b.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    largest.store(0, std::memory_order_relaxed);
+}
+
+double Histogram::mean() const {
+    uint64_t n = count();
+    return n ? double(sum.load(std::memory_order_relaxed)) / double(n) : 0.0;
+}
+
+uint64_t Histogram::percentile(double q) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * double(n - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += bucket(i);
+        if (seen >= rank) {
+            if (i == 0) return 0;
+            uint64_t upper = i == 64 ? UINT64_MAX : (uint64_t(1) << i) - 1;
+            return upper < max() ? upper : max();
+        }
+    }
+    return max();
+}
+
+Histogram &histogram(Metric metric) {
+    return histograms[static_cast<int>(metric)];
+}
+
+void reset() {
+    for (auto &h : histograms) h.reset();
+}
+
+void dump(std::ostream &os) {
+    if (!kEnabled) {
+        os << "statistics are not compiled in; rebuild with make STATS=1\n";
+        return;
+    }
+    for (int m = 0; m < static_cast<int>(Metric::METRIC_COUNT); ++m) {
+        const Histogram &h = histograms[m];
+        if (h.count() == 0) continue;
+        os << std::left << std::setw(12) << name(static_cast<Metric>(m))
+           << " count " << h.count()
+           << " mean " << std::fixed << std::setprecision(1) << h.mean()
+           << " p50 " << h.percentile(0.5)
+           << " p99 " << h.percentile(0.99)
+           << " max " << h.max() << "\n";
+        for (int i = 0; i < Histogram::kBuckets; ++i) {
+            if (!h.bucket(i)) continue;
+            uint64_t low = i == 0 ? 0 : uint64_t(1) << (i - 1);
+            os << "    >= " << std::setw(12) << low << " " << h.bucket(i) << "\n";
+        }
+    }
+}
+
+uint64_t treeDepth(const IExpression *expr) {
+    if (!expr) return 0;
+    struct Item {
+        const IExpression *node;
+        uint64_t depth;
+    };
+    SmallStack<Item, 32> stack;
+    stack.push({expr, 1});
+    uint64_t deepest = 0;
+    while (!stack.empty()) {
+        Item item = stack.top();
+        stack.pop();
+        if (item.depth > deepest) deepest = item.depth;
+        if (const BinaryNode *binary = item.node->asBinary()) {
+            stack.push({binary->left, item.depth + 1});
+            stack.push({binary->right, item.depth + 1});
+        } else if (const UnaryFunctionNode *unary = item.node->asUnary()) {
+            stack.push({unary->arg, item.depth + 1});
+        }
+    }
+    return deepest;
+}
+
+}  // namespace stats
@@ -0,0 +1,102 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+#include<atomic>
+#include<chrono>
+#include<cstdint>
+#include<iostream>
+
+// Opt-in instrumentation of parsing and evaluation. Build with -DEXPR_STATS
+// (make STATS=1) to record; otherwise the recording macros expand to
+// nothing and the histograms stay empty.
+#ifdef EXPR_STATS
+#define EXPR_STATS_RECORD(metric, value) ::stats::histogram(metric).record(value)
+#define EXPR_STATS_TIMER(name, metric) ::stats::ScopedTimer name(metric)
+#define EXPR_STATS_ONLY(...) __VA_ARGS__
+#else
+#define EXPR_STATS_RECORD(metric, value) ((void)0)
+#define EXPR_STATS_TIMER(name, metric) ((void)0)
+#define EXPR_STATS_ONLY(...)
+#endif
+
+class IExpression;
+
+namespace stats {
+
+#ifdef EXPR_STATS
+constexpr bool kEnabled = true;
+#else
+constexpr bool kEnabled = false;
+#endif
+
+enum class Metric {
+    TOKENIZE_NS,    // time spent inside the tokenizer during one parse
+    PARSE_NS,       // whole Parser::parse call, tokenizing included
+    EVALUATE_NS,    // one tree or bytecode evaluation
+    TOKENS,         // tokens consumed per parse
+    NODES,          // nodes built per parse
+    ALLOCATIONS,    // heap allocations per parse (nodes or arena blocks)
+    DEPTH,          // depth of each parsed tree
+    METRIC_COUNT
+};
+
+const char *name(Metric metric);
+
+// Lock-free histogram with power-of-two buckets: bucket 0 holds zeros and
+// bucket i holds values in [2^(i-1), 2^i). Safe to record from any thread.
+class Histogram {
+public:
+    static constexpr int kBuckets = 65;
+private:
+    std::atomic<uint64_t> buckets[kBuckets] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> largest{0};
+public:
+    static int bucketOf(uint64_t value) {
+        return value == 0 ? 0 : 64 - __builtin_clzll(value);
+    }
+    void record(uint64_t value);
+    void reset();
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t bucket(int i) const { return buckets[i].load(std::memory_order_relaxed); }
+    uint64_t max() const { return largest.load(std::memory_order_relaxed); }
+    double mean() const;
+    // Upper bound of the bucket containing the q-quantile, 0 <= q <= 1.
+    uint64_t percentile(double q) const;
+};
+
+// Per-parse counters the parser accumulates before recording them.
+struct ParseCounters {
+    uint64_t tokens = 0;
+    uint64_t nodes = 0;
+    uint64_t allocations = 0;
+    uint64_t tokenizeNs = 0;
+};
+
+Histogram &histogram(Metric metric);
+void reset();
+// Aggregated report of every non-empty metric: count, mean, p50, p99, max
+// and the bucket distribution.
+void dump(std::ostream &os);
+
+// Depth of the tree, computed without recursion; a single leaf is 1.
+uint64_t treeDepth(const IExpression *expr);
+
+class ScopedTimer {
+    Metric metric;
+    std::chrono::steady_clock::time_point start;
+public:
+    explicit ScopedTimer(Metric metric)
+        : metric(metric), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        histogram(metric).record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+};
+
+}  // namespace stats
+
+#endif  // STATS_H_
@@ -0,0 +1,145 @@
+#include <exception>
+
+#include "thread_pool.h"
+
+namespace {
+// The pool and worker index of the current thread, when it is a worker.
+thread_local const ThreadPool *currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+}
+
+struct ThreadPool::Job {
+    const std::function<void(size_t, size_t)> *body;
+    size_t pending = 0;  // guarded by mutex
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable done;
+};
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) threadCount = 1;
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        threads.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &t : threads) t.join();
+}
+
+bool ThreadPool::popLocal(size_t self, Task &task) {
+    Worker &w = *workers[self];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (w.tasks.empty()) return false;
+    task = w.tasks.back();
+    w.tasks.pop_back();
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ThreadPool::steal(size_t self, Task &task) {
+    for (size_t k = 1; k < workers.size(); ++k) {
+        Worker &victim = *workers[(self + k) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        task = victim.tasks.front();
+        victim.tasks.pop_front();
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(const Task &task) {
+    Job *job = task.job;
+    if (!job->failed.load(std::memory_order_relaxed)) {
+        try {
+            (*job->body)(task.begin, task.end);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(job->mutex);
+            if (!job->error) job->error = std::current_exception();
+            job->failed.store(true, std::memory_order_relaxed);
+        }
+    }
+    // Decrement under the job's lock: the waiting caller destroys the job as
+    // soon as it observes zero, so nothing may touch it after the unlock.
+    std::lock_guard<std::mutex> lock(job->mutex);
+    if (--job->pending == 0) job->done.notify_all();
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    currentPool = this;
+    currentWorker = self;
+    Task task;
+    while (true) {
+        if (popLocal(self, task) || steal(self, task)) {
+            run(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this] {
+            return stopping || queued.load(std::memory_order_relaxed) > 0;
+        });
+        if (stopping && queued.load(std::memory_order_relaxed) == 0) return;
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain,
+                             const std::function<void(size_t, size_t)> &body) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+    size_t chunks = (count + grain - 1) / grain;
+
+    Job job;
+    job.body = &body;
+    job.pending = chunks;
+
+    // Hand each worker a contiguous run of chunks; stealing evens out the rest.
+    size_t n = workers.size();
+    for (size_t w = 0; w < n; ++w) {
+        size_t first = chunks * w / n, last = chunks * (w + 1) / n;
+        if (first == last) continue;
+        std::lock_guard<std::mutex> lock(workers[w]->mutex);
+        for (size_t c = first; c < last; ++c) {
+            size_t begin = c * grain;
+            size_t end = begin + grain < count ? begin + grain : count;
+            workers[w]->tasks.push_back(Task{&job, begin, end});
+        }
+        queued.fetch_add(last - first, std::memory_order_relaxed);
+    }
+    {
+        // Taking the lock orders the queued update before any sleeper's check.
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeUp.notify_all();
+
+    if (currentPool == this) {
+        // Called from inside a body: this worker would otherwise sleep on
+        // chunks that may sit in its own deque, so it runs queued work
+        // until its job is done. Whatever is left is already running
+        // elsewhere and will finish without it.
+        size_t self = currentWorker;
+        Task task;
+        while (popLocal(self, task) || steal(self, task)) {
+            run(task);
+            std::lock_guard<std::mutex> lock(job.mutex);
+            if (job.pending == 0) break;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(job.mutex);
+    job.done.wait(lock, [&job] { return job.pending == 0; });
+    if (job.error) std::rethrow_exception(job.error);
+}
@@ -0,0 +1,61 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include<atomic>
+#include<condition_variable>
+#include<deque>
+#include<functional>
+#include<memory>
+#include<mutex>
+#include<thread>
+#include<vector>
+
+// Fixed set of worker threads, each with its own task deque. A worker
+// takes work from the back of its own deque and, once that is empty,
+// steals from the front of the others, so uneven chunks balance out
+// without a shared queue becoming the bottleneck.
+class ThreadPool {
+    struct Job;
+    struct Task {
+        Job *job;
+        size_t begin;
+        size_t end;
+    };
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<size_t> queued{0};
+    bool stopping = false;
+
+    bool popLocal(size_t self, Task &task);
+    bool steal(size_t self, Task &task);
+    void run(const Task &task);
+    void workerLoop(size_t self);
+
+public:
+    // Zero threads means one per hardware thread.
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t size() const { return threads.size(); }
+
+    // Calls body(begin, end) for consecutive ranges of at most `grain`
+    // indices covering [0, count), spread across the workers, and blocks
+    // until all of them finished. If a call throws, ranges not yet started
+    // are skipped and the first exception is rethrown here. May be called
+    // from inside a body: the calling worker then runs queued ranges,
+    // its own or any other job's, while it waits, so nesting cannot
+    // deadlock even on a one-thread pool.
+    void parallelFor(size_t count, size_t grain,
+                     const std::function<void(size_t, size_t)> &body);
+};
+
+#endif  // THREAD_POOL_H_
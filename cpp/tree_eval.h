@@ -0,0 +1,102 @@
+#ifndef TREE_EVAL_H_
+#define TREE_EVAL_H_
+
+#include "expression.h"
+#include "small_stack.h"
+
+// Post-order evaluation with an explicit stack, shared by getValue() and
+// the numeric modes, so machine-generated trees that are tens of thousands
+// of levels deep do not overflow the native stack. Only operators and
+// function calls are pushed; the walk runs down each left spine and
+// completes parents as their right operands arrive.
+//
+// Mode provides Value, apply(op, lhs, rhs) and call(fn, x); leaf(node)
+// returns the value of a node that is neither an operator nor a call.
+template<typename Mode, typename Leaf>
+typename Mode::Value evaluateIteratively(const IExpression *root, Leaf &&leaf) {
+    using Value = typename Mode::Value;
+    enum class Pending : unsigned char { LEFT, RIGHT, ARGUMENT };
+    struct Frame {
+        const IExpression *node;
+        Value lhs;
+        Pending pending;
+    };
+    SmallStack<Frame, 32> stack;
+    const IExpression *node = root;
+    for (;;) {
+        // Descend to the leftmost leaf below node.
+        for (;;) {
+            if (const BinaryNode *binary = node->asBinary()) {
+                stack.push({binary, Value(), Pending::LEFT});
+                node = binary->left;
+            } else if (const UnaryFunctionNode *unary = node->asUnary()) {
+                stack.push({unary, Value(), Pending::ARGUMENT});
+                node = unary->arg;
+            } else {
+                break;
+            }
+        }
+        Value value = leaf(node);
+        // Hand the value up until a parent still needs its right operand.
+        for (;;) {
+            if (stack.empty()) return value;
+            Frame &frame = stack.top();
+            if (frame.pending == Pending::LEFT) {
+                frame.lhs = std::move(value);
+                frame.pending = Pending::RIGHT;
+                node = static_cast<const BinaryNode *>(frame.node)->right;
+                break;
+            }
+            if (frame.pending == Pending::RIGHT) {
+                value = Mode::apply(static_cast<const BinaryNode *>(frame.node)->op, frame.lhs, value);
+            } else {
+                value = Mode::call(static_cast<const UnaryFunctionNode *>(frame.node)->op, value);
+            }
+            stack.pop();
+        }
+    }
+}
+
+// Post-order walk with an explicit stack for passes that build something
+// from a tree rather than compute a value: leave(node) runs once all of
+// the node's operands have been left, so a visitor called from it sees
+// its children's results already produced. enter(node) runs on the way
+// down; returning false skips the node and everything below it, which
+// lets a pass over a DAG handle a shared subtree once.
+template<typename Enter, typename Leave>
+void walkPostOrder(const IExpression *root, Enter &&enter, Leave &&leave) {
+    struct Frame {
+        const IExpression *node;
+        unsigned char next;  // operands entered so far
+    };
+    if (!root || !enter(root)) return;
+    SmallStack<Frame, 32> stack;
+    stack.push({root, 0});
+    while (!stack.empty()) {
+        Frame &frame = stack.top();
+        const IExpression *child = nullptr;
+        if (const BinaryNode *binary = frame.node->asBinary()) {
+            if (frame.next < 2) child = frame.next++ == 0 ? binary->left : binary->right;
+        } else if (const UnaryFunctionNode *unary = frame.node->asUnary()) {
+            if (frame.next < 1) {
+                ++frame.next;
+                child = unary->arg;
+            }
+        }
+        if (child) {
+            if (enter(child)) stack.push({child, 0});
+            continue;
+        }
+        const IExpression *node = frame.node;
+        stack.pop();
+        leave(node);
+    }
+}
+
+// walkPostOrder dispatching every node to a visitor.
+inline void acceptPostOrder(const IExpression *root, IVisitor *visitor) {
+    walkPostOrder(root, [](const IExpression *) { return true; },
+                  [visitor](const IExpression *node) { node->accept(visitor); });
+}
+
+#endif  // TREE_EVAL_H_
@@ -0,0 +1,25 @@
+#include "variables.h"
+
+// Expressions reference a handful of variables at most, so a linear scan
+// beats hashing here; this only runs while parsing.
+size_t VariableTable::find(std::string_view name) const {
+    for (size_t slot = 0; slot < names.size(); ++slot) {
+        if (names[slot] == name) return slot;
+    }
+    return npos;
+}
+
+size_t VariableTable::declare(std::string_view name) {
+    size_t slot = find(name);
+    if (slot != npos) return slot;
+    names.emplace_back(name);
+    values.push_back(0);
+    return names.size() - 1;
+}
+
+bool VariableTable::set(std::string_view name, int64_t value) {
+    size_t slot = find(name);
+    if (slot == npos) return false;
+    values[slot] = value;
+    return true;
+}
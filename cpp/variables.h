@@ -0,0 +1,31 @@
+#ifndef VARIABLES_H_
+#define VARIABLES_H_
+
+#include<cstdint>
+#include<string>
+#include<string_view>
+#include<vector>
+
+// Maps variable names to dense slot indices and holds the value bound to
+// each slot. Names are resolved once at parse time; evaluation only ever
+// indexes by slot.
+class VariableTable {
+    std::vector<std::string> names;
+    std::vector<int64_t> values;
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // Returns the slot of the variable, adding it (bound to 0) if new.
+    size_t declare(std::string_view name);
+    // Returns the slot of the variable or npos if it was never declared.
+    size_t find(std::string_view name) const;
+
+    const std::string &name(size_t slot) const { return names[slot]; }
+    int64_t get(size_t slot) const { return values[slot]; }
+    void set(size_t slot, int64_t value) { values[slot] = value; }
+    bool set(std::string_view name, int64_t value);
+    const int64_t *data() const { return values.data(); }
+    size_t size() const { return names.size(); }
+};
+
+#endif  // VARIABLES_H_
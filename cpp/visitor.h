@@ -3,6 +3,8 @@
 
 class NumberNode;
 class BinaryNode;
+class VariableNode;
+class UnaryFunctionNode;
 
 // visitor interface
 class IVisitor {
@@ -11,6 +13,8 @@ public:
     ~IVisitor() = default;
     virtual void visitNumberNode(const NumberNode *expr) = 0;
     virtual void visitBinaryNode(const BinaryNode *expr) = 0;
+    virtual void visitVariableNode(const VariableNode *expr) = 0;
+    virtual void visitUnaryFunctionNode(const UnaryFunctionNode *expr) = 0;
 };
 
 class NumberNodeVisitor : public IVisitor {